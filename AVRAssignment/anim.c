@@ -0,0 +1,397 @@
+/*
+ * anim.c
+ *
+ * Author: Riley Stewart
+ */
+
+#include "anim.h"
+#include <stdint.h>
+#include <stdbool.h>
+#include <avr/pgmspace.h>
+#include "ledmatrix.h"
+#include "game.h"
+#include "timer0.h"
+
+// Number of pixel animations that can run at once (a slide, and the burst
+// when the box lands on a target).
+#define MAX_ANIMATIONS	(2)
+
+// A burst lights rings of squares out to this distance from its centre,
+// one ring per frame.
+#define BURST_RADIUS	(2)
+#define COLOUR_BURST	(COLOUR_LIGHT_GREEN)
+
+// Time between banner columns, in milliseconds.
+#define BANNER_SCROLL_TIME	(120)
+
+// Macro for returning the number of elements in an array.
+#define countof(x) (sizeof(x) / sizeof((x)[0]))
+
+// Short colour definitions.
+#define G	(COLOUR_GREEN)
+#define O	(COLOUR_ORANGE)
+#define _	(COLOUR_BLACK)
+
+// Banner data, in the same form as the start screen animation data: the
+// 0th element is the left-most column, and each column lists the rows from
+// the bottom up.
+// "LEVEL CLEAR!"
+static const MatrixColumn banner_level_clear[] PROGMEM =
+{
+	{ _, _, G, G, G, G, G, _ },
+	{ _, _, G, _, _, _, _, _ },
+	{ _, _, G, _, _, _, _, _ },
+	{ _, _, _, _, _, _, _, _ },
+	{ _, _, G, G, G, G, G, _ },
+	{ _, _, G, _, G, _, G, _ },
+	{ _, _, G, _, _, _, G, _ },
+	{ _, _, _, _, _, _, _, _ },
+	{ _, _, _, G, G, G, G, _ },
+	{ _, _, G, _, _, _, _, _ },
+	{ _, _, _, G, G, G, G, _ },
+	{ _, _, _, _, _, _, _, _ },
+	{ _, _, G, G, G, G, G, _ },
+	{ _, _, G, _, G, _, G, _ },
+	{ _, _, G, _, _, _, G, _ },
+	{ _, _, _, _, _, _, _, _ },
+	{ _, _, G, G, G, G, G, _ },
+	{ _, _, G, _, _, _, _, _ },
+	{ _, _, G, _, _, _, _, _ },
+	{ _, _, _, _, _, _, _, _ },
+	{ _, _, _, _, _, _, _, _ },
+	{ _, _, _, _, _, _, _, _ },
+	{ _, _, _, _, _, _, _, _ },
+	{ _, _, _, G, G, G, _, _ },
+	{ _, _, G, _, _, _, G, _ },
+	{ _, _, G, _, _, _, G, _ },
+	{ _, _, _, _, _, _, _, _ },
+	{ _, _, G, G, G, G, G, _ },
+	{ _, _, G, _, _, _, _, _ },
+	{ _, _, G, _, _, _, _, _ },
+	{ _, _, _, _, _, _, _, _ },
+	{ _, _, G, G, G, G, G, _ },
+	{ _, _, G, _, G, _, G, _ },
+	{ _, _, G, _, _, _, G, _ },
+	{ _, _, _, _, _, _, _, _ },
+	{ _, _, G, G, G, G, _, _ },
+	{ _, _, _, _, G, _, G, _ },
+	{ _, _, G, G, G, G, _, _ },
+	{ _, _, _, _, _, _, _, _ },
+	{ _, _, G, G, G, G, G, _ },
+	{ _, _, _, _, G, _, G, _ },
+	{ _, _, G, G, _, G, _, _ },
+	{ _, _, _, _, _, _, _, _ },
+	{ _, _, G, _, G, G, G, _ }
+};
+
+// "YOU WIN!"
+static const MatrixColumn banner_you_win[] PROGMEM =
+{
+	{ _, _, _, _, _, O, O, _ },
+	{ _, _, O, O, O, _, _, _ },
+	{ _, _, _, _, _, O, O, _ },
+	{ _, _, _, _, _, _, _, _ },
+	{ _, _, _, O, O, O, _, _ },
+	{ _, _, O, _, _, _, O, _ },
+	{ _, _, _, O, O, O, _, _ },
+	{ _, _, _, _, _, _, _, _ },
+	{ _, _, O, O, O, O, O, _ },
+	{ _, _, O, _, _, _, _, _ },
+	{ _, _, O, O, O, O, O, _ },
+	{ _, _, _, _, _, _, _, _ },
+	{ _, _, _, _, _, _, _, _ },
+	{ _, _, _, _, _, _, _, _ },
+	{ _, _, _, _, _, _, _, _ },
+	{ _, _, O, O, O, O, O, _ },
+	{ _, _, _, O, _, _, _, _ },
+	{ _, _, _, _, O, _, _, _ },
+	{ _, _, _, O, _, _, _, _ },
+	{ _, _, O, O, O, O, O, _ },
+	{ _, _, _, _, _, _, _, _ },
+	{ _, _, O, _, _, _, O, _ },
+	{ _, _, O, O, O, O, O, _ },
+	{ _, _, O, _, _, _, O, _ },
+	{ _, _, _, _, _, _, _, _ },
+	{ _, _, O, O, O, O, O, _ },
+	{ _, _, _, _, _, O, _, _ },
+	{ _, _, _, _, O, _, _, _ },
+	{ _, _, O, O, O, O, O, _ },
+	{ _, _, _, _, _, _, _, _ },
+	{ _, _, O, _, O, O, O, _ }
+};
+// Undefine the short colour definitions.
+#undef G
+#undef O
+#undef _
+
+typedef struct
+{
+	const MatrixColumn *columns;
+	uint8_t length;
+} BannerData;
+
+static const BannerData banner_table[] PROGMEM =
+{
+	{ banner_level_clear, countof(banner_level_clear) },
+	{ banner_you_win, countof(banner_you_win) }
+};
+
+typedef enum
+{
+	ANIM_NONE,
+	ANIM_SLIDE,
+	ANIM_BURST
+} AnimType;
+
+typedef struct
+{
+	uint8_t type;
+	uint8_t frame;		// Frames drawn so far (including any delay)
+	uint8_t delay;		// Frames to wait before the first change
+	uint8_t row;		// Slide destination, or burst centre
+	uint8_t col;
+	uint8_t from_row;	// Slide source
+	uint8_t from_col;
+	PixelColour start[2];	// Slide colours at frame 0 (source, destination)
+	PixelColour shown[2];	// Slide colours last sent (source, destination)
+} Animation;
+
+static Animation animations[MAX_ANIMATIONS];
+static uint32_t last_frame_time;
+
+// The banner being scrolled (length 0 if none), and the next column of it
+// to scroll on. Columns past the end of the banner are blank, so the banner
+// scrolls fully off the matrix before it repeats.
+static BannerData banner;
+static uint8_t next_column;
+static uint32_t last_scroll_time;
+
+// Mixes two colours: frame 0 gives start, frame == frames gives end. Green
+// and red are mixed separately (4 bits each, green in the high bits).
+static PixelColour blend(PixelColour start, PixelColour end, uint8_t frame,
+	uint8_t frames)
+{
+	int16_t green = (start >> 4)
+		+ ((int16_t)((end >> 4) - (start >> 4)) * frame) / frames;
+	int16_t red = (start & 0x0F)
+		+ ((int16_t)((end & 0x0F) - (start & 0x0F)) * frame) / frames;
+	return (PixelColour)((green << 4) | red);
+}
+
+// Draws one of the two squares of a slide, if its colour has changed. The
+// square a box slides out of is where the player has just stepped, which is
+// left to flash_player().
+static void draw_slide_square(Animation *anim, uint8_t square, uint8_t row,
+	uint8_t col)
+{
+	if (is_player_at(row, col))
+	{
+		return;
+	}
+	PixelColour colour = blend(anim->start[square], square_colour(row, col),
+		anim->frame, ANIM_SLIDE_FRAMES);
+	if (colour != anim->shown[square])
+	{
+		ledmatrix_update_pixel(row, col, colour);
+		anim->shown[square] = colour;
+	}
+}
+
+// Lights (or restores) the ring of squares at a distance from the centre of
+// a burst. Only empty squares are lit, apart from the centre itself, and the
+// player's square is left to flash_player() so the player never disappears.
+static void draw_ring(Animation *anim, uint8_t radius, bool lit)
+{
+	for (int8_t delta_row = -radius; delta_row <= radius; delta_row++)
+	{
+		for (int8_t delta_col = -radius; delta_col <= radius; delta_col++)
+		{
+			if (delta_row != -radius && delta_row != radius
+				&& delta_col != -radius && delta_col != radius)
+			{
+				continue;
+			}
+			uint8_t row = WRAP_ROW(anim->row + delta_row);
+			uint8_t col = WRAP_COL(anim->col + delta_col);
+			if (is_player_at(row, col))
+			{
+				continue;
+			}
+			PixelColour background = square_colour(row, col);
+			if (radius == 0 || background == COLOUR_BLACK)
+			{
+				ledmatrix_update_pixel(row, col,
+					lit ? COLOUR_BURST : background);
+			}
+		}
+	}
+}
+
+// Draws the next frame of an animation. Returns whether there are more
+// frames to come.
+static bool draw_frame(Animation *anim)
+{
+	anim->frame++;
+	if (anim->type == ANIM_SLIDE)
+	{
+		draw_slide_square(anim, 0, anim->from_row, anim->from_col);
+		draw_slide_square(anim, 1, anim->row, anim->col);
+		return anim->frame < ANIM_SLIDE_FRAMES;
+	}
+	if (anim->frame <= anim->delay)
+	{
+		return true;
+	}
+	// Burst frame n lights ring n - 1 and puts back ring n - 2.
+	uint8_t ring = anim->frame - anim->delay - 1;
+	if (ring > 0)
+	{
+		draw_ring(anim, ring - 1, false);
+	}
+	if (ring <= BURST_RADIUS)
+	{
+		draw_ring(anim, ring, true);
+	}
+	return ring <= BURST_RADIUS;
+}
+
+// Draws the last frame of an animation.
+static void finish_animation(Animation *anim)
+{
+	if (anim->type == ANIM_SLIDE)
+	{
+		anim->frame = ANIM_SLIDE_FRAMES - 1;
+		draw_frame(anim);
+	}
+	else if (anim->type == ANIM_BURST && anim->frame > anim->delay)
+	{
+		uint8_t ring = anim->frame - anim->delay - 1;
+		if (ring <= BURST_RADIUS)
+		{
+			draw_ring(anim, ring, false);
+		}
+	}
+	anim->type = ANIM_NONE;
+}
+
+// Finds a free animation slot, finishing the oldest animation if needed.
+static Animation *new_animation(AnimType type)
+{
+	Animation *anim = &animations[0];
+	bool running = false;
+	for (uint8_t i = 0; i < MAX_ANIMATIONS; i++)
+	{
+		if (animations[i].type == ANIM_NONE)
+		{
+			anim = &animations[i];
+		}
+		else
+		{
+			running = true;
+		}
+	}
+	if (anim->type != ANIM_NONE)
+	{
+		finish_animation(anim);
+	}
+	if (!running)
+	{
+		// Nothing else is running, so time the frames from now.
+		last_frame_time = get_current_time();
+	}
+	anim->type = type;
+	anim->frame = 0;
+	anim->delay = 0;
+	return anim;
+}
+
+// Scrolls the banner one column to the left, in the same way as the start
+// screen. Shifting the display costs two bytes over SPI, so only the new
+// right-hand column is sent.
+static void scroll_banner(void)
+{
+	MatrixColumn column_data;
+	ledmatrix_shift_display_left();
+	if (next_column < banner.length)
+	{
+		memcpy_P(column_data, &banner.columns[next_column],
+			sizeof(column_data));
+	}
+	else
+	{
+		set_matrix_column_to_colour(column_data, COLOUR_BLACK);
+	}
+	ledmatrix_update_column(MATRIX_NUM_COLUMNS - 1, column_data);
+	next_column++;
+	if (next_column == banner.length + MATRIX_NUM_COLUMNS)
+	{
+		next_column = 0;
+	}
+}
+
+void anim_update(void)
+{
+	uint32_t time = get_current_time();
+	if (banner.length && time >= last_scroll_time + BANNER_SCROLL_TIME)
+	{
+		scroll_banner();
+		last_scroll_time = time;
+	}
+	if (time < last_frame_time + ANIM_FRAME_TIME)
+	{
+		return;
+	}
+	last_frame_time = time;
+	for (uint8_t i = 0; i < MAX_ANIMATIONS; i++)
+	{
+		if (animations[i].type != ANIM_NONE && !draw_frame(&animations[i]))
+		{
+			animations[i].type = ANIM_NONE;
+		}
+	}
+}
+
+void anim_finish(void)
+{
+	for (uint8_t i = 0; i < MAX_ANIMATIONS; i++)
+	{
+		finish_animation(&animations[i]);
+	}
+}
+
+void anim_cancel(void)
+{
+	for (uint8_t i = 0; i < MAX_ANIMATIONS; i++)
+	{
+		animations[i].type = ANIM_NONE;
+	}
+	banner.length = 0;
+}
+
+void anim_slide(uint8_t from_row, uint8_t from_col, uint8_t to_row,
+	uint8_t to_col, PixelColour from_colour, PixelColour to_colour)
+{
+	Animation *anim = new_animation(ANIM_SLIDE);
+	anim->from_row = from_row;
+	anim->from_col = from_col;
+	anim->row = to_row;
+	anim->col = to_col;
+	anim->start[0] = anim->shown[0] = from_colour;
+	anim->start[1] = anim->shown[1] = to_colour;
+}
+
+void anim_burst(uint8_t row, uint8_t col, uint8_t delay)
+{
+	Animation *anim = new_animation(ANIM_BURST);
+	anim->row = row;
+	anim->col = col;
+	anim->delay = delay;
+}
+
+void anim_start_banner(Banner banner_number)
+{
+	anim_finish();
+	memcpy_P(&banner, &banner_table[banner_number], sizeof(banner));
+	next_column = 0;
+	last_scroll_time = get_current_time();
+}
\ No newline at end of file
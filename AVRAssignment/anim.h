@@ -0,0 +1,84 @@
+/*
+ * anim.h
+ *
+ * Author: Riley Stewart
+ *
+ * LED matrix animations. Animations are drawn a frame at a time by
+ * anim_update(), which must be called often from the main loop. Each frame
+ * only sends the pixels whose colour has changed since the last frame.
+ *
+ * Pixel animations (box slides and target bursts) draw over the game board,
+ * and read the board's colours with square_colour() so they always finish
+ * on what the board currently shows. Banners scroll across the whole
+ * matrix in the same way as the start screen.
+ */
+
+#ifndef ANIM_H_
+#define ANIM_H_
+
+#include <stdint.h>
+#include "pixel_colour.h"
+
+// Time between animation frames, in milliseconds.
+#define ANIM_FRAME_TIME		(40)
+
+// Number of frames a box takes to slide from one square to the next.
+#define ANIM_SLIDE_FRAMES	(4)
+
+// Banners that can be scrolled across the LED matrix.
+typedef enum
+{
+	BANNER_LEVEL_CLEAR,
+	BANNER_YOU_WIN
+} Banner;
+
+/// <summary>
+/// Draws the next frame of every running animation, if it is due. This
+/// must be called frequently (e.g. every time around the main loop).
+/// </summary>
+void anim_update(void);
+
+/// <summary>
+/// Jumps every pixel animation to its last frame and stops it. This should
+/// be called before the board changes (e.g. on new input), so that the
+/// display matches the board again.
+/// </summary>
+void anim_finish(void);
+
+/// <summary>
+/// Stops every animation, including banners, without drawing anything more.
+/// Use this when the whole LED matrix is about to be redrawn.
+/// </summary>
+void anim_cancel(void);
+
+/// <summary>
+/// Starts a box sliding from one square to a neighbouring square. Each
+/// square fades from the colour given to the colour the board now has.
+/// </summary>
+/// <param name="from_row">The row the box is leaving.</param>
+/// <param name="from_col">The column the box is leaving.</param>
+/// <param name="to_row">The row the box is moving to.</param>
+/// <param name="to_col">The column the box is moving to.</param>
+/// <param name="from_colour">The colour shown on the square being left.</param>
+/// <param name="to_colour">The colour shown on the square moved to.</param>
+void anim_slide(uint8_t from_row, uint8_t from_col, uint8_t to_row,
+	uint8_t to_col, PixelColour from_colour, PixelColour to_colour);
+
+/// <summary>
+/// Starts a burst of light spreading out from a square, over the empty
+/// squares around it.
+/// </summary>
+/// <param name="row">The row at the centre of the burst.</param>
+/// <param name="col">The column at the centre of the burst.</param>
+/// <param name="delay">Number of frames to wait before starting.</param>
+void anim_burst(uint8_t row, uint8_t col, uint8_t delay);
+
+/// <summary>
+/// Starts scrolling a banner across the LED matrix, from right to left. The
+/// banner repeats until anim_cancel() is called. Any pixel animations are
+/// finished first.
+/// </summary>
+/// <param name="banner">The banner to show.</param>
+void anim_start_banner(Banner banner);
+
+#endif /* ANIM_H_ */
\ No newline at end of file
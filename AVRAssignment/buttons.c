@@ -21,9 +21,9 @@ static volatile uint8_t last_button_state;
 // short. In most uses it will never have more than 1 element at a time.
 // This button queue can be changed by the interrupt handler below so we
 // should turn off interrupts if we're changing the queue outside the handler.
-#define BUTTON_QUEUE_SIZE 4
 static volatile uint8_t button_queue[BUTTON_QUEUE_SIZE];
 static volatile uint8_t queue_length;
+static volatile uint8_t queue_peak;
 
 void init_buttons(void)
 {
@@ -94,6 +94,16 @@ void clear_button_presses(void)
 	}
 }
 
+uint8_t button_queue_used(void)
+{
+	return queue_length;
+}
+
+uint8_t button_queue_peak(void)
+{
+	return queue_peak;
+}
+
 // Interrupt handler for a change on buttons.
 ISR(PCINT1_vect)
 {
@@ -115,6 +125,10 @@ ISR(PCINT1_vect)
 			// Add the button push to the queue (and update the
 			// length of the queue).
 			button_queue[queue_length++] = pin;
+			if (queue_length > queue_peak)
+			{
+				queue_peak = queue_length;
+			}
 		}
 	}
 	
@@ -15,6 +15,9 @@
 // Number of buttons.
 #define NUM_BUTTONS 4
 
+// Maximum number of button pushes waiting to be read.
+#define BUTTON_QUEUE_SIZE 4
+
 // Button states.
 typedef enum
 {
@@ -47,4 +50,17 @@ ButtonState button_pushed(void);
 /// </summary>
 void clear_button_presses(void);
 
+/// <summary>
+/// Gets the number of button pushes waiting in the queue.
+/// </summary>
+/// <returns>Number of queued button pushes.</returns>
+uint8_t button_queue_used(void);
+
+/// <summary>
+/// Gets the largest number of button pushes that have been waiting in the
+/// queue at once.
+/// </summary>
+/// <returns>Peak queue length.</returns>
+uint8_t button_queue_peak(void);
+
 #endif /* BUTTONS_H_ */
@@ -7,73 +7,81 @@
 #include "buzzer.h"
 #define F_CPU 8000000UL	// 8MHz
 #include <avr/io.h>
-#include <util/delay.h>
+#include <avr/pgmspace.h>
 #include <stdint.h>
 #include <stdbool.h>
 
+// Timer/counter 2 settings for one note
+typedef struct {
+	uint8_t top;			// OCR2A, one less than the period in timer counts
+	uint8_t pulse;			// OCR2B, one less than the pulse width in timer counts
+	uint8_t clock_select;	// CS22:0 bits of TCCR2B
+} NoteTiming;
 
-// For a given frequency (Hz), return the clock period (in terms of the
-// number of clock cycles of a 1MHz clock)
-uint16_t freq_to_clock_period(uint16_t freq) {
-	return (1000000UL / freq);	// UL makes the constant an unsigned long (32 bits)
-	// and ensures we do 32 bit arithmetic, not 16
-}
+// The number of timer counts in one period of a frequency (Hz), with the
+// timer counting at F_CPU / divider. Rounded to the nearest count.
+#define NOTE_COUNTS(hz, divider)	((F_CPU / (divider) + (hz) / 2) / (hz))
+#define NOTE_FITS(hz, divider)		(NOTE_COUNTS(hz, divider) <= 256)
 
-// Return the width of a pulse (in clock cycles) given a duty cycle (%) and
-// the period of the clock (measured in clock cycles)
-uint16_t duty_cycle_to_pulse_width(float dutycycle, uint16_t clockperiod) {
-	return (dutycycle * clockperiod) / 100;
-}
+// The smallest of timer/counter 2's clock dividers that lets a period fit in
+// the 8 bit counter, for the finest resolution.
+#define NOTE_DIVIDER(hz) (NOTE_FITS(hz, 1) ? 1 : NOTE_FITS(hz, 8) ? 8 \
+	: NOTE_FITS(hz, 32) ? 32 : NOTE_FITS(hz, 64) ? 64 \
+	: NOTE_FITS(hz, 128) ? 128 : NOTE_FITS(hz, 256) ? 256 : 1024)
+#define NOTE_CLOCK_SELECT(divider) ((divider) == 1 ? 1 : (divider) == 8 ? 2 \
+	: (divider) == 32 ? 3 : (divider) == 64 ? 4 : (divider) == 128 ? 5 \
+	: (divider) == 256 ? 6 : 7)
 
-void init_buzzer(void) {
-	uint16_t freq = 2000;	// Hz
-	float dutycycle = 2;	// %
-	uint16_t clockperiod = freq_to_clock_period(freq);
-	uint16_t pulsewidth = duty_cycle_to_pulse_width(dutycycle, clockperiod);
+// The pulse width in timer counts for the buzzer's duty cycle, at least one.
+#define NOTE_PULSE(counts) ((counts) * BUZZER_DUTY_NUMERATOR \
+	/ BUZZER_DUTY_DENOMINATOR > 0 ? (counts) * BUZZER_DUTY_NUMERATOR \
+	/ BUZZER_DUTY_DENOMINATOR : 1)
 
-	// Make pin OC2B be an output
-	//DDRD = (1 << 6);
-	//Done by project.c
+#define NOTE_HZ(hz) { \
+	NOTE_COUNTS(hz, NOTE_DIVIDER(hz)) - 1, \
+	NOTE_PULSE(NOTE_COUNTS(hz, NOTE_DIVIDER(hz))) - 1, \
+	NOTE_CLOCK_SELECT(NOTE_DIVIDER(hz)) }
 
-	// Set the maximum count value for timer/counter 2 to be one less than the clockperiod
-	OCR2A = 0;
+// Equal temperament, A4 = 440Hz, indexed by note number
+static const NoteTiming note_table[NUM_NOTES] PROGMEM = {
+	NOTE_HZ(262), NOTE_HZ(277), NOTE_HZ(294), NOTE_HZ(311), NOTE_HZ(330), NOTE_HZ(349),
+	NOTE_HZ(370), NOTE_HZ(392), NOTE_HZ(415), NOTE_HZ(440), NOTE_HZ(466), NOTE_HZ(494),
+	NOTE_HZ(523), NOTE_HZ(554), NOTE_HZ(587), NOTE_HZ(622), NOTE_HZ(659), NOTE_HZ(698),
+	NOTE_HZ(740), NOTE_HZ(784), NOTE_HZ(831), NOTE_HZ(880), NOTE_HZ(932), NOTE_HZ(988),
+	NOTE_HZ(1047), NOTE_HZ(1109), NOTE_HZ(1175), NOTE_HZ(1245), NOTE_HZ(1319), NOTE_HZ(1397),
+	NOTE_HZ(1480), NOTE_HZ(1568), NOTE_HZ(1661), NOTE_HZ(1760), NOTE_HZ(1865), NOTE_HZ(1976),
+	NOTE_HZ(2093), NOTE_HZ(2217), NOTE_HZ(2349), NOTE_HZ(2489), NOTE_HZ(2637), NOTE_HZ(2794),
+	NOTE_HZ(2960), NOTE_HZ(3136), NOTE_HZ(3322), NOTE_HZ(3520), NOTE_HZ(3729), NOTE_HZ(3951),
+	NOTE_HZ(4186), NOTE_HZ(4435), NOTE_HZ(4699), NOTE_HZ(4978), NOTE_HZ(5274), NOTE_HZ(5588),
+	NOTE_HZ(5920), NOTE_HZ(6272), NOTE_HZ(6645), NOTE_HZ(7040), NOTE_HZ(7459), NOTE_HZ(7902)
+};
+
+void init_buzzer(void) {
+	// Make pin OC2B be an output
+	DDRD |= (1 << 6);
 
 	// Set up timer/counter 2 for Fast PWM, counting from 0 to the value in OCR2A
-	// before reseting to 0. Count at 1MHz (CLK/8).
-	// Configure output OC2B to be clear on compare match and set on timer/counter
-	// overflow (non-inverting mode).
-	TCCR2A = (1 << COM2A1) | (1 << COM2B1) | (1 << WGM21) | (1 << WGM20);
-	TCCR2B = (1 << WGM22) | (1 << CS21);
+	// before reseting to 0. The clock is stopped and OC2B disconnected until a
+	// note is played.
+	TCCR2A = (1 << WGM21) | (1 << WGM20);
+	TCCR2B = (1 << WGM22);
 }
 
-void play_move_sound(bool enabled) {
-	if (enabled) {
-		OCR2A = freq_to_clock_period(2000);
-		_delay_ms(80);
-		OCR2A = 0;
-	}
-}
+void buzzer_play_note(uint8_t note) {
+	const NoteTiming *timing = &note_table[note];
+
+	// OCR2A and OCR2B are double buffered in PWM modes, so a note played
+	// while another is sounding takes over at the end of a period.
+	OCR2A = pgm_read_byte(&timing->top);
+	OCR2B = pgm_read_byte(&timing->pulse);
+	TCCR2B = (1 << WGM22) | pgm_read_byte(&timing->clock_select);
 
-void play_start_sound(bool enabled) {
-	if (enabled) {
-		OCR2A = freq_to_clock_period(2000);
-		_delay_ms(300);
-		OCR2A = freq_to_clock_period(400);
-		_delay_ms(300);
-		OCR2A = 0;
-	}
+	// Configure output OC2B to be clear on compare match and set on timer/counter
+	// overflow (non-inverting mode).
+	TCCR2A |= (1 << COM2B1);
 }
 
-void play_victory_sound(bool enabled) {
-	if (enabled) {
-		OCR2A = freq_to_clock_period(2000);
-		_delay_ms(300);
-		OCR2A = freq_to_clock_period(5000);
-		_delay_ms(300);
-		OCR2A = freq_to_clock_period(2000);
-		_delay_ms(300);
-		OCR2A = freq_to_clock_period(2500);
-		_delay_ms(300);
-		OCR2A = 0;
-	}
-}
\ No newline at end of file
+void buzzer_off(void) {
+	TCCR2A &= ~(1 << COM2B1);
+	TCCR2B = (1 << WGM22);
+}
@@ -2,14 +2,50 @@
  * buzzer.h
  *
  *  Author: Riley Stewart
+ *
+ * Buzzer on OC2B (pin D6), driven by timer/counter 2 in fast PWM mode.
+ * Notes are numbered in semitones from C4 (middle C) up to B8, and each
+ * note's timer settings are worked out at compile time, so playing a note
+ * is a table lookup and three register writes. Music and sound effects
+ * are played with music.h.
  */ 
 
-#include <stdbool.h>
+#ifndef BUZZER_H_
+#define BUZZER_H_
+
+#include <stdint.h>
+
+// Note numbers, in semitones from C4. S is sharp.
+enum
+{
+	NOTE_C4, NOTE_CS4, NOTE_D4, NOTE_DS4, NOTE_E4, NOTE_F4, NOTE_FS4, NOTE_G4, NOTE_GS4, NOTE_A4, NOTE_AS4, NOTE_B4,
+	NOTE_C5, NOTE_CS5, NOTE_D5, NOTE_DS5, NOTE_E5, NOTE_F5, NOTE_FS5, NOTE_G5, NOTE_GS5, NOTE_A5, NOTE_AS5, NOTE_B5,
+	NOTE_C6, NOTE_CS6, NOTE_D6, NOTE_DS6, NOTE_E6, NOTE_F6, NOTE_FS6, NOTE_G6, NOTE_GS6, NOTE_A6, NOTE_AS6, NOTE_B6,
+	NOTE_C7, NOTE_CS7, NOTE_D7, NOTE_DS7, NOTE_E7, NOTE_F7, NOTE_FS7, NOTE_G7, NOTE_GS7, NOTE_A7, NOTE_AS7, NOTE_B7,
+	NOTE_C8, NOTE_CS8, NOTE_D8, NOTE_DS8, NOTE_E8, NOTE_F8, NOTE_FS8, NOTE_G8, NOTE_GS8, NOTE_A8, NOTE_AS8, NOTE_B8,
+	NUM_NOTES
+};
+
+// The buzzer's duty cycle, as the fraction of each period the output is
+// high.
+#define BUZZER_DUTY_NUMERATOR	(2)
+#define BUZZER_DUTY_DENOMINATOR	(100)
 
+/// <summary>
+/// Sets up timer/counter 2 to drive the buzzer, silent.
+/// </summary>
 void init_buzzer(void);
 
-void play_move_sound(bool enabled);
+/// <summary>
+/// Starts playing a note, which carries on until another note is played or
+/// buzzer_off() is called.
+/// </summary>
+/// <param name="note">The note number (0 to NUM_NOTES - 1).</param>
+void buzzer_play_note(uint8_t note);
 
-void play_start_sound(bool enabled);
+/// <summary>
+/// Silences the buzzer.
+/// </summary>
+void buzzer_off(void);
 
-void play_victory_sound(bool enabled);
\ No newline at end of file
+#endif /* BUZZER_H_ */
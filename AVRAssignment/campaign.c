@@ -0,0 +1,128 @@
+/*
+ * campaign.c
+ *
+ * Author: Riley Stewart
+ */
+
+#include "campaign.h"
+#include <stdint.h>
+#include <stdbool.h>
+#include "levels.h"
+#include "levelstore.h"
+
+// One bit per level, so the level table can have at most 16 levels.
+_Static_assert(NUM_CAMPAIGN_LEVELS <= 16,
+	"unlocked_levels has one bit per level");
+
+// The current level, and a bit mask of unlocked levels (bit 0 is level 1).
+static uint8_t current_level = 1;
+static uint16_t unlocked_levels = 1;
+
+// Whether a race is being played, which locks the custom levels.
+static bool racing;
+
+void campaign_reset(void)
+{
+	current_level = 1;
+	unlocked_levels = 1;
+}
+
+void campaign_set_racing(bool race)
+{
+	racing = race;
+}
+
+uint8_t campaign_level(void)
+{
+	return current_level;
+}
+
+uint16_t campaign_par(void)
+{
+	return (current_level <= NUM_LEVELS) ? get_level_par(current_level) : 0;
+}
+
+uint16_t campaign_push_par(void)
+{
+	return (current_level <= NUM_LEVELS) ? get_level_push_par(current_level) : 0;
+}
+
+// Scales points by how close a count is to its par (never more than all
+// the points, even if par is somehow beaten).
+static uint16_t par_points(uint16_t points, uint16_t count, uint16_t par)
+{
+	if (count <= par)
+	{
+		return points;
+	}
+	return (uint32_t)points * par / count;
+}
+
+uint16_t campaign_score(uint16_t moves, uint16_t pushes, uint16_t seconds)
+{
+	if (current_level <= NUM_LEVELS)
+	{
+		return par_points(600, moves, get_level_par(current_level))
+			+ par_points(400, pushes, get_level_push_par(current_level));
+	}
+	uint16_t score = 0;
+	if (moves < 200)
+	{
+		score += 200 - moves;
+	}
+	if (seconds < 1200)
+	{
+		score += 1200 - seconds;
+	}
+	return score;
+}
+
+bool campaign_is_unlocked(uint8_t level)
+{
+	if (level > NUM_LEVELS && level <= NUM_CAMPAIGN_LEVELS)
+	{
+		return !racing && levelstore_exists(level - NUM_LEVELS - 1);
+	}
+	return level >= 1 && level <= NUM_LEVELS
+		&& (unlocked_levels & (1U << (level - 1)));
+}
+
+void campaign_complete_level(void)
+{
+	if (current_level < NUM_LEVELS)
+	{
+		unlocked_levels |= (1U << current_level);
+	}
+}
+
+bool campaign_select(uint8_t level)
+{
+	if (!campaign_is_unlocked(level))
+	{
+		return false;
+	}
+	current_level = level;
+	return true;
+}
+
+bool campaign_next(void)
+{
+	return campaign_select(current_level + 1);
+}
+
+bool campaign_previous(void)
+{
+	return campaign_select(current_level - 1);
+}
+
+void campaign_load(LevelLayout *layout)
+{
+	if (current_level > NUM_LEVELS)
+	{
+		levelstore_load(current_level - NUM_LEVELS - 1, layout);
+	}
+	else
+	{
+		decode_level(current_level, layout);
+	}
+}
@@ -0,0 +1,113 @@
+/*
+ * campaign.h
+ *
+ * Author: Riley Stewart
+ *
+ * Level progression. Keeps track of the current level and which levels have
+ * been unlocked, and loads the current level's layout.
+ *
+ * The levels in the level table are followed by the custom levels saved by
+ * the level editor: level NUM_LEVELS + 1 is custom level slot 0, and so on.
+ * A custom level is unlocked if its slot holds a level, and has no par. In a
+ * race the custom levels are locked, as the other board has no copy of them.
+ */
+
+#ifndef CAMPAIGN_H_
+#define CAMPAIGN_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "levels.h"
+#include "levelstore.h"
+
+// Number of levels, including the custom levels.
+#define NUM_CAMPAIGN_LEVELS	(NUM_LEVELS + LEVELSTORE_SLOTS)
+
+/// <summary>
+/// Restarts the campaign from level 1, with only level 1 unlocked.
+/// </summary>
+void campaign_reset(void);
+
+/// <summary>
+/// Locks or unlocks the custom levels for a race. The opponent can only
+/// decode the levels in the level table, so a race must not start a custom
+/// level.
+/// </summary>
+/// <param name="race">Whether a race is being played.</param>
+void campaign_set_racing(bool race);
+
+/// <summary>
+/// Gets the current level number.
+/// </summary>
+/// <returns>The current level (1 to NUM_CAMPAIGN_LEVELS).</returns>
+uint8_t campaign_level(void);
+
+/// <summary>
+/// Gets the par (target number of moves) for the current level.
+/// </summary>
+/// <returns>The par for the current level, or 0 for a custom level.</returns>
+uint16_t campaign_par(void);
+
+/// <summary>
+/// Gets the push par (target number of box pushes) for the current level.
+/// </summary>
+/// <returns>The push par for the current level, or 0 for a custom
+/// level.</returns>
+uint16_t campaign_push_par(void);
+
+/// <summary>
+/// Works out the score for solving the current level. For a level with a
+/// par, this is up to 600 points for the moves and 400 for the pushes, in
+/// proportion to how close they are to par, so the score is the same
+/// measure of play on easy and hard levels. A custom level has no par, and
+/// scores up to 200 points for moves under 200 and 1200 for seconds under
+/// 1200.
+/// </summary>
+/// <param name="moves">The number of moves made.</param>
+/// <param name="pushes">The number of box pushes made.</param>
+/// <param name="seconds">The time taken, in seconds.</param>
+/// <returns>The score.</returns>
+uint16_t campaign_score(uint16_t moves, uint16_t pushes, uint16_t seconds);
+
+/// <summary>
+/// Tests whether a level has been unlocked.
+/// </summary>
+/// <param name="level">The level number.</param>
+/// <returns>Whether the level exists and is unlocked.</returns>
+bool campaign_is_unlocked(uint8_t level);
+
+/// <summary>
+/// Marks the current level as completed. The following level is unlocked,
+/// ready for campaign_next().
+/// </summary>
+void campaign_complete_level(void);
+
+/// <summary>
+/// Selects a level to play, if it is unlocked.
+/// </summary>
+/// <param name="level">The level number.</param>
+/// <returns>Whether the level was selected.</returns>
+bool campaign_select(uint8_t level);
+
+/// <summary>
+/// Selects the next level, if it is unlocked.
+/// </summary>
+/// <returns>Whether the level was changed.</returns>
+bool campaign_next(void);
+
+/// <summary>
+/// Selects the previous level, if there is one.
+/// </summary>
+/// <returns>Whether the level was changed.</returns>
+bool campaign_previous(void);
+
+/// <summary>
+/// Loads the layout of the current level, decoding it from the level table
+/// or reading it from the EEPROM for a custom level. To start the level
+/// without a copy of the layout, load it into the game's own layout (see
+/// get_level_buffer() in game.h).
+/// </summary>
+/// <param name="layout">The layout to load the level into.</param>
+void campaign_load(LevelLayout *layout);
+
+#endif /* CAMPAIGN_H_ */
@@ -0,0 +1,257 @@
+/*
+ * editor.c
+ *
+ * Author: Riley Stewart
+ */
+
+#include "editor.h"
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include "game.h"
+#include "hint.h"
+#include "levels.h"
+#include "levelstore.h"
+
+_Static_assert(MATRIX_NUM_COLUMNS == 16, "Board rows are held in a uint16_t");
+
+// The objects editor_cycle() steps through, in order.
+static const uint8_t cycle_order[] = { ROOM, WALL, BOX, TARGET, BOX | TARGET };
+
+static uint8_t slot;
+static uint8_t cursor_row;
+static uint8_t cursor_col;
+static bool cursor_visible;
+static bool saved;
+static EditorStatus status = EDITOR_EDITING;
+
+void editor_start(uint8_t new_slot)
+{
+	// The level is loaded straight into the game's board, rather than into
+	// a copy on the stack while initialise_game() runs.
+	LevelLayout *layout = get_level_buffer();
+	slot = new_slot;
+	saved = levelstore_load(slot, layout);
+	if (!saved)
+	{
+		memset(layout->board, ROOM, sizeof(layout->board));
+		layout->player_row = MATRIX_NUM_ROWS / 2;
+		layout->player_col = MATRIX_NUM_COLUMNS / 2;
+	}
+	hint_cancel();
+	status = EDITOR_EDITING;
+	initialise_game(layout);
+	cursor_row = layout->player_row;
+	cursor_col = layout->player_col;
+	cursor_visible = false;
+}
+
+uint8_t editor_slot(void)
+{
+	return slot;
+}
+
+bool editor_is_saved(void)
+{
+	return saved;
+}
+
+// Notes that the level has changed, which stops any search for a solution
+// of the old level.
+static void level_changed(void)
+{
+	saved = false;
+	if (status == EDITOR_CHECKING)
+	{
+		hint_cancel();
+	}
+	status = EDITOR_EDITING;
+}
+
+void editor_move_cursor(int8_t delta_row, int8_t delta_col)
+{
+	paint_cursor(cursor_row, cursor_col, false);
+	cursor_row = WRAP_ROW(cursor_row + delta_row);
+	cursor_col = WRAP_COL(cursor_col + delta_col);
+	cursor_visible = true;
+	paint_cursor(cursor_row, cursor_col, true);
+}
+
+uint8_t editor_cursor(uint8_t *row, uint8_t *col)
+{
+	*row = cursor_row;
+	*col = cursor_col;
+	return get_square(cursor_row, cursor_col);
+}
+
+void editor_set(uint8_t object)
+{
+	edit_square(cursor_row, cursor_col, object);
+	cursor_visible = false;
+	level_changed();
+}
+
+void editor_cycle(void)
+{
+	uint8_t row;
+	uint8_t col;
+	uint8_t object = editor_cursor(&row, &col);
+	uint8_t next = 0;
+	for (uint8_t i = 0; i < sizeof(cycle_order); i++)
+	{
+		if (cycle_order[i] == object)
+		{
+			next = (i + 1) % sizeof(cycle_order);
+		}
+	}
+	editor_set(cycle_order[next]);
+}
+
+bool editor_place_player(void)
+{
+	uint8_t row;
+	uint8_t col;
+	if (editor_cursor(&row, &col) & (WALL | BOX))
+	{
+		return false;
+	}
+	edit_player(row, col);
+	level_changed();
+	return true;
+}
+
+void editor_flash_cursor(void)
+{
+	cursor_visible = !cursor_visible;
+	paint_cursor(cursor_row, cursor_col, cursor_visible);
+}
+
+// Finds the squares the player can walk to if boxes are ignored. Each pass
+// grows every row from the rows above and below it, then spreads it along
+// the row, as the hint search does.
+static void find_reach(const LevelLayout *state, uint16_t *reach)
+{
+	uint16_t open[MATRIX_NUM_ROWS];
+	for (uint8_t row = 0; row < MATRIX_NUM_ROWS; row++)
+	{
+		open[row] = 0;
+		reach[row] = 0;
+		for (uint8_t col = 0; col < MATRIX_NUM_COLUMNS; col++)
+		{
+			if (!(state->board[row][col] & WALL))
+			{
+				open[row] |= 1U << col;
+			}
+		}
+	}
+	reach[state->player_row] = 1U << state->player_col;
+	bool changed;
+	do
+	{
+		changed = false;
+		for (uint8_t row = 0; row < MATRIX_NUM_ROWS; row++)
+		{
+			uint16_t grown = (reach[row] | reach[WRAP_ROW(row + 1)]
+				| reach[WRAP_ROW(row - 1)]) & open[row];
+			uint16_t previous;
+			do
+			{
+				previous = grown;
+				grown |= (uint16_t)((grown << 1) | (grown >> 15)) & open[row];
+				grown |= (uint16_t)((grown >> 1) | (grown << 15)) & open[row];
+			} while (grown != previous);
+			if (grown != reach[row])
+			{
+				reach[row] = grown;
+				changed = true;
+			}
+		}
+	} while (changed);
+}
+
+// Makes the quick checks of a level, which do not need a search.
+static EditorStatus check_level(const LevelLayout *state)
+{
+	if (state->board[state->player_row][state->player_col] & (WALL | BOX))
+	{
+		return EDITOR_PLAYER_BLOCKED;
+	}
+	uint16_t reach[MATRIX_NUM_ROWS];
+	find_reach(state, reach);
+	uint8_t boxes = 0;
+	uint8_t targets = 0;
+	uint8_t boxes_off_target = 0;
+	bool unreachable = false;
+	for (uint8_t row = 0; row < MATRIX_NUM_ROWS; row++)
+	{
+		for (uint8_t col = 0; col < MATRIX_NUM_COLUMNS; col++)
+		{
+			uint8_t object = state->board[row][col];
+			boxes += (object & BOX) != 0;
+			targets += (object & TARGET) != 0;
+			boxes_off_target += (object & OBJECT_MASK) == BOX;
+			if ((object & (BOX | TARGET)) && !(reach[row] & (1U << col)))
+			{
+				unreachable = true;
+			}
+		}
+	}
+	if (boxes == 0)
+	{
+		return EDITOR_NO_BOXES;
+	}
+	if (boxes != targets)
+	{
+		return EDITOR_COUNT_MISMATCH;
+	}
+	if (boxes_off_target == 0)
+	{
+		return EDITOR_ALREADY_SOLVED;
+	}
+	if (unreachable)
+	{
+		return EDITOR_UNREACHABLE;
+	}
+	return EDITOR_CHECKING;
+}
+
+EditorStatus editor_save(void)
+{
+	// The board is checked where it is, as hint_start() takes its own copy.
+	const LevelLayout *state = get_game_layout();
+	status = check_level(state);
+	if (status == EDITOR_CHECKING)
+	{
+		hint_start(state);
+		return editor_update();
+	}
+	return status;
+}
+
+EditorStatus editor_update(void)
+{
+	if (status != EDITOR_CHECKING)
+	{
+		return status;
+	}
+	// The search may already have finished in hint_start().
+	HintStatus search = hint_status();
+	if (search == HINT_SEARCHING)
+	{
+		search = hint_step();
+	}
+	if (search == HINT_STUCK)
+	{
+		status = EDITOR_UNSOLVABLE;
+	}
+	else if (search == HINT_READY)
+	{
+		Hint first_push;
+		hint_get(&first_push);
+		levelstore_save(slot, get_game_layout());
+		saved = true;
+		status = first_push.optimal ? EDITOR_SAVED : EDITOR_SAVED_UNPROVEN;
+		hint_cancel();
+	}
+	return status;
+}
@@ -0,0 +1,116 @@
+/*
+ * editor.h
+ *
+ * Author: Riley Stewart
+ *
+ * Level editor. The level being edited is the game board itself (see
+ * edit_square() in game.h), so it is drawn on the LED matrix and the
+ * terminal in the same way as a game, with only the squares that change
+ * being repainted. A cursor is moved over the board, the object on the
+ * square under it is changed, and the level is saved to one of the custom
+ * level slots in EEPROM (see levelstore.h).
+ *
+ * A level is only saved if it can be played: it must have as many targets
+ * as boxes, the player must be able to walk to every box and target, and
+ * the hint search (see hint.h) must not find it unsolvable. The search is
+ * run a slice at a time by editor_update(), so the editor stays responsive
+ * while it runs.
+ */
+
+#ifndef EDITOR_H_
+#define EDITOR_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+typedef enum
+{
+	EDITOR_EDITING,			// Nothing to report
+	EDITOR_CHECKING,		// Searching for a solution, keep calling editor_update()
+	EDITOR_SAVED,			// Saved, and a solution was found
+	EDITOR_SAVED_UNPROVEN,	// Saved, but the search gave up before finding a solution
+	EDITOR_NO_BOXES,		// There are no boxes
+	EDITOR_COUNT_MISMATCH,	// The numbers of boxes and targets are different
+	EDITOR_ALREADY_SOLVED,	// Every box starts on a target
+	EDITOR_PLAYER_BLOCKED,	// The player starts on a wall or a box
+	EDITOR_UNREACHABLE,		// A box or target is walled off from the player
+	EDITOR_UNSOLVABLE		// The search proved there is no solution
+} EditorStatus;
+
+/// <summary>
+/// Starts editing a custom level slot. The level saved in the slot is
+/// loaded, or if it is empty, a blank level. The whole board is drawn.
+/// </summary>
+/// <param name="slot">The slot (0 to LEVELSTORE_SLOTS - 1).</param>
+void editor_start(uint8_t slot);
+
+/// <summary>
+/// Gets the slot being edited.
+/// </summary>
+/// <returns>The slot (0 to LEVELSTORE_SLOTS - 1).</returns>
+uint8_t editor_slot(void);
+
+/// <summary>
+/// Gets whether the slot holds the level as it is now, i.e. it has been
+/// saved (or loaded) and not changed since.
+/// </summary>
+/// <returns>Whether the level is saved.</returns>
+bool editor_is_saved(void);
+
+/// <summary>
+/// Moves the cursor, wrapping around the edges of the board.
+/// </summary>
+/// <param name="delta_row">The row delta.</param>
+/// <param name="delta_col">The column delta.</param>
+void editor_move_cursor(int8_t delta_row, int8_t delta_col);
+
+/// <summary>
+/// Gets the square under the cursor.
+/// </summary>
+/// <param name="row">Set to the row of the cursor.</param>
+/// <param name="col">Set to the column of the cursor.</param>
+/// <returns>The object(s) on the square.</returns>
+uint8_t editor_cursor(uint8_t *row, uint8_t *col);
+
+/// <summary>
+/// Changes the square under the cursor to the next object, in the order
+/// room, wall, box, target, box on a target.
+/// </summary>
+void editor_cycle(void);
+
+/// <summary>
+/// Puts an object on the square under the cursor.
+/// </summary>
+/// <param name="object">The object(s) (ROOM, WALL, BOX, TARGET or
+/// BOX | TARGET).</param>
+void editor_set(uint8_t object);
+
+/// <summary>
+/// Moves the player's starting square to the cursor, if the square is not
+/// a wall or a box.
+/// </summary>
+/// <returns>Whether the player was moved.</returns>
+bool editor_place_player(void);
+
+/// <summary>
+/// Flashes the cursor on the LED matrix.
+/// </summary>
+void editor_flash_cursor(void);
+
+/// <summary>
+/// Checks the level and, if it passes the quick checks, starts searching
+/// for a solution. The level is saved once the search ends, unless it
+/// proves there is no solution. Any change to the level stops the search.
+/// </summary>
+/// <returns>EDITOR_CHECKING, or the problem found with the level (or
+/// the result, if the search finished straight away).</returns>
+EditorStatus editor_save(void);
+
+/// <summary>
+/// Runs the next slice of the search started by editor_save(), and saves
+/// the level if it ends without proving there is no solution.
+/// </summary>
+/// <returns>The editor status after this slice.</returns>
+EditorStatus editor_update(void);
+
+#endif /* EDITOR_H_ */
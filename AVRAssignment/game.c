@@ -17,7 +17,13 @@
 #include <avr/pgmspace.h>
 #include "ledmatrix.h"
 #include "terminalio.h"
+#include "output.h"
 #include "buzzer.h"
+#include "anim.h"
+#include "telemetry.h"
+#include "termview.h"
+#include "zobrist.h"
+#include "gamelog.h"
 
 
 // ========================== NOTE ABOUT MODULARITY ==========================
@@ -34,147 +40,199 @@
 // ============================ GLOBAL VARIABLES =============================
 
 // The game board, which is dynamically constructed by initialise_game() and
-// updated throughout the game. The 0th element of this array represents the
-// bottom row, and the 7th element of this array represents the top row.
-static uint8_t board[MATRIX_NUM_ROWS][MATRIX_NUM_COLUMNS];
-
-// The location of the player.
+// updated throughout the game. The 0th element of the board represents the
+// bottom row, and the 7th element represents the top row. It is kept in a
+// level layout, so a level can be loaded straight into it and it can be
+// searched or saved where it is (see get_game_layout()).
+static LevelLayout level;
+
+// The location of the player. The player's square in level is only brought
+// up to date by get_game_layout().
 static uint8_t player_row;
 static uint8_t player_col;
 
 // A flag for keeping track of whether the player is currently visible.
 static bool player_visible;
 
-static bool targets_visible;
+// The Zobrist hash of the boxes and the player (see zobrist.h), kept up to
+// date by every move.
+static uint32_t position_hash;
 
-//List for keeping track of player moves
-int move_list[6][2] = {{-1,-1},{-1,-1},{-1,-1},{-1,-1},{-1,-1},{-1,-1}};
-int list_top = -1;
+// The box arrangements (the hash without the player) after the last few
+// pushes, newest last, to notice the boxes going round in a loop.
+#define NUM_ARRANGEMENTS	(8)
+static uint32_t arrangements[NUM_ARRANGEMENTS];
+static uint8_t num_arrangements;
+static bool arrangement_repeated;
 
-int box_list[6][4] = {{-1,-1,-1,-1},{-1,-1,-1,-1},{-1,-1,-1,-1},{-1,-1,-1,-1},{-1,-1,-1,-1},{-1,-1,-1,-1}};
-int box_list_top = -1;
+static bool targets_visible;
+
+// The number of box pushes made (less those undone), for the score.
+static uint16_t push_count;
 
 // ========================== GAME LOGIC FUNCTIONS ===========================
 
-// This function paints a square based on the object(s) currently on it.
-static void paint_square(uint8_t row, uint8_t col)
+// This function returns the theme item shown for a square based on the
+// object(s) currently on it.
+static ThemeItem square_item(uint8_t row, uint8_t col)
 {
-	switch (board[row][col] & OBJECT_MASK)
+	switch (level.board[row][col] & OBJECT_MASK)
 	{
-		case ROOM:
-			ledmatrix_update_pixel(row, col, COLOUR_BLACK);
-			break;
 		case WALL:
-			ledmatrix_update_pixel(row, col, COLOUR_WALL);
-			break;
+			return ITEM_WALL;
 		case BOX:
-			ledmatrix_update_pixel(row, col, COLOUR_BOX);
-			break;
+			return ITEM_BOX;
 		case TARGET:
-			ledmatrix_update_pixel(row, col, COLOUR_TARGET);
-			break;
+			return ITEM_TARGET;
 		case BOX | TARGET:
-			ledmatrix_update_pixel(row, col, COLOUR_DONE);
-			break;
+			return ITEM_DONE;
 		default:
-			break;
+			return ITEM_ROOM;
 	}
 }
 
-void initialise_level(int level) {
-	// Short definitions of game objects used temporarily for constructing
-	// an easier-to-visualise game layout.
-	#define _	(ROOM)
-	#define W	(WALL)
-	#define T	(TARGET)
-	#define B	(BOX)
-	
-	// The starting layout of level x. In this array, the top row is the
-	// 0th row, and the bottom row is the 7th row. This makes it visually
-	// identical to how the pixels are oriented on the LED matrix, however
-	// the LED matrix treats row 0 as the bottom row and row 7 as the top
-	// row.
-	
-	uint8_t level_layout[MATRIX_NUM_ROWS][MATRIX_NUM_COLUMNS];
-	switch (level) {
-			case 1:
-			{
-			uint8_t temp_layout[MATRIX_NUM_ROWS][MATRIX_NUM_COLUMNS] = {
-				{ _, W, _, W, W, W, _, W, W, W, _, _, W, W, W, W },
-				{ _, W, T, W, _, _, W, T, _, B, _, _, _, _, T, W },
-				{ _, _, _, _, _, _, _, _, _, _, _, _, _, _, _, _ },
-				{ W, _, B, _, _, _, _, W, _, _, B, _, _, B, _, W },
-				{ W, _, _, _, W, _, B, _, _, _, _, _, _, _, _, _ },
-				{ _, _, _, _, _, _, T, _, _, _, _, _, _, _, _, _ },
-				{ _, _, _, W, W, W, W, W, W, T, _, _, _, _, _, W },
-				{ W, W, _, _, _, _, _, _, W, W, _, _, W, W, W, W }
-			};
-			memcpy(level_layout, temp_layout, sizeof(level_layout));
-			player_row = 5;
-			player_col = 2;
-			}
-			break;
-		case 2:
-			{
-			uint8_t temp_layout[MATRIX_NUM_ROWS][MATRIX_NUM_COLUMNS] = {
-				{_, _, W, W, W, W, _, _, W, W, _, _, _, _, _, W },
-				{_, _, W, _, _, W, _, W, W, _, _, _, _, B, _, _ },
-				{_, _, W, _, B, W, W, W, _, _, T, W, _, T, W, W },
-				{_, _, W, _, _, _, _, T, _, _, B, W, W, W, _, _ },
-				{W, W, W, W, _, W, _, _, _, _, _, W, _, W, W, _ },
-				{W, T, B, _, _, _, _, B, _, _, _, W, W, _, W, W },
-				{W, _, _, _, T, _, _, _, _, _, _, B, T, _, _, _ },
-				{W, W, W, W, W, W, W, W, W, W, W, W, W, W, W, W }
-			};
-			memcpy(level_layout, temp_layout, sizeof(level_layout));
-			player_row = 6;
-			player_col = 15;
-			}
-			break;
-	}
-	
-	// Undefine the short game object names defined above, so that you
-	// cannot use use them in your own code. Use of single-letter names/
-	// constants is never a good idea.
-	#undef _
-	#undef W
-	#undef T
-	#undef B
-	
-	// Copy the starting layout (level map) to the board array, and flip
-	// all the rows.
-	for (uint8_t row = 0; row < MATRIX_NUM_ROWS; row++)
+// This function returns the colour of a square based on the object(s)
+// currently on it.
+PixelColour square_colour(uint8_t row, uint8_t col)
+{
+	return theme_led(square_item(row, col));
+}
+
+// This function paints a square based on the object(s) currently on it.
+static void paint_square(uint8_t row, uint8_t col)
+{
+	ledmatrix_update_pixel(row, col, square_colour(row, col));
+}
+
+// This function moves the player to a square, updating the position hash.
+static void place_player(uint8_t row, uint8_t col)
+{
+	position_hash ^= zobrist_player(player_row, player_col)
+		^ zobrist_player(row, col);
+	player_row = row;
+	player_col = col;
+}
+
+// This function records the box arrangement after a push, noting whether
+// the boxes were arranged the same way after an earlier push (or at the
+// start of the level).
+static void remember_arrangement(void)
+{
+	uint32_t arrangement = position_hash ^ zobrist_player(player_row, player_col);
+	arrangement_repeated = false;
+	for (uint8_t i = 0; i < num_arrangements; i++)
 	{
-		for (uint8_t col = 0; col < MATRIX_NUM_COLUMNS; col++)
+		if (arrangements[i] == arrangement)
 		{
-			board[MATRIX_NUM_ROWS - 1 - row][col] =
-			level_layout[row][col];
+			arrangement_repeated = true;
 		}
 	}
+	if (num_arrangements == NUM_ARRANGEMENTS)
+	{
+		memmove(arrangements, arrangements + 1,
+			sizeof(arrangements[0]) * (NUM_ARRANGEMENTS - 1));
+		num_arrangements--;
+	}
+	arrangements[num_arrangements++] = arrangement;
 }
 
 // This function initialises the global variables used to store the game
-// state, and renders the initial game display.
-void initialise_game(int level) {
+// state from a decoded level layout, and renders the initial game display.
+void initialise_game(const LevelLayout *layout) {
 	
-	initialise_level(level);
+	//The level may have been loaded straight into the board already
+	if (layout != &level) {
+		memcpy(&level, layout, sizeof(level));
+	}
+	player_row = layout->player_row;
+	player_col = layout->player_col;
 
 	// Make the player icon initially invisible.
 	player_visible = false;
 
-	// Draw the game board (map).
-	for (uint8_t row = 0; row < MATRIX_NUM_ROWS; row++)
-	{
-		for (uint8_t col = 0; col < MATRIX_NUM_COLUMNS; col++)
-		{
-			paint_square(row, col);
-		}
-	}
+	//Nothing from an earlier level can be undone
+	gamelog_start(layout);
+	push_count = 0;
+
+	//Hash the starting position, which later moves update
+	position_hash = zobrist_hash(layout);
+	num_arrangements = 0;
+	remember_arrangement();
+
+	// The whole matrix is redrawn below, so drop any running animations.
+	anim_cancel();
+
+	// Draw the game board (map) in a single burst to the LED matrix. The
+	// colours are sent as they are worked out, rather than built up in a
+	// frame on the stack first.
+	ledmatrix_update_all_from(square_colour);
 	
 	//Draw the game board on the terminal
 	draw_terminal_board();
 }
 
+// This function returns the Zobrist hash of the current position.
+uint32_t get_position_hash(void)
+{
+	return position_hash;
+}
+
+// This function returns the number of box pushes made so far.
+uint16_t get_push_count(void)
+{
+	return push_count;
+}
+
+// This function returns whether the last move was a push that put the
+// boxes back the way they were after one of the last few pushes.
+bool is_repeated_arrangement(void)
+{
+	return arrangement_repeated;
+}
+
+// This function copies the current board and player location into a level
+// layout, for searches that work on their own copy of the game state.
+void get_game_state(LevelLayout *state)
+{
+	memcpy(state, get_game_layout(), sizeof(*state));
+}
+
+// This function returns the board and player location as they are, without
+// copying them.
+const LevelLayout *get_game_layout(void)
+{
+	level.player_row = player_row;
+	level.player_col = player_col;
+	return &level;
+}
+
+// This function returns the layout the game is played on, for a level to be
+// loaded into before it is passed to initialise_game().
+LevelLayout *get_level_buffer(void)
+{
+	return &level;
+}
+
+// This function draws or removes a hint: the box to push is shown in the
+// ITEM_HINT_BOX colour and the square it should be pushed into in the
+// ITEM_HINT_PUSH colour. Removing it repaints both squares from the board.
+void paint_hint(uint8_t box_row, uint8_t box_col, int8_t delta_row,
+	int8_t delta_col, bool visible)
+{
+	uint8_t push_row = WRAP_ROW(box_row + delta_row);
+	uint8_t push_col = WRAP_COL(box_col + delta_col);
+	if (visible)
+	{
+		ledmatrix_update_pixel(box_row, box_col, theme_led(ITEM_HINT_BOX));
+		ledmatrix_update_pixel(push_row, push_col, theme_led(ITEM_HINT_PUSH));
+	}
+	else
+	{
+		paint_square(box_row, box_col);
+		paint_square(push_row, push_col);
+	}
+}
+
 // This function flashes the player icon. If the icon is currently visible, it
 // is set to not visible and removed from the display. If the player icon is
 // currently not visible, it is set to visible and rendered on the display.
@@ -185,8 +243,8 @@ void flash_player(void)
 	player_visible = !player_visible;
 	if (player_visible)
 	{
-		// The player is visible, paint it with COLOUR_PLAYER.
-		ledmatrix_update_pixel(player_row, player_col, COLOUR_PLAYER);
+		// The player is visible, paint it in the player colour.
+		ledmatrix_update_pixel(player_row, player_col, theme_led(ITEM_PLAYER));
 	}
 	else
 	{
@@ -199,11 +257,11 @@ void flash_targets(void) {
 	targets_visible = !targets_visible;
 	for (int row = 0; row < MATRIX_NUM_ROWS; row++) {
 		for (int col = 0; col < MATRIX_NUM_COLUMNS; col++) {
-			if (board[row][col] == TARGET) {
+			if (level.board[row][col] == TARGET) {
 				if (targets_visible) {
-					ledmatrix_update_pixel(row, col, COLOUR_TARGET);
+					ledmatrix_update_pixel(row, col, theme_led(ITEM_TARGET));
 				} else {
-					ledmatrix_update_pixel(row, col, COLOUR_BLACK);
+					ledmatrix_update_pixel(row, col, theme_led(ITEM_ROOM));
 				}
 			}
 		}
@@ -268,69 +326,71 @@ bool move_player(int8_t delta_row, int8_t delta_col)
 	
 	bool box_moved = false;
 	
+	//Finish any animation so the display matches the board before it changes
+	anim_finish();
+	
 	//Calculate next positions
-	int next_row = modulo((player_row+delta_row), 8);
-	int next_col = modulo((player_col+delta_col), 16);
-	int next_next_row = modulo((next_row+delta_row), 8);
-	int next_next_col = modulo((next_col+delta_col), 16);
+	int next_row = WRAP_ROW(player_row + delta_row);
+	int next_col = WRAP_COL(player_col + delta_col);
+	int next_next_row = WRAP_ROW(next_row + delta_row);
+	int next_next_col = WRAP_COL(next_col + delta_col);
+	
+	//Colours shown before the move, for a box slide to start from
+	PixelColour box_colour = square_colour(next_row, next_col);
+	PixelColour under_colour = square_colour(next_next_row, next_next_col);
 
-	paint_square(player_row, player_col);
 	move_terminal_cursor(20,0);
 	clear_to_end_of_line();
 	
 	//checks for wall in front of player
-	if (board[next_row][next_col] == WALL) {
-		display_terminal_message("wall");
+	if (level.board[next_row][next_col] == WALL) {
+		display_terminal_message(MSG_WALL);
 		return false;
 		
-	//checks for filled target in front of player
-	} else if (board[next_row][next_col] == (BOX | TARGET)) {
-		if (board[next_next_row][next_next_col] == WALL) {
-			display_terminal_message("box_wall");
-			return false;
-		}
-		board[next_row][next_col] = TARGET;
-		paint_square(next_row, next_col);
-		update_terminal_display(next_row, MATRIX_NUM_ROWS-next_row, 1);
-		board[next_next_row][next_next_col] = BOX;
-		paint_square(next_next_row, next_next_col);
-		update_terminal_display(next_next_row, MATRIX_NUM_ROWS-next_next_row, 1);
-		box_moved = true;
-		
-	//checks for box in front of player
-	} else if (board[next_row][next_col] == BOX) {
-		if (board[next_next_row][next_next_col] == WALL) {
-			display_terminal_message("box_wall");
+	//checks for box (on a target or not) in front of player
+	} else if (level.board[next_row][next_col] & BOX) {
+		if (level.board[next_next_row][next_next_col] == WALL) {
+			display_terminal_message(MSG_BOX_WALL);
 			return false;
-		} else if (board[next_next_row][next_next_col] == BOX) {
-			display_terminal_message("box_box");
+		} else if (level.board[next_next_row][next_next_col] & BOX) {
+			display_terminal_message(MSG_BOX_BOX);
 			return false;
-		} else {
-			box_moved = true;
-			board[next_row][next_col] = ROOM;
-			if (board[next_next_row][next_next_col] == TARGET) {
-				board[next_next_row][next_next_col] = (TARGET | BOX);
-				paint_square(next_next_row, next_next_col);
-				update_terminal_display(next_next_row, MATRIX_NUM_ROWS-next_next_row, 1);
-			} else {
-				board[next_next_row][next_next_col] = BOX;
-				paint_square(next_next_row, next_next_col);
-				update_terminal_display(next_next_row, MATRIX_NUM_ROWS-next_next_row, 1);
-			}
 		}
+		//Targets stay where they are, under or out from under the box
+		box_moved = true;
+		level.board[next_row][next_col] &= ~BOX;
+		level.board[next_next_row][next_next_col] |= BOX;
+		position_hash ^= zobrist_box(next_row, next_col) ^ zobrist_box(next_next_row, next_next_col);
+		update_terminal_display(next_next_row, MATRIX_NUM_ROWS-next_next_row, 1);
 	}
 	
+	gamelog_record(delta_row, delta_col, box_moved);
 	if (box_moved) {
-		add_previous_box_location(next_row, next_col, next_next_row, next_next_col);
-		box_moved = false;
-	} else {
-		add_previous_box_location(-1,-1,-1,-1);
+		push_count++;
+		//Slide the box across, with a burst once it lands on a target
+		anim_slide(next_row, next_col, next_next_row, next_next_col, box_colour, under_colour);
+		bool on_target = (level.board[next_next_row][next_next_col] == (BOX | TARGET));
+		if (on_target) {
+			anim_burst(next_next_row, next_next_col, ANIM_SLIDE_FRAMES);
+		}
+		telemetry_push(next_row, next_col, next_next_row, next_next_col, on_target);
 	}
 	
-	add_to_move_list(player_row, player_col);
-	player_row = next_row;
-	player_col = next_col;
-	paint_square(player_row, player_col);
+	//Take the player off its old square, unless it is flashed off already
+	if (player_visible) {
+		paint_square(player_row, player_col);
+	}
+	place_player(next_row, next_col);
+	arrangement_repeated = false;
+	if (box_moved) {
+		remember_arrangement();
+	}
+	//Show the player on its new square straight away. A pushed box slides
+	//over that square, so then the next flash shows the player instead.
+	player_visible = false;
+	if (!box_moved) {
+		flash_player();
+	}
 	update_terminal_display(player_row, MATRIX_NUM_ROWS-player_row, 1);	
 	return true;
 }
@@ -340,34 +400,39 @@ bool move_diagonal(int8_t delta_row_1, int8_t delta_col_1, int8_t delta_row_2, i
 	int first_move_col;
 	int second_move_row;
 	int second_move_col;
-	first_move_row = modulo((player_row+delta_row_1), 8);  //try moving in the first direction first
-	first_move_col = modulo((player_col+delta_col_1), 16);
+	anim_finish();
+	first_move_row = WRAP_ROW(player_row + delta_row_1);  //try moving in the first direction first
+	first_move_col = WRAP_COL(player_col + delta_col_1);
 	if (check_wall_or_box(first_move_row, first_move_col)) {  //try first move
-		second_move_row = modulo((first_move_row+delta_row_2), 8);
-		second_move_col = modulo((first_move_col+delta_col_2), 16);
+		second_move_row = WRAP_ROW(first_move_row + delta_row_2);
+		second_move_col = WRAP_COL(first_move_col + delta_col_2);
 		if (check_wall_or_box(second_move_row, second_move_col)) {  //try second move
-			paint_square(player_row, player_col);  //second move successful
-			add_to_move_list(player_row, player_col);
-			player_row = second_move_row;
-			player_col = second_move_col;
-			paint_square(player_row, player_col);
+			if (player_visible) {  //second move successful
+				paint_square(player_row, player_col);
+			}
+			gamelog_record(delta_row_1 + delta_row_2, delta_col_1 + delta_col_2, false);
+			place_player(second_move_row, second_move_col);
+			arrangement_repeated = false;
 			update_terminal_display(player_row, MATRIX_NUM_ROWS-player_row, 1);
+			player_visible = false;
 			flash_player();
 			return true;
 		}
 	} 
-	first_move_row = modulo((player_row+delta_row_2), 8);  //try moving in the second direction first
-	first_move_col = modulo((player_col+delta_col_2), 16);
+	first_move_row = WRAP_ROW(player_row + delta_row_2);  //try moving in the second direction first
+	first_move_col = WRAP_COL(player_col + delta_col_2);
 	if (check_wall_or_box(first_move_row, first_move_col)) {  //try first move
-		second_move_row = modulo((first_move_row+delta_row_1), 8);
-		second_move_col = modulo((first_move_col+delta_col_1), 16);
+		second_move_row = WRAP_ROW(first_move_row + delta_row_1);
+		second_move_col = WRAP_COL(first_move_col + delta_col_1);
 		if (check_wall_or_box(second_move_row, second_move_col)) {  //try second move
-			paint_square(player_row, player_col);  //second move successful
-			add_to_move_list(player_row, player_col);
-			player_row = second_move_row;
-			player_col = second_move_col;
-			paint_square(player_row, player_col);
+			if (player_visible) {  //second move successful
+				paint_square(player_row, player_col);
+			}
+			gamelog_record(delta_row_1 + delta_row_2, delta_col_1 + delta_col_2, false);
+			place_player(second_move_row, second_move_col);
+			arrangement_repeated = false;
 			update_terminal_display(player_row, MATRIX_NUM_ROWS-player_row, 1);
+			player_visible = false;
 			flash_player();
 			return true;
 		}
@@ -375,109 +440,102 @@ bool move_diagonal(int8_t delta_row_1, int8_t delta_col_1, int8_t delta_row_2, i
 	return false;  //both directions failed, move cannot be made
 }
 
-bool undo_move(void) {
-	if (list_top < 0 || move_list[list_top][0] == -1 || move_list[list_top][1] == -1) {
+uint8_t undo_move(void) {
+	uint16_t step = gamelog_step();
+	int8_t delta_row, delta_col;
+	if (step == 0 || !gamelog_move(step - 1, &delta_row, &delta_col)
+			|| !rewind_game(step - 1)) {
+		return 0;
+	}
+	//A diagonal move counts as two steps, as it did when it was made
+	return (delta_row && delta_col) ? 2 : 1;
+}
+
+static void put_terminal_square(uint8_t row, uint8_t col);
+
+//Winds the game back or forward to a step of the game log. Only the squares
+//whose box the rewind moves are changed and repainted, and the player.
+bool rewind_game(uint16_t step) {
+	RewindDiff diff;
+	if (!gamelog_rewind(step, &diff)) {
 		return false;
 	}
-	if (list_top >= 0) {
+	anim_finish();
+	if (player_visible) {
 		paint_square(player_row, player_col);
-		player_row = move_list[list_top][0];
-		player_col = move_list[list_top][1];
-		list_top--;
 	}
-	
-	if (!(box_list_top < 0 || box_list[box_list_top][0] == -1 || box_list[box_list_top][1] == -1)) {
-		if (box_list_top >= 0) {
-			move_box();
-			box_list_top--;
-		}
-	}
-	return true;
-}
-
-void add_to_move_list(uint8_t row, uint8_t col) {
-	if (list_top < 5) {
-		list_top++;
-		move_list[list_top][0] = row;
-		move_list[list_top][1] = col;
-	} else {
-		for (int i = 0; i < 5; i++) {
-			move_list[i][0] = move_list[i+1][0];
-			move_list[i][1] = move_list[i+1][1];
+	for (uint8_t row = 0; row < MATRIX_NUM_ROWS; row++) {
+		for (uint8_t col = 0; diff.boxes[row]; col++) {
+			if (diff.boxes[row] & 1) {
+				level.board[row][col] ^= BOX;
+				position_hash ^= zobrist_box(row, col);
+				paint_square(row, col);
+				if (!ledmatrix_is_headless()) {
+					put_terminal_square(row, col);
+				}
+			}
+			diff.boxes[row] >>= 1;
 		}
-		move_list[5][0] = row;
-		move_list[5][1] = col;
 	}
-}
-
-void add_previous_box_location(uint8_t row, uint8_t col, uint8_t current_row, uint8_t current_col) {
-	if (box_list_top < 5) {
-		box_list_top++;
-		box_list[box_list_top][0] = row;
-		box_list[box_list_top][1] = col;
-		box_list[box_list_top][2] = current_row;
-		box_list[box_list_top][3] = current_row;
+	place_player(diff.player_row, diff.player_col);
+	
+	//Forget the arrangements made by the pushes rewound. Those made by
+	//pushes wound forward again are not known, so only the one now is kept.
+	arrangement_repeated = false;
+	if (diff.pushes > push_count || step == 0) {
+		num_arrangements = 0;
+		remember_arrangement();
+	} else if (push_count - diff.pushes < num_arrangements) {
+		num_arrangements -= push_count - diff.pushes;
 	} else {
-		for (int i = 0; i < 5; i++) {
-			box_list[i][0] = box_list[i+1][0];
-			box_list[i][1] = box_list[i+1][1];
-			box_list[i][2] = box_list[i+1][2];
-			box_list[i][3] = box_list[i+1][3];
-		}
-		box_list[5][0] = row;
-		box_list[5][1] = col;
-		box_list[5][2] = current_row;
-		box_list[5][3] = current_col;
+		num_arrangements = 1;
 	}
-}
-
-void move_box(void) {
-	board[box_list[box_list_top][0]][box_list[box_list_top][1]] = BOX;
-	board[box_list[box_list_top][2]][box_list[box_list_top][3]] = ROOM;
-	paint_square(box_list[box_list_top][0], box_list[box_list_top][1]);
-	paint_square(box_list[box_list_top][2], box_list[box_list_top][3]);
+	push_count = diff.pushes;
+	player_visible = false;
+	flash_player();
+	return true;
 }
 
 bool check_wall_or_box(int row, int col) {
-	if (board[row][col] == WALL) {
-		display_terminal_message("wall_diagonal");
+	if (level.board[row][col] == WALL) {
+		display_terminal_message(MSG_WALL_DIAGONAL);
 		return false;
-	} else if (board[row][col] == BOX) {
-		display_terminal_message("box_diagonal");
+	} else if (level.board[row][col] == BOX) {
+		display_terminal_message(MSG_BOX_DIAGONAL);
 		return false;
-	} else if (board[row][col] == (BOX | TARGET)) {
-		display_terminal_message("box_diagonal");
+	} else if (level.board[row][col] == (BOX | TARGET)) {
+		display_terminal_message(MSG_BOX_DIAGONAL);
 		return false;
 	}
 	return true; 
 }
 
-void display_terminal_message(char type[]) {
-	if (strcmp(type, "wall") == 0) {
+void display_terminal_message(MessageType type) {
+	if (type == MSG_WALL) {
 		int rand_num;
 		int lb = 1;
 		int ub = 3;
 		rand_num = (rand() % (ub - lb + 1)) + lb;
 		move_terminal_cursor(20, 1);
 		if (rand_num == 1) {
-			printf_P(PSTR("Player hit a wall"));
+			put_str_P(PSTR("Player hit a wall"));
 		} else if (rand_num == 2) {
-			printf_P(PSTR("Wall hit"));
+			put_str_P(PSTR("Wall hit"));
 		} else if (rand_num == 3) {
-			printf_P(PSTR("There is a wall in the way"));
+			put_str_P(PSTR("There is a wall in the way"));
 		}
-	} else if (strcmp(type, "box_wall") == 0) {
+	} else if (type == MSG_BOX_WALL) {
 		move_terminal_cursor(20, 1);
-		printf_P(PSTR("Cannot push box onto wall"));
-	} else if (strcmp(type, "box_box") == 0) {
+		put_str_P(PSTR("Cannot push box onto wall"));
+	} else if (type == MSG_BOX_BOX) {
 		move_terminal_cursor(20, 1);
-		printf_P(PSTR("Cannot stack boxes"));
-	} else if (strcmp(type, "wall_diagonal") == 0) {
+		put_str_P(PSTR("Cannot stack boxes"));
+	} else if (type == MSG_WALL_DIAGONAL) {
 		move_terminal_cursor(20, 1);
-		printf_P(PSTR("Diagonal move cannot be made"));
-	} else if (strcmp(type, "box_diagonal") == 0) {
+		put_str_P(PSTR("Diagonal move cannot be made"));
+	} else if (type == MSG_BOX_DIAGONAL) {
 		move_terminal_cursor(20, 1);
-		printf_P(PSTR("Cannot move boxes diagonally"));
+		put_str_P(PSTR("Cannot move boxes diagonally"));
 }
 	return;
 }
@@ -488,7 +546,7 @@ bool is_game_over(void)
 {
 	for (int row = 0; row < MATRIX_NUM_ROWS; row++) {
 		for (int col = 0; col < MATRIX_NUM_COLUMNS; col++) {
-			if (board[row][col] == TARGET) {
+			if (level.board[row][col] == TARGET) {
 				return false;
 			}
 		}
@@ -497,36 +555,135 @@ bool is_game_over(void)
 	return true;
 }
 
-//Calculates the modulus of a number for player movement
-int modulo(int x,int y){
-	return (x % y + y) % y;
+// This function returns true iff the player is at (row, col).
+bool is_player_at(uint8_t row, uint8_t col)
+{
+	return row == player_row && col == player_col;
+}
+
+//Prints one three-character board cell in the colour of a theme item
+static void put_terminal_cell(ThemeItem item) {
+	theme_set_background(item);
+	put_str_P(PSTR("   \033[0m"));
 }
 
-//Paints the current board on the terminal display
+//Prints one square of the board in its place on the terminal. The terminal
+//board starts at column 1, three characters per square, and has no room for
+//column 0.
+static void put_terminal_square(uint8_t row, uint8_t col) {
+	if (col >= 1) {
+		move_terminal_cursor(MATRIX_NUM_ROWS-row, 1+3*(col-1));
+		put_terminal_cell(square_item(row, col));
+	}
+}
+
+//Paints the current board on the terminal display. In headless mode the
+//terminal shows the LED matrix image instead (see termview.h).
 void draw_terminal_board(void) {
+	if (ledmatrix_is_headless()) {
+		return;
+	}
 	int GAME_BOARD_ROW = 1;
 	int GAME_BOARD_COL = 1;
 	for (int row = MATRIX_NUM_ROWS-1; row >= 0; row--) {
 		update_terminal_display(row, GAME_BOARD_ROW, GAME_BOARD_COL);
-		printf("\n");
+		put_char('\n');
 		GAME_BOARD_ROW++;
 	}
 }
 
 void update_terminal_display(int board_row, int terminal_row, int terminal_col) {
+	if (ledmatrix_is_headless()) {
+		return;
+	}
 	move_terminal_cursor(terminal_row, terminal_col);
 	clear_to_end_of_line();
 	for (int column = 1; column <= MATRIX_NUM_COLUMNS-1; column++) {
-		if (board[board_row][column] == ROOM) {
-			printf("\033[100m   \033[0m");
-		} else if (board[board_row][column] == WALL) {
-			printf("\033[103m   \033[0m");
-		} else if (board[board_row][column] == BOX) {
-			printf("\033[43m   \033[0m");
-		} else if (board[board_row][column] == TARGET) {
-			printf("\033[41m   \033[0m");
-		} else if (board[board_row][column] == (BOX | TARGET)) {
-			printf("\033[102m   \033[0m");
+		put_terminal_cell(square_item(board_row, column));
+	}
+}
+
+//Switches to a new theme, repainting only the squares (on the LED matrix
+//and the terminal) whose colour is different in the new theme
+void change_theme(Theme theme, TerminalPalette palette) {
+	anim_finish();
+	uint8_t led_changes = theme_led_changes(theme);
+	uint8_t terminal_changes = theme_terminal_changes(theme, palette);
+	if (ledmatrix_is_headless()) {
+		//The terminal shows the LED colours, in the palette's encoding
+		if (palette != theme_palette()) {
+			termview_invalidate();
 		}
+		terminal_changes = 0;
 	}
-}
\ No newline at end of file
+	theme_select(theme, palette);
+	for (uint8_t row = 0; row < MATRIX_NUM_ROWS; row++) {
+		for (uint8_t col = 0; col < MATRIX_NUM_COLUMNS; col++) {
+			uint8_t changed = (1 << square_item(row, col));
+			if (led_changes & changed) {
+				paint_square(row, col);
+			}
+			if (terminal_changes & changed) {
+				put_terminal_square(row, col);
+			}
+		}
+	}
+	if (player_visible) {
+		ledmatrix_update_pixel(player_row, player_col, theme_led(ITEM_PLAYER));
+	}
+}
+
+// ============================ LEVEL EDITING ================================
+
+//Starts the game log again from the edited board, so nothing can be rewound
+//to from before the edit
+static void restart_game_log(void) {
+	gamelog_start(get_game_layout());
+	push_count = 0;
+}
+
+//Puts an object on a square for the level editor, repainting just that
+//square on the LED matrix and the terminal
+void edit_square(uint8_t row, uint8_t col, uint8_t object) {
+	if ((level.board[row][col] ^ object) & BOX) {
+		position_hash ^= zobrist_box(row, col);
+	}
+	level.board[row][col] = object;
+	paint_square(row, col);
+	if (!ledmatrix_is_headless()) {
+		put_terminal_square(row, col);
+	}
+	if (row == player_row && col == player_col) {
+		player_visible = false;
+	}
+	restart_game_log();
+}
+
+//Gets the object(s) on a square, for the level editor
+uint8_t get_square(uint8_t row, uint8_t col) {
+	return level.board[row][col];
+}
+
+//Moves the player's starting square for the level editor. The player is
+//shown again by the next flash_player().
+void edit_player(uint8_t row, uint8_t col) {
+	if (player_visible) {
+		paint_square(player_row, player_col);
+	}
+	place_player(row, col);
+	player_visible = false;
+	restart_game_log();
+}
+
+//Draws or removes the level editor's cursor. Removing it repaints the
+//square from the board.
+void paint_cursor(uint8_t row, uint8_t col, bool visible) {
+	if (visible) {
+		ledmatrix_update_pixel(row, col, theme_led(ITEM_HINT_PUSH));
+	} else {
+		paint_square(row, col);
+		if (row == player_row && col == player_col) {
+			player_visible = false;
+		}
+	}
+}
@@ -14,6 +14,8 @@
 
 #include <stdint.h>
 #include <stdbool.h>
+#include "levels.h"
+#include "theme.h"
 
 // Object definitions.
 #define ROOM       	(0U << 0)
@@ -22,19 +24,23 @@
 #define TARGET     	(1U << 2)
 #define OBJECT_MASK	(ROOM | WALL | BOX | TARGET)
 
-// Colour definitions.
-#define COLOUR_PLAYER	(COLOUR_DARK_GREEN)
-#define COLOUR_WALL  	(COLOUR_YELLOW)
-#define COLOUR_BOX   	(COLOUR_ORANGE)
-#define COLOUR_TARGET	(COLOUR_RED)
-#define COLOUR_DONE  	(COLOUR_GREEN)
+// The colours of the board are set by the current theme (see theme.h).
 
-void initialise_level(int level);
+/// <summary>
+/// Initialises the game from a decoded level layout, which may be the one
+/// from get_level_buffer().
+/// </summary>
+/// <param name="layout">The layout of the level to play.</param>
+void initialise_game(const LevelLayout *layout);
 
 /// <summary>
-/// Initialises the game.
+/// Gets the LED matrix colour of a square from the object(s) on it. The
+/// player is not included.
 /// </summary>
-void initialise_game(int level);
+/// <param name="row">The row of the square.</param>
+/// <param name="col">The column of the square.</param>
+/// <returns>The colour of the square.</returns>
+PixelColour square_colour(uint8_t row, uint8_t col);
 
 /// <summary>
 /// Moves the player based on row and column deltas.
@@ -46,22 +52,40 @@ bool move_player(int8_t delta_row, int8_t delta_col);
 
 bool move_diagonal(int8_t delta_row_1, int8_t delta_col_1, int8_t delta_row_2, int8_t delta_col_2);
 
-bool undo_move(void);
-
-void add_to_move_list(uint8_t row, uint8_t col);
-
-void add_previous_box_location(uint8_t row, uint8_t col, uint8_t current_row, uint8_t current_col);
+/// <summary>
+/// Undoes the last move, if it is still in the game log (see gamelog.h).
+/// </summary>
+/// <returns>The steps the move counted for (two for a diagonal move), or 0
+/// if no move was undone.</returns>
+uint8_t undo_move(void);
 
-void move_box(void);
+/// <summary>
+/// Winds the game back (or forward again) to a step of the game log, such
+/// as 0 to go back to the level start. Only the squares that change are
+/// repainted, on both the LED matrix and the terminal.
+/// </summary>
+/// <param name="step">The step, counted in moves from the level start.
+/// </param>
+/// <returns>Whether the step is still in the game log.</returns>
+bool rewind_game(uint16_t step);
 
 bool check_wall_or_box(int row, int col);
 
+// Messages shown in the terminal message area when a move is blocked
+typedef enum {
+	MSG_WALL,
+	MSG_BOX_WALL,
+	MSG_BOX_BOX,
+	MSG_WALL_DIAGONAL,
+	MSG_BOX_DIAGONAL
+} MessageType;
+
 /// <summary>
 /// Displays a message in the message area of the terminal.
 /// Contents of message depend on type parameter
 /// </summary>
 /// <param name="type">The type of message to be displayed.</param>
-void display_terminal_message(char type[]);
+void display_terminal_message(MessageType type);
 
 /// <summary>
 /// Detects whether the game is over (i.e., current level solved).
@@ -69,13 +93,78 @@ void display_terminal_message(char type[]);
 /// <returns>Whether the game is over.</returns>
 bool is_game_over(void);
 
-///<summary>
-///Calculates modulo for moving player across board
-///</summary>
-///<param name="x">First value in calculation</param>
-///<param name="y">Second value in calculation</param>
-///<returns>Modulo of x and y</returns>
-int modulo(int x,int y);
+/// <summary>
+/// Tests whether the player is on a square.
+/// </summary>
+/// <param name="row">The row of the square.</param>
+/// <param name="col">The column of the square.</param>
+/// <returns>Whether the player is at (row, col).</returns>
+bool is_player_at(uint8_t row, uint8_t col);
+
+// Wraps a row or column index around the edge of the board. The board
+// dimensions are powers of two, so this is a mask rather than a division,
+// and it also wraps -1 to the last row/column.
+#define WRAP_ROW(row)	((uint8_t)(row) & (MATRIX_NUM_ROWS - 1))
+#define WRAP_COL(col)	((uint8_t)(col) & (MATRIX_NUM_COLUMNS - 1))
+
+_Static_assert((MATRIX_NUM_ROWS & (MATRIX_NUM_ROWS - 1)) == 0,
+	"WRAP_ROW needs a power of two row count");
+_Static_assert((MATRIX_NUM_COLUMNS & (MATRIX_NUM_COLUMNS - 1)) == 0,
+	"WRAP_COL needs a power of two column count");
+
+/// <summary>
+/// Copies the current board and player location into a level layout.
+/// </summary>
+/// <param name="state">The layout to copy the game state into.</param>
+void get_game_state(LevelLayout *state);
+
+/// <summary>
+/// Gets the current board and player location without copying them, for a
+/// search or save that is done with them before the next move or edit.
+/// </summary>
+/// <returns>The game state.</returns>
+const LevelLayout *get_game_layout(void);
+
+/// <summary>
+/// Gets the layout the game is played on, so a level can be loaded straight
+/// into it rather than into a copy. Loading into it replaces the game in
+/// progress, so it must be followed by initialise_game() with it.
+/// </summary>
+/// <returns>The layout to load into.</returns>
+LevelLayout *get_level_buffer(void);
+
+/// <summary>
+/// Gets the Zobrist hash of the current box and player positions (see
+/// zobrist.h). Equal positions always have equal hashes.
+/// </summary>
+/// <returns>The position's hash.</returns>
+uint32_t get_position_hash(void);
+
+/// <summary>
+/// Gets the number of box pushes made since the level started. Undoing a
+/// push takes it off again.
+/// </summary>
+/// <returns>The number of pushes.</returns>
+uint16_t get_push_count(void);
+
+/// <summary>
+/// Gets whether the last move was a push that left the boxes arranged as
+/// they were after one of the last few pushes (or at the start of the
+/// level), i.e. the player is pushing boxes round in a loop.
+/// </summary>
+/// <returns>Whether the box arrangement has been seen recently.</returns>
+bool is_repeated_arrangement(void);
+
+/// <summary>
+/// Draws or removes a hint on the LED matrix.
+/// </summary>
+/// <param name="box_row">The row of the box to push.</param>
+/// <param name="box_col">The column of the box to push.</param>
+/// <param name="delta_row">The row direction to push it in.</param>
+/// <param name="delta_col">The column direction to push it in.</param>
+/// <param name="visible">Whether to draw the hint or remove it.</param>
+void paint_hint(uint8_t box_row, uint8_t box_col, int8_t delta_row,
+	int8_t delta_col, bool visible);
 
 /// <summary>
 /// Flashes the player icon.
@@ -88,5 +177,46 @@ void draw_terminal_board(void);
 
 void update_terminal_display(int board_row, int terminal_row, int terminal_col);
 
+/// <summary>
+/// Switches the colour theme. Only the squares whose colour changes are
+/// repainted, on both the LED matrix and the terminal.
+/// </summary>
+/// <param name="theme">The theme to use.</param>
+/// <param name="palette">How to send terminal colours.</param>
+void change_theme(Theme theme, TerminalPalette palette);
+
+/// <summary>
+/// Puts an object on a square, for the level editor. Only that square is
+/// repainted, on both the LED matrix and the terminal.
+/// </summary>
+/// <param name="row">The row of the square.</param>
+/// <param name="col">The column of the square.</param>
+/// <param name="object">The object(s) to put on it (ROOM, WALL, BOX,
+/// TARGET or BOX | TARGET).</param>
+void edit_square(uint8_t row, uint8_t col, uint8_t object);
+
+/// <summary>
+/// Gets the object(s) on a square, for the level editor.
+/// </summary>
+/// <param name="row">The row of the square.</param>
+/// <param name="col">The column of the square.</param>
+/// <returns>The object(s) on the square.</returns>
+uint8_t get_square(uint8_t row, uint8_t col);
+
+/// <summary>
+/// Moves the player's starting square, for the level editor.
+/// </summary>
+/// <param name="row">The row of the square.</param>
+/// <param name="col">The column of the square.</param>
+void edit_player(uint8_t row, uint8_t col);
+
+/// <summary>
+/// Draws or removes the level editor's cursor on the LED matrix.
+/// </summary>
+/// <param name="row">The row of the cursor.</param>
+/// <param name="col">The column of the cursor.</param>
+/// <param name="visible">Whether to draw the cursor or remove it.</param>
+void paint_cursor(uint8_t row, uint8_t col, bool visible);
+
 #endif /* GAME_H_ */
 
@@ -0,0 +1,255 @@
+/*
+ * gamelog.c
+ *
+ * Author: Riley Stewart
+ */
+
+#include "gamelog.h"
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include "game.h"
+
+// A move is kept as the row and column deltas, two bits each (two's
+// complement), and whether it pushed a box.
+#define MOVE_DELTA_MASK	(0x03)
+#define MOVE_ROW_SHIFT	(2)
+#define MOVE_PUSH		(1 << 4)
+
+_Static_assert(MATRIX_NUM_COLUMNS <= 16, "a box bitplane row is 16 bits");
+_Static_assert(MATRIX_NUM_ROWS <= 16 && MATRIX_NUM_COLUMNS <= 16,
+	"the player's square is kept in one byte");
+_Static_assert(GAMELOG_INTERVAL >= 1 && GAMELOG_INTERVAL <= 255,
+	"a block's moves are indexed by a uint8_t");
+_Static_assert(GAMELOG_BLOCKS >= 1 && GAMELOG_BLOCKS <= 255,
+	"blocks are indexed by a uint8_t");
+
+// A position: a bitplane of the boxes, and the player's square.
+typedef struct
+{
+	uint16_t boxes[MATRIX_NUM_ROWS];	// Bit col set if a box is on (row, col)
+	uint8_t player;						// Row in the high nibble, column in
+										// the low
+} Snapshot;
+
+typedef struct
+{
+	Snapshot start;						// The position before the first move
+	uint16_t pushes;					// Pushes made before the first move
+	uint8_t moves[GAMELOG_INTERVAL];
+} Block;
+
+static Snapshot level_start;
+
+// A ring of blocks, the oldest at first_block. The oldest starts at
+// first_step, and each of the others GAMELOG_INTERVAL steps after the one
+// before, so the moves from first_step to last_step are all kept.
+static Block blocks[GAMELOG_BLOCKS];
+static uint8_t first_block;
+static uint16_t first_step;
+static uint16_t last_step;
+
+// The position at the current step.
+static Snapshot current;
+static uint16_t current_step;
+static uint16_t current_pushes;
+
+void gamelog_start(const LevelLayout *layout)
+{
+	memset(&level_start, 0, sizeof(level_start));
+	for (uint8_t row = 0; row < MATRIX_NUM_ROWS; row++)
+	{
+		for (uint8_t col = 0; col < MATRIX_NUM_COLUMNS; col++)
+		{
+			if (layout->board[row][col] & BOX)
+			{
+				level_start.boxes[row] |= (1U << col);
+			}
+		}
+	}
+	level_start.player = (layout->player_row << 4) | layout->player_col;
+	current = level_start;
+	current_step = 0;
+	current_pushes = 0;
+	first_block = 0;
+	first_step = 0;
+	last_step = 0;
+}
+
+// The block holding a step's move (or, at a multiple of GAMELOG_INTERVAL,
+// starting from the step). The step must be from first_step on.
+static Block *block_of(uint16_t step)
+{
+	uint8_t index = (step - first_step) / GAMELOG_INTERVAL;
+	return &blocks[(first_block + index) % GAMELOG_BLOCKS];
+}
+
+void gamelog_record(int8_t delta_row, int8_t delta_col, bool push)
+{
+	// Any moves after this step are of a line of play rewound away from.
+	last_step = current_step;
+	if (current_step < first_step)
+	{
+		// Rewound to the level start from past the oldest block, so none
+		// of the blocks are of this line of play.
+		first_step = 0;
+	}
+	if (current_step % GAMELOG_INTERVAL == 0)
+	{
+		// Start a new block, dropping the oldest if they are all used.
+		if (current_step - first_step == GAMELOG_BLOCKS * GAMELOG_INTERVAL)
+		{
+			first_block = (first_block + 1) % GAMELOG_BLOCKS;
+			first_step += GAMELOG_INTERVAL;
+		}
+		Block *block = block_of(current_step);
+		block->start = current;
+		block->pushes = current_pushes;
+	}
+	uint8_t row = current.player >> 4;
+	uint8_t col = current.player & 0x0F;
+	row = WRAP_ROW(row + delta_row);
+	col = WRAP_COL(col + delta_col);
+	if (push)
+	{
+		// The box moves on from the player's new square.
+		current.boxes[row] &= ~(1U << col);
+		current.boxes[WRAP_ROW(row + delta_row)] |=
+			(1U << WRAP_COL(col + delta_col));
+		current_pushes++;
+	}
+	current.player = (row << 4) | col;
+	block_of(current_step)->moves[current_step % GAMELOG_INTERVAL] =
+		((delta_row & MOVE_DELTA_MASK) << MOVE_ROW_SHIFT)
+		| (delta_col & MOVE_DELTA_MASK) | (push ? MOVE_PUSH : 0);
+	current_step++;
+	last_step = current_step;
+}
+
+// Gets a delta back from its two bits.
+static int8_t move_delta(uint8_t bits)
+{
+	bits &= MOVE_DELTA_MASK;
+	return (bits & 0x02) ? (int8_t)bits - 4 : (int8_t)bits;
+}
+
+// Makes a kept move on a position, or undoes it. A push is undone by
+// pulling the box back from the square in front of the player.
+static void replay(Snapshot *position, uint8_t move, bool undo)
+{
+	int8_t delta_row = move_delta(move >> MOVE_ROW_SHIFT);
+	int8_t delta_col = move_delta(move);
+	if (undo)
+	{
+		delta_row = -delta_row;
+		delta_col = -delta_col;
+	}
+	uint8_t row = position->player >> 4;
+	uint8_t col = position->player & 0x0F;
+	if (move & MOVE_PUSH)
+	{
+		// The box is in front of the player when undoing, and on the
+		// player's next square when making the move.
+		uint8_t box_row = WRAP_ROW(row + (undo ? -delta_row : delta_row));
+		uint8_t box_col = WRAP_COL(col + (undo ? -delta_col : delta_col));
+		position->boxes[box_row] ^= (1U << box_col);
+		box_row = WRAP_ROW(box_row + delta_row);
+		box_col = WRAP_COL(box_col + delta_col);
+		position->boxes[box_row] ^= (1U << box_col);
+	}
+	row = WRAP_ROW(row + delta_row);
+	col = WRAP_COL(col + delta_col);
+	position->player = (row << 4) | col;
+}
+
+bool gamelog_rewind(uint16_t step, RewindDiff *diff)
+{
+	if (step > last_step || (step < first_step && step != 0))
+	{
+		return false;
+	}
+
+	// Start from the current position, the level start or a snapshot,
+	// whichever is the fewest moves away.
+	Snapshot position = current;
+	uint16_t at = current_step;
+	uint16_t pushes = current_pushes;
+	uint16_t distance = (step > at) ? step - at : at - step;
+	if (step == 0)
+	{
+		position = level_start;
+		at = 0;
+		pushes = 0;
+	}
+	else
+	{
+		// A block is only started by its first move, so the last step may
+		// be the start of one that is not there yet.
+		uint16_t block_step = step - step % GAMELOG_INTERVAL;
+		if (block_step == last_step)
+		{
+			block_step -= GAMELOG_INTERVAL;
+		}
+		if (block_step >= first_step && step - block_step < distance)
+		{
+			const Block *block = block_of(block_step);
+			position = block->start;
+			at = block_step;
+			pushes = block->pushes;
+		}
+	}
+
+	while (at < step)
+	{
+		uint8_t move = block_of(at)->moves[at % GAMELOG_INTERVAL];
+		replay(&position, move, false);
+		pushes += (move & MOVE_PUSH) != 0;
+		at++;
+	}
+	while (at > step)
+	{
+		at--;
+		uint8_t move = block_of(at)->moves[at % GAMELOG_INTERVAL];
+		replay(&position, move, true);
+		pushes -= (move & MOVE_PUSH) != 0;
+	}
+
+	for (uint8_t row = 0; row < MATRIX_NUM_ROWS; row++)
+	{
+		diff->boxes[row] = position.boxes[row] ^ current.boxes[row];
+	}
+	diff->player_row = position.player >> 4;
+	diff->player_col = position.player & 0x0F;
+	diff->pushes = pushes;
+	current = position;
+	current_step = step;
+	current_pushes = pushes;
+	return true;
+}
+
+bool gamelog_move(uint16_t step, int8_t *delta_row, int8_t *delta_col)
+{
+	if (step < first_step || step >= last_step)
+	{
+		return false;
+	}
+	uint8_t move = block_of(step)->moves[step % GAMELOG_INTERVAL];
+	*delta_row = move_delta(move >> MOVE_ROW_SHIFT);
+	*delta_col = move_delta(move);
+	return true;
+}
+
+uint16_t gamelog_step(void)
+{
+	return current_step;
+}
+
+uint16_t gamelog_first_step(void)
+{
+	return first_step;
+}
+
+uint16_t gamelog_last_step(void)
+{
+	return last_step;
+}
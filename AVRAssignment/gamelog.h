@@ -0,0 +1,119 @@
+/*
+ * gamelog.h
+ *
+ * Author: Riley Stewart
+ *
+ * The game log: every move made in a level, kept so the game can be wound
+ * back (or forward again) to any step of it. A move is kept as one byte
+ * (its direction, and whether it pushed a box), and a move can be undone
+ * from the position after it, so winding back is a matter of undoing the
+ * moves in turn.
+ *
+ * Every GAMELOG_INTERVAL moves the log also keeps a snapshot of the
+ * position: a bitplane of the boxes (one bit per square) and the player's
+ * square. Walls and targets never move, so they are not kept. A rewind
+ * starts from whichever is closest to the step wanted of the position now,
+ * the snapshot at or before it, or the level start, so it never replays
+ * more than GAMELOG_INTERVAL moves however far it goes.
+ *
+ * The moves are kept in GAMELOG_BLOCKS blocks of GAMELOG_INTERVAL moves,
+ * each with the snapshot it starts from. When they are full the oldest
+ * block is dropped, so a move is only forgotten once it is at least
+ * (GAMELOG_BLOCKS - 1) * GAMELOG_INTERVAL moves back. The log uses
+ * GAMELOG_BLOCKS * (GAMELOG_INTERVAL + 19) + 43 bytes of RAM. The level
+ * start is kept on its own, so it can always be rewound to.
+ *
+ * A rewind does not change the board itself. It gives the difference
+ * between the position before and after (see RewindDiff), so the game only
+ * has to change and repaint the squares that differ.
+ *
+ * This module does not use any AVR hardware, so it can also be built on
+ * the host (see tools/).
+ */
+
+#ifndef GAMELOG_H_
+#define GAMELOG_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "levels.h"
+
+// Moves between snapshots. A rewind replays at most this many moves.
+#ifndef GAMELOG_INTERVAL
+#define GAMELOG_INTERVAL	(16)
+#endif
+
+// Blocks of GAMELOG_INTERVAL moves kept.
+#ifndef GAMELOG_BLOCKS
+#define GAMELOG_BLOCKS		(4)
+#endif
+
+// The difference between the position before a rewind and after it.
+typedef struct
+{
+	uint16_t boxes[MATRIX_NUM_ROWS];	// Bit col set if (row, col) gained
+										// or lost a box
+	uint8_t player_row;					// The player's square after
+	uint8_t player_col;
+	uint16_t pushes;					// Pushes made up to the step
+} RewindDiff;
+
+/// <summary>
+/// Starts the log for a new level (or a level changed by the editor),
+/// forgetting all moves before.
+/// </summary>
+/// <param name="layout">The position at the level start.</param>
+void gamelog_start(const LevelLayout *layout);
+
+/// <summary>
+/// Adds a move made from the position at the current step. Any moves kept
+/// after the current step (by rewinding back) are forgotten.
+/// </summary>
+/// <param name="delta_row">The row the player moved by (-1 to 1).</param>
+/// <param name="delta_col">The column the player moved by (-1 to 1).</param>
+/// <param name="push">Whether the player pushed the box in front of it.
+/// </param>
+void gamelog_record(int8_t delta_row, int8_t delta_col, bool push);
+
+/// <summary>
+/// Winds the log back or forward to a step, and gives the change in the
+/// position the game must make to match.
+/// </summary>
+/// <param name="step">The step (0 is the level start).</param>
+/// <param name="diff">Set to the change in the position.</param>
+/// <returns>Whether the step is still in the log. If not, nothing is
+/// changed.</returns>
+bool gamelog_rewind(uint16_t step, RewindDiff *diff);
+
+/// <summary>
+/// Gets a move kept in the log.
+/// </summary>
+/// <param name="step">The step the move was made from.</param>
+/// <param name="delta_row">Set to the row the player moved by.</param>
+/// <param name="delta_col">Set to the column the player moved by.</param>
+/// <returns>Whether the move is still in the log. If not, the deltas are
+/// not set.</returns>
+bool gamelog_move(uint16_t step, int8_t *delta_row, int8_t *delta_col);
+
+/// <summary>
+/// Gets the current step, the number of moves made since the level start
+/// less those rewound.
+/// </summary>
+/// <returns>The current step.</returns>
+uint16_t gamelog_step(void);
+
+/// <summary>
+/// Gets the earliest step that can be rewound to, apart from the level
+/// start.
+/// </summary>
+/// <returns>The earliest step kept.</returns>
+uint16_t gamelog_first_step(void);
+
+/// <summary>
+/// Gets the latest step that can be rewound to. It is after the current
+/// step if the log has been rewound back and no move made since.
+/// </summary>
+/// <returns>The latest step kept.</returns>
+uint16_t gamelog_last_step(void);
+
+#endif /* GAMELOG_H_ */
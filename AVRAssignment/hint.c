@@ -0,0 +1,566 @@
+/*
+ * hint.c
+ *
+ * Author: Riley Stewart
+ *
+ * The search is an iterative deepening A* (IDA*) over box pushes. The
+ * heuristic is the sum over all boxes of the number of pushes needed to get
+ * that box to its nearest target, ignoring the other boxes. That never
+ * over-estimates, so the first solution found has the fewest pushes. IDA*
+ * only needs the current path in memory, which is kept in an explicit stack
+ * rather than by recursion so the search can be stopped and resumed between
+ * nodes.
+ */
+
+#include "hint.h"
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include "game.h"
+#include "zobrist.h"
+
+#define NUM_CELLS	(MATRIX_NUM_ROWS * MATRIX_NUM_COLUMNS)
+
+// Squares are numbered row * MATRIX_NUM_COLUMNS + column, and each row of
+// the board is held as the bits of a uint16_t (bit n is column n).
+#define CELL(row, col)	((uint8_t)((row) * MATRIX_NUM_COLUMNS + (col)))
+#define CELL_ROW(cell)	((cell) / MATRIX_NUM_COLUMNS)
+#define CELL_COL(cell)	((cell) & (MATRIX_NUM_COLUMNS - 1))
+
+_Static_assert(MATRIX_NUM_COLUMNS == 16, "Board rows are held in a uint16_t");
+
+// Push distance of a square no box can be pushed to a target from.
+#define DEAD		(0xFF)
+#define NO_BOUND	(0xFFFF)
+
+// Push directions. The opposite of a direction is (direction ^ 1).
+#define DIR_UP		(0)
+#define DIR_DOWN	(1)
+#define DIR_RIGHT	(2)
+#define DIR_LEFT	(3)
+#define NUM_DIRS	(4)
+
+// One level of the search path: the push being tried from this node, which
+// is also the cursor for the next push to try when the search comes back.
+typedef struct
+{
+	uint8_t cell;
+	uint8_t dir;
+} SearchFrame;
+
+static HintStatus status = HINT_IDLE;
+static Hint result;
+
+// The answer of the last search that finished, and the position it was
+// for: the Zobrist hash of the boxes and player, and a hash of the walls
+// and targets made from the same keys. Asking again from that position
+// (e.g. after moving away and back, or undoing) gives the same answer
+// without searching again.
+static uint32_t search_position;
+static uint32_t search_layout;
+static uint32_t known_position;
+static uint32_t known_layout;
+static HintStatus known_status = HINT_IDLE;
+static Hint known_result;
+
+// The board being searched. Walls never change, boxes are moved as the
+// search goes down and back up the path.
+static uint16_t walls[MATRIX_NUM_ROWS];
+static uint16_t boxes[MATRIX_NUM_ROWS];
+
+// Squares the player can walk to without pushing anything, and whether it
+// is up to date for the current node.
+static uint16_t reach[MATRIX_NUM_ROWS];
+static bool reach_valid;
+
+// Pushes needed to get a box from each square to the nearest target.
+static uint8_t push_distance[NUM_CELLS];
+
+static SearchFrame path[HINT_MAX_PUSHES];
+static uint8_t depth;
+static uint8_t player_cell;
+static uint16_t total_distance;
+static uint16_t bound;
+static uint16_t next_bound;
+static uint32_t nodes;
+
+// The first push of the path that got closest to a solution (smallest
+// total distance, then fewest pushes), used if the search runs out of nodes.
+static uint8_t best_cell;
+static uint8_t best_dir;
+static uint16_t best_distance;
+static uint8_t best_depth;
+
+static bool test_bit(const uint16_t *rows, uint8_t cell)
+{
+	return (rows[CELL_ROW(cell)] & (1U << CELL_COL(cell))) != 0;
+}
+
+static void set_bit(uint16_t *rows, uint8_t cell)
+{
+	rows[CELL_ROW(cell)] |= (1U << CELL_COL(cell));
+}
+
+static void clear_bit(uint16_t *rows, uint8_t cell)
+{
+	rows[CELL_ROW(cell)] &= ~(1U << CELL_COL(cell));
+}
+
+// Gets the square next to a square, wrapping around the board edges in the
+// same way as player movement.
+static uint8_t neighbour(uint8_t cell, uint8_t dir)
+{
+	uint8_t row = CELL_ROW(cell);
+	uint8_t col = CELL_COL(cell);
+	switch (dir)
+	{
+		case DIR_UP:
+			row = WRAP_ROW(row + 1);
+			break;
+		case DIR_DOWN:
+			row = WRAP_ROW(row - 1);
+			break;
+		case DIR_RIGHT:
+			col = WRAP_COL(col + 1);
+			break;
+		default:
+			col = WRAP_COL(col - 1);
+			break;
+	}
+	return CELL(row, col);
+}
+
+// Works out push_distance by pulling boxes backwards from the targets. A
+// box can be pushed from square A to its neighbour B if neither A nor the
+// square behind A (where the player stands) is a wall.
+static void compute_push_distances(const LevelLayout *state)
+{
+	memset(push_distance, DEAD, sizeof(push_distance));
+	for (uint8_t row = 0; row < MATRIX_NUM_ROWS; row++)
+	{
+		for (uint8_t col = 0; col < MATRIX_NUM_COLUMNS; col++)
+		{
+			if (state->board[row][col] & TARGET)
+			{
+				push_distance[CELL(row, col)] = 0;
+			}
+		}
+	}
+	bool changed = true;
+	for (uint8_t distance = 0; changed; distance++)
+	{
+		changed = false;
+		for (uint8_t cell = 0; cell < NUM_CELLS; cell++)
+		{
+			if (push_distance[cell] != distance)
+			{
+				continue;
+			}
+			for (uint8_t dir = 0; dir < NUM_DIRS; dir++)
+			{
+				uint8_t box_from = neighbour(cell, dir ^ 1);
+				uint8_t player_from = neighbour(box_from, dir ^ 1);
+				if (push_distance[box_from] == DEAD
+					&& !test_bit(walls, box_from)
+					&& !test_bit(walls, player_from))
+				{
+					push_distance[box_from] = distance + 1;
+					changed = true;
+				}
+			}
+		}
+	}
+}
+
+// Flood fills reach from the player's square. Each pass grows every row
+// from the rows above and below it, then spreads it along the row.
+static void compute_reach(void)
+{
+	memset(reach, 0, sizeof(reach));
+	set_bit(reach, player_cell);
+	bool changed;
+	do
+	{
+		changed = false;
+		for (uint8_t row = 0; row < MATRIX_NUM_ROWS; row++)
+		{
+			uint16_t open = ~(walls[row] | boxes[row]);
+			uint16_t grown = (reach[row] | reach[WRAP_ROW(row + 1)]
+				| reach[WRAP_ROW(row - 1)]) & open;
+			uint16_t previous;
+			do
+			{
+				previous = grown;
+				grown |= (uint16_t)((grown << 1) | (grown >> 15)) & open;
+				grown |= (uint16_t)((grown >> 1) | (grown << 15)) & open;
+			} while (grown != previous);
+			if (grown != reach[row])
+			{
+				reach[row] = grown;
+				changed = true;
+			}
+		}
+	} while (changed);
+	reach_valid = true;
+}
+
+static bool is_blocked(uint8_t cell)
+{
+	return test_bit(walls, cell) || test_bit(boxes, cell);
+}
+
+// Checks whether the box on a square is now part of a 2x2 block of walls
+// and boxes. None of the boxes in such a block can ever be moved again, so
+// the position is lost unless they are all on targets.
+static bool is_frozen(uint8_t cell)
+{
+	for (uint8_t corner = 0; corner < 4; corner++)
+	{
+		uint8_t row = CELL_ROW(cell) - (corner & 1);
+		uint8_t col = CELL_COL(cell) - (corner >> 1);
+		bool blocked = true;
+		bool off_target = false;
+		for (uint8_t i = 0; i < 4 && blocked; i++)
+		{
+			uint8_t square = CELL(WRAP_ROW(row + (i & 1)),
+				WRAP_COL(col + (i >> 1)));
+			blocked = is_blocked(square);
+			if (test_bit(boxes, square) && push_distance[square] != 0)
+			{
+				off_target = true;
+			}
+		}
+		if (blocked && off_target)
+		{
+			return true;
+		}
+	}
+	return false;
+}
+
+// Checks whether the box on cell can be pushed in a direction from the
+// current node, and if so moves it. Returns the new total distance, or
+// NO_BOUND if the push is not possible.
+static uint16_t try_push(uint8_t cell, uint8_t dir)
+{
+	uint8_t to = neighbour(cell, dir);
+	if (!test_bit(reach, neighbour(cell, dir ^ 1)) || is_blocked(to)
+		|| push_distance[to] == DEAD)
+	{
+		return NO_BOUND;
+	}
+	clear_bit(boxes, cell);
+	set_bit(boxes, to);
+	if (is_frozen(to))
+	{
+		clear_bit(boxes, to);
+		set_bit(boxes, cell);
+		return NO_BOUND;
+	}
+	return total_distance - push_distance[cell] + push_distance[to];
+}
+
+static void undo_push(uint8_t cell, uint8_t dir)
+{
+	clear_bit(boxes, neighbour(cell, dir));
+	set_bit(boxes, cell);
+}
+
+static void finish(uint8_t cell, uint8_t dir, bool optimal)
+{
+	result.box_row = CELL_ROW(cell);
+	result.box_col = CELL_COL(cell);
+	result.delta_row = (dir == DIR_UP) - (dir == DIR_DOWN);
+	result.delta_col = (dir == DIR_RIGHT) - (dir == DIR_LEFT);
+	result.optimal = optimal;
+	status = HINT_READY;
+}
+
+// Ends the search without a proven solution, using the best looking push
+// from the starting position if there is one.
+static void give_up(void)
+{
+	if (best_distance == NO_BOUND)
+	{
+		status = HINT_STUCK;
+	}
+	else
+	{
+		finish(best_cell, best_dir, false);
+	}
+}
+
+// Expands one node: makes the next push from the current node that stays
+// within the bound and moves down to it, or moves back up the path if there
+// are no more pushes to try.
+static void expand_node(void)
+{
+	if (!reach_valid)
+	{
+		compute_reach();
+	}
+	SearchFrame *frame = &path[depth];
+	for (; frame->cell < NUM_CELLS; frame->cell++, frame->dir = 0)
+	{
+		if (!test_bit(boxes, frame->cell))
+		{
+			continue;
+		}
+		for (; frame->dir < NUM_DIRS; frame->dir++)
+		{
+			uint16_t distance = try_push(frame->cell, frame->dir);
+			if (distance == NO_BOUND)
+			{
+				continue;
+			}
+			if (distance == 0)
+			{
+				// Solved. The first push on the path is the hint.
+				finish(path[0].cell, path[0].dir, true);
+				return;
+			}
+			if (distance < best_distance
+				|| (distance == best_distance && depth < best_depth))
+			{
+				best_cell = path[0].cell;
+				best_dir = path[0].dir;
+				best_distance = distance;
+				best_depth = depth;
+			}
+			uint16_t cost = depth + 1 + distance;
+			if (cost > bound)
+			{
+				if (cost < next_bound)
+				{
+					next_bound = cost;
+				}
+				undo_push(frame->cell, frame->dir);
+				continue;
+			}
+			// Go down to the new node. The player is left where the box was.
+			player_cell = frame->cell;
+			total_distance = distance;
+			depth++;
+			path[depth].cell = 0;
+			path[depth].dir = 0;
+			reach_valid = false;
+			return;
+		}
+	}
+
+	if (depth == 0)
+	{
+		// Every path within the bound has been tried. Search again with the
+		// smallest bound that was exceeded.
+		if (next_bound == NO_BOUND)
+		{
+			status = HINT_STUCK;
+		}
+		else if (next_bound > HINT_MAX_PUSHES)
+		{
+			give_up();
+		}
+		else
+		{
+			bound = next_bound;
+			next_bound = NO_BOUND;
+			path[0].cell = 0;
+			path[0].dir = 0;
+		}
+		return;
+	}
+
+	// Go back up to the parent node and undo the push that led here.
+	depth--;
+	frame = &path[depth];
+	uint8_t to = neighbour(frame->cell, frame->dir);
+	undo_push(frame->cell, frame->dir);
+	total_distance = total_distance - push_distance[to]
+		+ push_distance[frame->cell];
+	player_cell = neighbour(frame->cell, frame->dir ^ 1);
+	frame->dir++;
+	reach_valid = false;
+}
+
+// Finds the push from the starting position with the smallest total
+// distance afterwards, so there is a fallback before the search has gone
+// any deeper.
+static void find_best_push(void)
+{
+	best_distance = NO_BOUND;
+	best_depth = 0;
+	for (uint8_t cell = 0; cell < NUM_CELLS; cell++)
+	{
+		if (!test_bit(boxes, cell))
+		{
+			continue;
+		}
+		for (uint8_t dir = 0; dir < NUM_DIRS; dir++)
+		{
+			uint16_t distance = try_push(cell, dir);
+			if (distance == NO_BOUND)
+			{
+				continue;
+			}
+			undo_push(cell, dir);
+			if (distance < best_distance)
+			{
+				best_distance = distance;
+				best_cell = cell;
+				best_dir = dir;
+			}
+		}
+	}
+}
+
+static void start_search(const LevelLayout *state)
+{
+	memset(walls, 0, sizeof(walls));
+	memset(boxes, 0, sizeof(boxes));
+	for (uint8_t row = 0; row < MATRIX_NUM_ROWS; row++)
+	{
+		for (uint8_t col = 0; col < MATRIX_NUM_COLUMNS; col++)
+		{
+			uint8_t object = state->board[row][col];
+			if (object & WALL)
+			{
+				set_bit(walls, CELL(row, col));
+			}
+			if (object & BOX)
+			{
+				set_bit(boxes, CELL(row, col));
+			}
+		}
+	}
+	player_cell = CELL(state->player_row, state->player_col);
+	compute_push_distances(state);
+
+	status = HINT_STUCK;
+	total_distance = 0;
+	for (uint8_t cell = 0; cell < NUM_CELLS; cell++)
+	{
+		if (test_bit(boxes, cell))
+		{
+			if (push_distance[cell] == DEAD)
+			{
+				return;
+			}
+			total_distance += push_distance[cell];
+		}
+	}
+	if (total_distance == 0)
+	{
+		// Already solved, there is nothing to hint.
+		return;
+	}
+
+	compute_reach();
+	find_best_push();
+	if (total_distance > HINT_MAX_PUSHES)
+	{
+		// Too far from a solution to search, go straight to the fallback.
+		give_up();
+		return;
+	}
+	depth = 0;
+	path[0].cell = 0;
+	path[0].dir = 0;
+	bound = total_distance;
+	next_bound = NO_BOUND;
+	nodes = 0;
+	status = HINT_SEARCHING;
+}
+
+// Hashes the parts of a level that never move.
+static uint32_t hash_layout(const LevelLayout *state)
+{
+	uint32_t hash = 0;
+	for (uint8_t row = 0; row < MATRIX_NUM_ROWS; row++)
+	{
+		for (uint8_t col = 0; col < MATRIX_NUM_COLUMNS; col++)
+		{
+			if (state->board[row][col] & WALL)
+			{
+				hash ^= zobrist_box(row, col);
+			}
+			if (state->board[row][col] & TARGET)
+			{
+				hash ^= zobrist_player(row, col);
+			}
+		}
+	}
+	return hash;
+}
+
+// Keeps the answer of a search that has just finished.
+static void remember_answer(void)
+{
+	if (status == HINT_READY || status == HINT_STUCK)
+	{
+		known_position = search_position;
+		known_layout = search_layout;
+		known_status = status;
+		known_result = result;
+	}
+}
+
+void hint_start(const LevelLayout *state)
+{
+	search_position = zobrist_hash(state);
+	search_layout = hash_layout(state);
+	if (known_status != HINT_IDLE && search_position == known_position
+		&& search_layout == known_layout)
+	{
+		status = known_status;
+		result = known_result;
+		nodes = 0;
+		return;
+	}
+	start_search(state);
+	remember_answer();
+}
+
+HintStatus hint_step(void)
+{
+	for (uint8_t i = 0; i < HINT_NODES_PER_STEP && status == HINT_SEARCHING;
+		i++)
+	{
+		if (nodes >= HINT_NODE_LIMIT)
+		{
+			give_up();
+			break;
+		}
+		expand_node();
+		nodes++;
+	}
+	if (status != HINT_SEARCHING)
+	{
+		remember_answer();
+	}
+	return status;
+}
+
+HintStatus hint_status(void)
+{
+	return status;
+}
+
+bool hint_get(Hint *hint)
+{
+	if (status != HINT_READY)
+	{
+		return false;
+	}
+	*hint = result;
+	return true;
+}
+
+uint32_t hint_nodes_searched(void)
+{
+	return nodes;
+}
+
+void hint_cancel(void)
+{
+	status = HINT_IDLE;
+}
\ No newline at end of file
@@ -0,0 +1,94 @@
+/*
+ * hint.h
+ *
+ * Author: Riley Stewart
+ *
+ * Hint search. Finds the next box push towards a solution of the current
+ * board using an iterative deepening search over box pushes. The search
+ * is run a few nodes at a time by calling hint_step() from the main loop,
+ * so input and display stay responsive while it runs.
+ *
+ * This module only works on a copy of the board and does not use any AVR
+ * hardware, so it can also be built on the host (see tools/).
+ */
+
+#ifndef HINT_H_
+#define HINT_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "levels.h"
+
+// Number of search nodes expanded by each call to hint_step().
+#define HINT_NODES_PER_STEP	(4)
+
+// The search gives up on finding a push-optimal solution after this many
+// nodes, and instead hints the first push of the path that got closest to
+// a solution.
+#ifndef HINT_NODE_LIMIT
+#define HINT_NODE_LIMIT		(20000UL)
+#endif
+
+// The longest solution (in pushes) the search will look for.
+#define HINT_MAX_PUSHES		(32)
+
+typedef enum
+{
+	HINT_IDLE,		// No search has been started (or it was cancelled)
+	HINT_SEARCHING,	// Search in progress, keep calling hint_step()
+	HINT_READY,		// A hint is available from hint_get()
+	HINT_STUCK		// No push from this position leads to a solution
+} HintStatus;
+
+typedef struct
+{
+	uint8_t box_row;
+	uint8_t box_col;
+	int8_t delta_row;
+	int8_t delta_col;
+	// True if the push starts a solution with the fewest pushes, false if
+	// the node limit was reached and this is only the best looking push.
+	bool optimal;
+} Hint;
+
+/// <summary>
+/// Starts a hint search from a game state. Any search already running is
+/// abandoned. If the position is the same as the last search to finish
+/// was for, that search's answer is given straight away (the status is
+/// HINT_READY or HINT_STUCK without any calls to hint_step()).
+/// </summary>
+/// <param name="state">The board and player position to search from.</param>
+void hint_start(const LevelLayout *state);
+
+/// <summary>
+/// Runs the next slice of the hint search (HINT_NODES_PER_STEP nodes).
+/// </summary>
+/// <returns>The search status after this slice.</returns>
+HintStatus hint_step(void);
+
+/// <summary>
+/// Gets the status of the hint search.
+/// </summary>
+/// <returns>The search status.</returns>
+HintStatus hint_status(void);
+
+/// <summary>
+/// Gets the hint found by the search.
+/// </summary>
+/// <param name="hint">Filled in with the push to make.</param>
+/// <returns>Whether a hint is available (status is HINT_READY).</returns>
+bool hint_get(Hint *hint);
+
+/// <summary>
+/// Gets the number of nodes expanded by the current (or last) search.
+/// </summary>
+/// <returns>The number of nodes expanded.</returns>
+uint32_t hint_nodes_searched(void);
+
+/// <summary>
+/// Abandons the hint search and discards any hint. The status becomes
+/// HINT_IDLE.
+/// </summary>
+void hint_cancel(void);
+
+#endif /* HINT_H_ */
\ No newline at end of file
@@ -0,0 +1,396 @@
+/*
+ * input.c
+ *
+ * Author: Riley Stewart
+ */
+
+#include "input.h"
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <string.h>
+#include <avr/eeprom.h>
+#include <avr/pgmspace.h>
+#include <util/crc16.h>
+
+// One key map entry per letter
+#define NUM_KEYS	(26)
+
+// Changed whenever the layout of StoredInput changes, so settings saved in
+// an older format are not loaded.
+#define STORED_VERSION	(1)
+
+// The ADC's range
+#define ADC_MAX	(1023)
+
+typedef struct
+{
+	uint16_t centre[2];		// Reading at rest, on each axis
+	uint16_t low[2];		// Lowest reading, on each axis
+	uint16_t high[2];		// Highest reading, on each axis
+	uint8_t deadzone;		// In 128ths of the full deflection
+	uint8_t threshold;
+	uint8_t hysteresis;
+	uint8_t calibrated;		// Whether the above came from a calibration
+} JoystickProfile;
+
+typedef struct
+{
+	uint8_t version;
+	uint8_t keys[NUM_KEYS];
+	JoystickProfile joystick;
+	uint8_t crc;			// CRC-8 of the bytes before it
+} StoredInput;
+
+static StoredInput EEMEM stored_input;
+
+// Indexed by letter
+static const uint8_t default_keys[NUM_KEYS] PROGMEM =
+{
+	['a' - 'a'] = ACTION_LEFT,
+	['c' - 'a'] = ACTION_PALETTE,
+	['d' - 'a'] = ACTION_RIGHT,
+	['h' - 'a'] = ACTION_HINT,
+	['m' - 'a'] = ACTION_MEMORY,
+	['p' - 'a'] = ACTION_PAUSE,
+	['q' - 'a'] = ACTION_SOUND,
+	['r' - 'a'] = ACTION_RESTART,
+	['s' - 'a'] = ACTION_DOWN,
+	['t' - 'a'] = ACTION_THEME,
+	['w' - 'a'] = ACTION_UP,
+	['x' - 'a'] = ACTION_TELEMETRY,
+	['z' - 'a'] = ACTION_UNDO
+};
+
+// Indexed by button
+static const uint8_t button_actions[NUM_BUTTONS] PROGMEM =
+{
+	ACTION_RIGHT, ACTION_DOWN, ACTION_UP, ACTION_LEFT
+};
+
+static const char name_none[] PROGMEM = "nothing";
+static const char name_up[] PROGMEM = "up";
+static const char name_down[] PROGMEM = "down";
+static const char name_left[] PROGMEM = "left";
+static const char name_right[] PROGMEM = "right";
+static const char name_undo[] PROGMEM = "undo";
+static const char name_pause[] PROGMEM = "pause";
+static const char name_sound[] PROGMEM = "sound on/off";
+static const char name_hint[] PROGMEM = "hint";
+static const char name_theme[] PROGMEM = "colour theme";
+static const char name_palette[] PROGMEM = "terminal palette";
+static const char name_telemetry[] PROGMEM = "telemetry on/off";
+static const char name_memory[] PROGMEM = "memory report";
+static const char name_restart[] PROGMEM = "restart level";
+
+// Indexed by Action
+static const char *const action_names[NUM_ACTIONS] PROGMEM =
+{
+	name_none, name_up, name_down, name_left, name_right, name_undo,
+	name_pause, name_sound, name_hint, name_theme, name_palette,
+	name_telemetry, name_memory, name_restart
+};
+
+static uint8_t keys[NUM_KEYS];
+static JoystickProfile profile;
+
+// Deflection per ADC count, in 32768ths, below and above the centre of
+// each axis. Worked out once from the profile, so scaling a reading needs
+// no division.
+#define SCALE_SHIFT	(15)
+static uint16_t scale_low[2];
+static uint16_t scale_high[2];
+
+// How far each axis is engaged: 0, 1 (past the deadzone) or 2 (past the
+// threshold), negative if below the centre.
+static int8_t engaged[2];
+
+// The calibration in progress.
+static uint16_t calibration_centre[2];
+static uint16_t calibration_low[2];
+static uint16_t calibration_high[2];
+
+static uint8_t stored_crc(const StoredInput *stored)
+{
+	const uint8_t *bytes = (const uint8_t *)stored;
+	uint8_t crc = 0;
+	for (uint8_t i = 0; i < offsetof(StoredInput, crc); i++)
+	{
+		crc = _crc8_ccitt_update(crc, bytes[i]);
+	}
+	return crc;
+}
+
+// The scale for a span of readings, with a full deflection of 128 (so the
+// deflection is in 128ths, as the thresholds are). Spans too small for a
+// uint16_t scale only happen with a badly centred uncalibrated joystick,
+// which is given the largest scale instead.
+static uint16_t span_scale(uint16_t span)
+{
+	uint32_t scale = (128UL << SCALE_SHIFT) / (span ? span : 1);
+	return scale <= UINT16_MAX ? scale : UINT16_MAX;
+}
+
+static void update_scales(void)
+{
+	for (uint8_t axis = 0; axis < 2; axis++)
+	{
+		scale_low[axis] = span_scale(profile.centre[axis] - profile.low[axis]);
+		scale_high[axis] = span_scale(profile.high[axis] - profile.centre[axis]);
+		engaged[axis] = 0;
+	}
+}
+
+void init_input(void)
+{
+	StoredInput stored;
+	eeprom_read_block(&stored, &stored_input, sizeof(stored));
+	if (stored.version == STORED_VERSION && stored.crc == stored_crc(&stored))
+	{
+		for (uint8_t i = 0; i < NUM_KEYS; i++)
+		{
+			keys[i] = stored.keys[i];
+		}
+		profile = stored.joystick;
+		update_scales();
+	}
+	else
+	{
+		input_restore_defaults();
+	}
+}
+
+void input_save(void)
+{
+	StoredInput stored;
+	memset(&stored, 0, sizeof(stored));
+	stored.version = STORED_VERSION;
+	for (uint8_t i = 0; i < NUM_KEYS; i++)
+	{
+		stored.keys[i] = keys[i];
+	}
+	stored.joystick = profile;
+	stored.crc = stored_crc(&stored);
+	eeprom_update_block(&stored, &stored_input, sizeof(stored));
+}
+
+void input_restore_defaults(void)
+{
+	for (uint8_t i = 0; i < NUM_KEYS; i++)
+	{
+		keys[i] = pgm_read_byte(&default_keys[i]);
+	}
+	for (uint8_t axis = 0; axis < 2; axis++)
+	{
+		profile.centre[axis] = (ADC_MAX + 1) / 2;
+		profile.low[axis] = 0;
+		profile.high[axis] = ADC_MAX;
+	}
+	profile.deadzone = INPUT_DEFAULT_DEADZONE;
+	profile.threshold = INPUT_DEFAULT_THRESHOLD;
+	profile.hysteresis = INPUT_DEFAULT_HYSTERESIS;
+	profile.calibrated = false;
+	update_scales();
+}
+
+// The key map index of a key, or NUM_KEYS if it is not a letter. Setting
+// bit 5 makes an upper case letter lower case, and leaves no other
+// character a letter.
+static uint8_t key_index(int key)
+{
+	if (key < 0)
+	{
+		return NUM_KEYS;
+	}
+	uint8_t index = (uint8_t)((key | 0x20) - 'a');
+	return index < NUM_KEYS ? index : NUM_KEYS;
+}
+
+Action input_key_action(int key)
+{
+	uint8_t index = key_index(key);
+	return index < NUM_KEYS ? keys[index] : ACTION_NONE;
+}
+
+Action input_button_action(ButtonState button)
+{
+	if (button < 0 || button >= NUM_BUTTONS)
+	{
+		return ACTION_NONE;
+	}
+	return pgm_read_byte(&button_actions[button]);
+}
+
+bool input_bind(int key, Action action)
+{
+	uint8_t index = key_index(key);
+	if (index == NUM_KEYS || action >= NUM_ACTIONS)
+	{
+		return false;
+	}
+	keys[index] = action;
+	return true;
+}
+
+char input_action_key(Action action)
+{
+	for (uint8_t i = 0; i < NUM_KEYS; i++)
+	{
+		if (keys[i] == action)
+		{
+			return 'a' + i;
+		}
+	}
+	return 0;
+}
+
+const char *input_action_name(Action action)
+{
+	const char *name;
+	memcpy_P(&name, &action_names[action < NUM_ACTIONS ? action : 0],
+		sizeof(name));
+	return name;
+}
+
+void input_joystick_at_rest(uint16_t x, uint16_t y)
+{
+	if (!profile.calibrated)
+	{
+		profile.centre[0] = x;
+		profile.centre[1] = y;
+		update_scales();
+	}
+}
+
+int8_t input_joystick_deflection(uint8_t axis, uint16_t value)
+{
+	uint16_t centre = profile.centre[axis];
+	uint32_t scaled;
+	if (value >= centre)
+	{
+		scaled = ((uint32_t)(value - centre) * scale_high[axis]) >> SCALE_SHIFT;
+		return scaled < 127 ? scaled : 127;
+	}
+	scaled = ((uint32_t)(centre - value) * scale_low[axis]) >> SCALE_SHIFT;
+	return scaled < 127 ? -(int8_t)scaled : -127;
+}
+
+// Works out how far an axis is engaged by a deflection. An axis held the
+// same way keeps its level until the deflection drops the hysteresis below
+// what it took to get there.
+static int8_t engage(int8_t level, int8_t deflection)
+{
+	int8_t sign = (deflection < 0) ? -1 : 1;
+	uint8_t magnitude = (deflection < 0) ? -deflection : deflection;
+	uint8_t held = (level * sign > 0) ? level * sign : 0;
+	if (magnitude >= profile.threshold
+		|| (held == 2 && magnitude + profile.hysteresis >= profile.threshold))
+	{
+		return 2 * sign;
+	}
+	if (magnitude >= profile.deadzone
+		|| (held >= 1 && magnitude + profile.hysteresis >= profile.deadzone))
+	{
+		return sign;
+	}
+	return 0;
+}
+
+void input_joystick(uint16_t x, uint16_t y, int8_t *delta_row,
+	int8_t *delta_col)
+{
+	engaged[0] = engage(engaged[0], input_joystick_deflection(0, x));
+	engaged[1] = engage(engaged[1], input_joystick_deflection(1, y));
+	int8_t sign_x = (engaged[0] > 0) - (engaged[0] < 0);
+	int8_t sign_y = (engaged[1] > 0) - (engaged[1] < 0);
+	*delta_row = 0;
+	*delta_col = 0;
+	if (sign_x && sign_y)
+	{
+		// Both axes past the deadzone: a diagonal.
+		*delta_row = sign_y;
+		*delta_col = sign_x;
+	}
+	else if (engaged[0] == 2 || engaged[0] == -2)
+	{
+		*delta_col = sign_x;
+	}
+	else if (engaged[1] == 2 || engaged[1] == -2)
+	{
+		*delta_row = sign_y;
+	}
+}
+
+void input_get_thresholds(uint8_t *deadzone, uint8_t *threshold,
+	uint8_t *hysteresis)
+{
+	*deadzone = profile.deadzone;
+	*threshold = profile.threshold;
+	*hysteresis = profile.hysteresis;
+}
+
+bool input_set_thresholds(uint8_t deadzone, uint8_t threshold,
+	uint8_t hysteresis)
+{
+	if (hysteresis >= deadzone || deadzone > threshold || threshold > 127)
+	{
+		return false;
+	}
+	profile.deadzone = deadzone;
+	profile.threshold = threshold;
+	profile.hysteresis = hysteresis;
+	return true;
+}
+
+void input_calibrate_start(uint16_t x, uint16_t y)
+{
+	calibration_centre[0] = x;
+	calibration_centre[1] = y;
+	for (uint8_t axis = 0; axis < 2; axis++)
+	{
+		calibration_low[axis] = calibration_centre[axis];
+		calibration_high[axis] = calibration_centre[axis];
+	}
+}
+
+void input_calibrate_sample(uint16_t x, uint16_t y)
+{
+	uint16_t value[2] = { x, y };
+	for (uint8_t axis = 0; axis < 2; axis++)
+	{
+		if (value[axis] < calibration_low[axis])
+		{
+			calibration_low[axis] = value[axis];
+		}
+		if (value[axis] > calibration_high[axis])
+		{
+			calibration_high[axis] = value[axis];
+		}
+	}
+}
+
+bool input_calibrate_finish(void)
+{
+	for (uint8_t axis = 0; axis < 2; axis++)
+	{
+		if (calibration_centre[axis] - calibration_low[axis] < INPUT_MIN_SPAN
+			|| calibration_high[axis] - calibration_centre[axis] < INPUT_MIN_SPAN)
+		{
+			return false;
+		}
+	}
+	for (uint8_t axis = 0; axis < 2; axis++)
+	{
+		profile.centre[axis] = calibration_centre[axis];
+		profile.low[axis] = calibration_low[axis];
+		profile.high[axis] = calibration_high[axis];
+	}
+	profile.calibrated = true;
+	update_scales();
+	return true;
+}
+
+bool input_is_calibrated(void)
+{
+	return profile.calibrated;
+}
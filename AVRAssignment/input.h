@@ -0,0 +1,199 @@
+/*
+ * input.h
+ *
+ * Author: Riley Stewart
+ *
+ * Input mapping. Keys and buttons are turned into game actions by lookup
+ * tables, and joystick readings into directions by a calibrated model, so
+ * the game loop only has to act on the result.
+ *
+ * The key map gives an action to each letter (either case), so a key is
+ * looked up with one index instead of being compared with every binding.
+ *
+ * Joystick readings are scaled to a deflection from -127 to 127 on each
+ * axis, using the centre and the extents found by calibration (or the
+ * centre sampled at rest, and the ADC's full range, if the joystick has not
+ * been calibrated). An axis engages past the deadzone, enough for a
+ * diagonal, and past the threshold for a move along it, and only lets go
+ * once it drops the hysteresis back below either, so a joystick held near
+ * a threshold does not chatter.
+ *
+ * The key map and the joystick profile are kept in EEPROM, with a CRC so
+ * that a blank or half written copy is never used.
+ */
+
+#ifndef INPUT_H_
+#define INPUT_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "buttons.h"
+
+typedef enum
+{
+	ACTION_NONE,
+	ACTION_UP,
+	ACTION_DOWN,
+	ACTION_LEFT,
+	ACTION_RIGHT,
+	ACTION_UNDO,
+	ACTION_PAUSE,
+	ACTION_SOUND,
+	ACTION_HINT,
+	ACTION_THEME,
+	ACTION_PALETTE,
+	ACTION_TELEMETRY,
+	ACTION_MEMORY,
+	ACTION_RESTART,
+	NUM_ACTIONS
+} Action;
+
+// The default deadzone, threshold and hysteresis, in 128ths of the full
+// deflection. They match the fixed ADC thresholds used before (200 and 400
+// of the 512 either side of the centre).
+#define INPUT_DEFAULT_DEADZONE		(50)
+#define INPUT_DEFAULT_THRESHOLD		(100)
+#define INPUT_DEFAULT_HYSTERESIS	(12)
+
+// The least a calibration must find the joystick moves either side of the
+// centre on each axis, in ADC counts.
+#define INPUT_MIN_SPAN	(128)
+
+/// <summary>
+/// Loads the key map and joystick profile from EEPROM, or the defaults if
+/// none have been saved.
+/// </summary>
+void init_input(void);
+
+/// <summary>
+/// Saves the key map and joystick profile to EEPROM. Only the bytes that
+/// change are written.
+/// </summary>
+void input_save(void);
+
+/// <summary>
+/// Restores the default key map and joystick profile (not saved until
+/// input_save() is called).
+/// </summary>
+void input_restore_defaults(void);
+
+/// <summary>
+/// Looks up the action bound to a key.
+/// </summary>
+/// <param name="key">The key, as read from the serial port (or -1 for no
+/// key).</param>
+/// <returns>The action, or ACTION_NONE if the key is not bound.</returns>
+Action input_key_action(int key);
+
+/// <summary>
+/// Looks up the action of a button.
+/// </summary>
+/// <param name="button">The button pushed, or NO_BUTTON_PUSHED.</param>
+/// <returns>The action, or ACTION_NONE.</returns>
+Action input_button_action(ButtonState button);
+
+/// <summary>
+/// Binds a key to an action. The key's old action is left with whatever
+/// other keys it has.
+/// </summary>
+/// <param name="key">The key (a letter, in either case).</param>
+/// <param name="action">The action, or ACTION_NONE to unbind the key.</param>
+/// <returns>Whether the key could be bound (i.e. it is a letter).</returns>
+bool input_bind(int key, Action action);
+
+/// <summary>
+/// Finds the first key bound to an action.
+/// </summary>
+/// <param name="action">The action.</param>
+/// <returns>The key, as a lower case letter, or 0 if none is.</returns>
+char input_action_key(Action action);
+
+/// <summary>
+/// Gets the name of an action, for showing the key map.
+/// </summary>
+/// <param name="action">The action.</param>
+/// <returns>The name, in program memory.</returns>
+const char *input_action_name(Action action);
+
+/// <summary>
+/// Tells the model the joystick is at rest. If it has not been calibrated,
+/// the reading is taken as its centre.
+/// </summary>
+/// <param name="x">The x axis reading.</param>
+/// <param name="y">The y axis reading.</param>
+void input_joystick_at_rest(uint16_t x, uint16_t y);
+
+/// <summary>
+/// Scales a joystick reading to a deflection.
+/// </summary>
+/// <param name="axis">The axis (0 = x, 1 = y).</param>
+/// <param name="value">The reading.</param>
+/// <returns>The deflection, from -127 to 127.</returns>
+int8_t input_joystick_deflection(uint8_t axis, uint16_t value);
+
+/// <summary>
+/// Turns a joystick reading into a direction, with the engagement of each
+/// axis carried over from the last reading. Should be called with every
+/// reading, whether or not the direction is used.
+/// </summary>
+/// <param name="x">The x axis reading.</param>
+/// <param name="y">The y axis reading.</param>
+/// <param name="delta_row">Set to the row delta (1 is up).</param>
+/// <param name="delta_col">Set to the column delta (1 is right).</param>
+void input_joystick(uint16_t x, uint16_t y, int8_t *delta_row,
+	int8_t *delta_col);
+
+/// <summary>
+/// Gets the deadzone, threshold and hysteresis, in 128ths of the full
+/// deflection.
+/// </summary>
+/// <param name="deadzone">Set to the deadzone.</param>
+/// <param name="threshold">Set to the threshold.</param>
+/// <param name="hysteresis">Set to the hysteresis.</param>
+void input_get_thresholds(uint8_t *deadzone, uint8_t *threshold,
+	uint8_t *hysteresis);
+
+/// <summary>
+/// Sets the deadzone, threshold and hysteresis (not saved until
+/// input_save() is called). All are in 128ths of the full deflection.
+/// </summary>
+/// <param name="deadzone">The deflection at which an axis engages enough
+/// for a diagonal move.</param>
+/// <param name="threshold">The deflection at which an axis engages for a
+/// move along it (at least the deadzone).</param>
+/// <param name="hysteresis">How far an engaged axis must drop below
+/// the deadzone or threshold to let go (less than the deadzone).</param>
+/// <returns>Whether the values were valid and set.</returns>
+bool input_set_thresholds(uint8_t deadzone, uint8_t threshold,
+	uint8_t hysteresis);
+
+/// <summary>
+/// Starts calibrating the joystick.
+/// </summary>
+/// <param name="x">The x axis reading at rest.</param>
+/// <param name="y">The y axis reading at rest.</param>
+void input_calibrate_start(uint16_t x, uint16_t y);
+
+/// <summary>
+/// Adds a reading to the calibration, taken while the joystick is moved
+/// around its edge.
+/// </summary>
+/// <param name="x">The x axis reading.</param>
+/// <param name="y">The y axis reading.</param>
+void input_calibrate_sample(uint16_t x, uint16_t y);
+
+/// <summary>
+/// Ends the calibration, and uses it if the joystick moved at least
+/// INPUT_MIN_SPAN either side of the centre on both axes (not saved until
+/// input_save() is called).
+/// </summary>
+/// <returns>Whether the calibration was used.</returns>
+bool input_calibrate_finish(void);
+
+/// <summary>
+/// Gets whether the joystick has been calibrated.
+/// </summary>
+/// <returns>Whether the joystick profile came from a calibration.</returns>
+bool input_is_calibrated(void);
+
+#endif /* INPUT_H_ */
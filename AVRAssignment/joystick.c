@@ -24,4 +24,18 @@ void init_joystick(void) {
 	ADCSRA = (1<<ADEN)|(1<<ADPS2)|(1<<ADPS1);
 	
 	
-}
\ No newline at end of file
+}
+
+uint16_t read_joystick_axis(uint8_t axis) {
+	if (axis) {
+		ADMUX |= 1;
+	} else {
+		ADMUX &= ~1;
+	}
+	// Start the ADC conversion
+	ADCSRA |= (1<<ADSC);
+	while(ADCSRA & (1<<ADSC)) {
+		; /* Wait until conversion finished */
+	}
+	return ADC; // read the value
+}
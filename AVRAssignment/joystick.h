@@ -5,4 +5,18 @@
  *  Author: riley
  */ 
 
-void init_joystick(void);
\ No newline at end of file
+#ifndef JOYSTICK_H_
+#define JOYSTICK_H_
+
+#include <stdint.h>
+
+void init_joystick(void);
+
+/// <summary>
+/// Reads one joystick axis with the ADC, waiting for the conversion.
+/// </summary>
+/// <param name="axis">The axis (0 = x, 1 = y).</param>
+/// <returns>The reading, from 0 to 1023.</returns>
+uint16_t read_joystick_axis(uint8_t axis);
+
+#endif /* JOYSTICK_H_ */
@@ -6,8 +6,10 @@
 
 #include "ledmatrix.h"
 #include <stdint.h>
+#include <stdbool.h>
 #include "spi.h"
 #include "pixel_colour.h"
+#include "termview.h"
 
 #define CMD_UPDATE_ALL		(0x00)
 #define CMD_UPDATE_PIXEL	(0x01)
@@ -16,15 +18,76 @@
 #define CMD_SHIFT_DISPLAY	(0x04)
 #define CMD_CLEAR_SCREEN	(0x0F)
 
+// In headless mode nothing is sent over SPI, and the image is drawn by the
+// terminal view instead. Building with LEDMATRIX_HEADLESS defined makes
+// this permanent, and leaves the SPI code out.
+#ifdef LEDMATRIX_HEADLESS
+#define headless	(true)
+#else
+static bool headless;
+#endif
+
+// Shifts the terminal view's image by one pixel. The row or column shifted
+// in is blank, as on the matrix.
+static void shift_view(int8_t delta_row, int8_t delta_col)
+{
+	for (uint8_t i = 0; i < MATRIX_NUM_ROWS; i++)
+	{
+		uint8_t row = (delta_row > 0) ? MATRIX_NUM_ROWS - 1 - i : i;
+		for (uint8_t j = 0; j < MATRIX_NUM_COLUMNS; j++)
+		{
+			uint8_t col = (delta_col > 0) ? MATRIX_NUM_COLUMNS - 1 - j : j;
+			uint8_t from_row = row - delta_row;
+			uint8_t from_col = col - delta_col;
+			PixelColour colour = COLOUR_BLACK;
+			if (from_row < MATRIX_NUM_ROWS && from_col < MATRIX_NUM_COLUMNS)
+			{
+				colour = termview_get_pixel(from_row, from_col);
+			}
+			termview_set_pixel(row, col, colour);
+		}
+	}
+}
+
 void init_ledmatrix(void)
 {
+	if (headless)
+	{
+		return;
+	}
 	// Setup SPI, with a clock devider of 128. This speed guarantees the
 	// SPI buffer will never overflow on the LED matrix.
 	spi_setup_master(128);
 }
 
+void ledmatrix_set_headless(bool enable)
+{
+#ifndef LEDMATRIX_HEADLESS
+	headless = enable;
+#else
+	(void)enable;
+#endif
+	termview_invalidate();
+}
+
+bool ledmatrix_is_headless(void)
+{
+	return headless;
+}
+
 void ledmatrix_update_all(MatrixData data)
 {
+	if (headless)
+	{
+		for (uint8_t row = 0; row < MATRIX_NUM_ROWS; row++)
+		{
+			for (uint8_t col = 0; col < MATRIX_NUM_COLUMNS; col++)
+			{
+				termview_set_pixel(row, col, data[row][col]);
+			}
+		}
+		return;
+	}
 	(void)spi_send_byte(CMD_UPDATE_ALL);
 	for (uint8_t row = 0; row < MATRIX_NUM_ROWS; row++)
 	{
@@ -35,6 +98,28 @@ void ledmatrix_update_all(MatrixData data)
 	}
 }
 
+void ledmatrix_update_all_from(PixelColour (*colour)(uint8_t row, uint8_t col))
+{
+	if (!headless)
+	{
+		(void)spi_send_byte(CMD_UPDATE_ALL);
+	}
+	for (uint8_t row = 0; row < MATRIX_NUM_ROWS; row++)
+	{
+		for (uint8_t col = 0; col < MATRIX_NUM_COLUMNS; col++)
+		{
+			if (headless)
+			{
+				termview_set_pixel(row, col, colour(row, col));
+			}
+			else
+			{
+				(void)spi_send_byte(colour(row, col));
+			}
+		}
+	}
+}
+
 void ledmatrix_update_pixel(uint8_t row, uint8_t col, PixelColour pixel)
 {
 	if (col >= MATRIX_NUM_COLUMNS || row >= MATRIX_NUM_ROWS)
@@ -42,6 +127,11 @@ void ledmatrix_update_pixel(uint8_t row, uint8_t col, PixelColour pixel)
 		// Invalid location, ignore the request.
 		return;
 	}
+	if (headless)
+	{
+		termview_set_pixel(row, col, pixel);
+		return;
+	}
 	(void)spi_send_byte(CMD_UPDATE_PIXEL);
 	(void)spi_send_byte(((row & 0x07) << 4) | (col & 0x0F));
 	(void)spi_send_byte(pixel);
@@ -54,6 +144,14 @@ void ledmatrix_update_row(uint8_t row, MatrixRow data)
 		// Invalid row number, ignore the request.
 		return;
 	}
+	if (headless)
+	{
+		for (uint8_t col = 0; col < MATRIX_NUM_COLUMNS; col++)
+		{
+			termview_set_pixel(row, col, data[col]);
+		}
+		return;
+	}
 	(void)spi_send_byte(CMD_UPDATE_ROW);
 	(void)spi_send_byte(row & 0x07);
 	for (uint8_t col = 0; col < MATRIX_NUM_COLUMNS; col++)
@@ -69,6 +167,14 @@ void ledmatrix_update_column(uint8_t col, MatrixColumn data)
 		// Invalid column number, ignore the request.
 		return;
 	}
+	if (headless)
+	{
+		for (uint8_t row = 0; row < MATRIX_NUM_ROWS; row++)
+		{
+			termview_set_pixel(row, col, data[row]);
+		}
+		return;
+	}
 	(void)spi_send_byte(CMD_UPDATE_COL);
 	(void)spi_send_byte(col & 0x0F);
 	for (uint8_t row = 0; row < MATRIX_NUM_ROWS; row++)
@@ -79,30 +185,61 @@ void ledmatrix_update_column(uint8_t col, MatrixColumn data)
 
 void ledmatrix_shift_display_left(void)
 {
+	if (headless)
+	{
+		shift_view(0, -1);
+		return;
+	}
 	(void)spi_send_byte(CMD_SHIFT_DISPLAY);
 	(void)spi_send_byte(0x02);
 }
 
 void ledmatrix_shift_display_right(void)
 {
+	if (headless)
+	{
+		shift_view(0, 1);
+		return;
+	}
 	(void)spi_send_byte(CMD_SHIFT_DISPLAY);
 	(void)spi_send_byte(0x01);
 }
 
 void ledmatrix_shift_display_up(void)
 {
+	if (headless)
+	{
+		shift_view(1, 0);
+		return;
+	}
 	(void)spi_send_byte(CMD_SHIFT_DISPLAY);
 	(void)spi_send_byte(0x08);
 }
 
 void ledmatrix_shift_display_down(void)
 {
+	if (headless)
+	{
+		shift_view(-1, 0);
+		return;
+	}
 	(void)spi_send_byte(CMD_SHIFT_DISPLAY);
 	(void)spi_send_byte(0x04);
 }
 
 void ledmatrix_clear(void)
 {
+	if (headless)
+	{
+		for (uint8_t row = 0; row < MATRIX_NUM_ROWS; row++)
+		{
+			for (uint8_t col = 0; col < MATRIX_NUM_COLUMNS; col++)
+			{
+				termview_set_pixel(row, col, COLOUR_BLACK);
+			}
+		}
+		return;
+	}
 	(void)spi_send_byte(CMD_CLEAR_SCREEN);
 }
 
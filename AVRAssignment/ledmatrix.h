@@ -11,6 +11,7 @@
 #define LEDMATRIX_H_
 
 #include <stdint.h>
+#include <stdbool.h>
 #include "pixel_colour.h"
 
 // The matrix has 8 rows (0 - 7, bottom to top) and 16 columns (0 - 15,
@@ -31,6 +32,21 @@ typedef PixelColour MatrixColumn[MATRIX_NUM_ROWS];
 void init_ledmatrix(void);
 
 
+/// <summary>
+/// Turns headless mode on or off. In headless mode nothing is sent to the
+/// LED matrix, and the image is drawn on the terminal instead (see
+/// termview.h). Has no effect if built with LEDMATRIX_HEADLESS defined,
+/// which makes headless mode permanent.
+/// </summary>
+/// <param name="enable">Whether to use headless mode.</param>
+void ledmatrix_set_headless(bool enable);
+
+/// <summary>
+/// Tests whether headless mode is on.
+/// </summary>
+/// <returns>Whether the image is drawn on the terminal.</returns>
+bool ledmatrix_is_headless(void);
+
 //
 // Functions to update the display.
 //
@@ -41,6 +57,15 @@ void init_ledmatrix(void);
 /// <param name="data">New colours for all pixels of the LED matrix.</param>
 void ledmatrix_update_all(MatrixData data);
 
+/// <summary>
+/// Updates all pixels of the LED matrix, with colours from a function that
+/// is called for each pixel in turn. This sends the same bytes as
+/// ledmatrix_update_all(), without needing a MatrixData to hold them.
+/// </summary>
+/// <param name="colour">Gets the new colour of the pixel at a row and
+/// column.</param>
+void ledmatrix_update_all_from(PixelColour (*colour)(uint8_t row, uint8_t col));
+
 /// <summary>
 /// Updates a specific pixel of the LED matrix.
 /// </summary>
@@ -0,0 +1,41 @@
+/*
+ * level_data.h
+ *
+ * Made by tools/levelc from levels.txt. Do not edit this file: change
+ * levels.txt and run 'make levels' in tools/.
+ *
+ * The level layouts and the level table, included only by levels.c.
+ */
+
+#ifndef LEVEL_DATA_H_
+#define LEVEL_DATA_H_
+
+static const char level_1[] PROGMEM =
+	"-#-###-###--####"
+	"-#.#--#.-$----.#"
+	"--@-------------"
+	"#-$----#--$--$-#"
+	"#---#-$---------"
+	"------.---------"
+	"---######.-----#"
+	"##------##--####";
+
+static const char level_2[] PROGMEM =
+	"--####--##-----#"
+	"--#--#-##----$-@"
+	"--#-$###--.#-.##"
+	"--#----.--$###--"
+	"####-#-----#-##-"
+	"#.$----$---##-##"
+	"#---.------$.---"
+	"################";
+
+// The pars are the fewest moves and the fewest pushes the level can be
+// solved in (each in its own solution).
+static const LevelData level_table[2] PROGMEM =
+{
+	{ level_1, 36, 12 },
+	{ level_2, 37, 10 }
+};
+
+#endif /* LEVEL_DATA_H_ */
@@ -0,0 +1,87 @@
+/*
+ * levels.c
+ *
+ * Author: Riley Stewart
+ */
+
+#include "levels.h"
+#include <stdint.h>
+#include <avr/pgmspace.h>
+#include "game.h"
+
+// Each level is stored as MATRIX_NUM_ROWS rows of MATRIX_NUM_COLUMNS
+// characters, with the top row first so the layout reads the same way it
+// appears on the LED matrix. The characters used are:
+//   '-' room            '#' wall
+//   '$' box             '.' target
+//   '*' box on target   '@' player start
+//   '+' player start on a target
+// This is the usual Sokoban level notation, with '-' used for empty room
+// squares. The levels are kept in levels.txt.
+
+typedef struct
+{
+	const char *layout;
+	uint16_t par_moves;
+	uint16_t par_pushes;
+} LevelData;
+
+// The levels themselves, made from levels.txt by tools/levelc.
+#include "level_data.h"
+
+_Static_assert(sizeof(level_table) / sizeof(level_table[0]) == NUM_LEVELS,
+	"NUM_LEVELS must be the number of levels in levels.txt");
+
+void decode_level(uint8_t level, LevelLayout *layout)
+{
+	LevelData data;
+	memcpy_P(&data, &level_table[level - 1], sizeof(data));
+
+	const char *square = data.layout;
+	for (uint8_t row = 0; row < MATRIX_NUM_ROWS; row++)
+	{
+		// Flip the rows, since the layout is stored top row first.
+		uint8_t board_row = MATRIX_NUM_ROWS - 1 - row;
+		for (uint8_t col = 0; col < MATRIX_NUM_COLUMNS; col++)
+		{
+			uint8_t object;
+			switch (pgm_read_byte(square++))
+			{
+				case '#':
+					object = WALL;
+					break;
+				case '$':
+					object = BOX;
+					break;
+				case '*':
+					object = BOX | TARGET;
+					break;
+				case '+':
+					layout->player_row = board_row;
+					layout->player_col = col;
+					// Fallthrough.
+				case '.':
+					object = TARGET;
+					break;
+				case '@':
+					layout->player_row = board_row;
+					layout->player_col = col;
+					// Fallthrough.
+				default:
+					object = ROOM;
+					break;
+			}
+			layout->board[board_row][col] = object;
+		}
+	}
+}
+
+uint16_t get_level_par(uint8_t level)
+{
+	return pgm_read_word(&level_table[level - 1].par_moves);
+}
+
+uint16_t get_level_push_par(uint8_t level)
+{
+	return pgm_read_word(&level_table[level - 1].par_pushes);
+}
@@ -0,0 +1,52 @@
+/*
+ * levels.h
+ *
+ * Author: Riley Stewart
+ *
+ * The level table. Level layouts are kept in program memory in a compact
+ * text form and decoded into a LevelLayout when a level is loaded. Each
+ * level has two pars, the fewest moves and the fewest pushes it can be
+ * solved in, found by the host solver when the level table is made (see
+ * levels.txt).
+ */
+
+#ifndef LEVELS_H_
+#define LEVELS_H_
+
+#include <stdint.h>
+#include "ledmatrix.h"
+
+// Number of levels in the level table. Levels are numbered from 1.
+#define NUM_LEVELS	(2)
+
+// A decoded level, ready to be copied onto the game board. As with the game
+// board, the 0th row is the bottom row of the LED matrix.
+typedef struct
+{
+	uint8_t board[MATRIX_NUM_ROWS][MATRIX_NUM_COLUMNS];
+	uint8_t player_row;
+	uint8_t player_col;
+} LevelLayout;
+
+/// <summary>
+/// Decodes a level from the level table.
+/// </summary>
+/// <param name="level">The level number (1 to NUM_LEVELS).</param>
+/// <param name="layout">The layout to decode into.</param>
+void decode_level(uint8_t level, LevelLayout *layout);
+
+/// <summary>
+/// Gets the par (fewest moves it can be solved in) for a level.
+/// </summary>
+/// <param name="level">The level number (1 to NUM_LEVELS).</param>
+/// <returns>The par for the level.</returns>
+uint16_t get_level_par(uint8_t level);
+
+/// <summary>
+/// Gets the push par (fewest box pushes it can be solved in) for a level.
+/// </summary>
+/// <param name="level">The level number (1 to NUM_LEVELS).</param>
+/// <returns>The push par for the level.</returns>
+uint16_t get_level_push_par(uint8_t level);
+
+#endif /* LEVELS_H_ */
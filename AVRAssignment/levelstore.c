@@ -0,0 +1,118 @@
+/*
+ * levelstore.c
+ *
+ * Author: Riley Stewart
+ */
+
+#include "levelstore.h"
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <string.h>
+#include <avr/eeprom.h>
+#include <util/crc16.h>
+#include "game.h"
+
+// Changed whenever the layout of StoredLevel changes, so levels saved in an
+// older format are not loaded.
+#define STORED_VERSION	(1)
+
+_Static_assert(MATRIX_NUM_COLUMNS == 16, "Stored rows are held in a uint16_t");
+
+typedef struct
+{
+	uint8_t version;
+	uint16_t walls[MATRIX_NUM_ROWS];
+	uint16_t boxes[MATRIX_NUM_ROWS];
+	uint16_t targets[MATRIX_NUM_ROWS];
+	uint8_t player;		// row * MATRIX_NUM_COLUMNS + column
+	uint8_t crc;		// CRC-8 of the bytes before it
+} StoredLevel;
+
+static StoredLevel EEMEM stored_levels[LEVELSTORE_SLOTS];
+
+static uint8_t stored_crc(const StoredLevel *stored)
+{
+	const uint8_t *bytes = (const uint8_t *)stored;
+	uint8_t crc = 0;
+	for (uint8_t i = 0; i < offsetof(StoredLevel, crc); i++)
+	{
+		crc = _crc8_ccitt_update(crc, bytes[i]);
+	}
+	return crc;
+}
+
+// Reads a slot, and checks that it holds a level.
+static bool read_slot(uint8_t slot, StoredLevel *stored)
+{
+	if (slot >= LEVELSTORE_SLOTS)
+	{
+		return false;
+	}
+	eeprom_read_block(stored, &stored_levels[slot], sizeof(*stored));
+	return stored->version == STORED_VERSION
+		&& stored->crc == stored_crc(stored);
+}
+
+bool levelstore_exists(uint8_t slot)
+{
+	StoredLevel stored;
+	return read_slot(slot, &stored);
+}
+
+bool levelstore_load(uint8_t slot, LevelLayout *layout)
+{
+	StoredLevel stored;
+	if (!read_slot(slot, &stored))
+	{
+		return false;
+	}
+	for (uint8_t row = 0; row < MATRIX_NUM_ROWS; row++)
+	{
+		for (uint8_t col = 0; col < MATRIX_NUM_COLUMNS; col++)
+		{
+			uint16_t bit = 1U << col;
+			layout->board[row][col] = ((stored.walls[row] & bit) ? WALL : ROOM)
+				| ((stored.boxes[row] & bit) ? BOX : ROOM)
+				| ((stored.targets[row] & bit) ? TARGET : ROOM);
+		}
+	}
+	layout->player_row = stored.player / MATRIX_NUM_COLUMNS;
+	layout->player_col = stored.player % MATRIX_NUM_COLUMNS;
+	return true;
+}
+
+void levelstore_save(uint8_t slot, const LevelLayout *layout)
+{
+	if (slot >= LEVELSTORE_SLOTS)
+	{
+		return;
+	}
+	StoredLevel stored;
+	memset(&stored, 0, sizeof(stored));
+	stored.version = STORED_VERSION;
+	for (uint8_t row = 0; row < MATRIX_NUM_ROWS; row++)
+	{
+		for (uint8_t col = 0; col < MATRIX_NUM_COLUMNS; col++)
+		{
+			uint8_t object = layout->board[row][col];
+			uint16_t bit = 1U << col;
+			if (object & WALL)
+			{
+				stored.walls[row] |= bit;
+			}
+			if (object & BOX)
+			{
+				stored.boxes[row] |= bit;
+			}
+			if (object & TARGET)
+			{
+				stored.targets[row] |= bit;
+			}
+		}
+	}
+	stored.player = layout->player_row * MATRIX_NUM_COLUMNS
+		+ layout->player_col;
+	stored.crc = stored_crc(&stored);
+	eeprom_update_block(&stored, &stored_levels[slot], sizeof(stored));
+}
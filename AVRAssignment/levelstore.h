@@ -0,0 +1,46 @@
+/*
+ * levelstore.h
+ *
+ * Author: Riley Stewart
+ *
+ * Custom levels kept in EEPROM, made with the level editor (see editor.h).
+ * Each slot holds one level packed as bit planes: a uint16_t per row for
+ * the walls, the boxes and the targets, and the player's square, with a
+ * CRC so an empty (erased) or half written slot is never loaded.
+ */
+
+#ifndef LEVELSTORE_H_
+#define LEVELSTORE_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "levels.h"
+
+// Number of custom level slots. Each takes 51 bytes of EEPROM.
+#define LEVELSTORE_SLOTS	(4)
+
+/// <summary>
+/// Tests whether a slot holds a level.
+/// </summary>
+/// <param name="slot">The slot (0 to LEVELSTORE_SLOTS - 1).</param>
+/// <returns>Whether the slot holds a level that can be loaded.</returns>
+bool levelstore_exists(uint8_t slot);
+
+/// <summary>
+/// Loads a level from a slot.
+/// </summary>
+/// <param name="slot">The slot (0 to LEVELSTORE_SLOTS - 1).</param>
+/// <param name="layout">The layout to load into. Left unchanged if the
+/// slot does not hold a level.</param>
+/// <returns>Whether a level was loaded.</returns>
+bool levelstore_load(uint8_t slot, LevelLayout *layout);
+
+/// <summary>
+/// Saves a level to a slot. Only the bytes that change are written, to
+/// save EEPROM wear.
+/// </summary>
+/// <param name="slot">The slot (0 to LEVELSTORE_SLOTS - 1).</param>
+/// <param name="layout">The level to save.</param>
+void levelstore_save(uint8_t slot, const LevelLayout *layout);
+
+#endif /* LEVELSTORE_H_ */
@@ -0,0 +1,104 @@
+/*
+ * link.c
+ *
+ * Author: Riley Stewart
+ */
+
+#include "link.h"
+#include <stdint.h>
+#include <stdbool.h>
+#include <avr/io.h>
+#include <avr/interrupt.h>
+
+// System clock rate in Hz.
+#define SYSCLK 8000000L
+
+#define LINK_MASK	(LINK_BUFFER_SIZE - 1)
+
+_Static_assert((LINK_BUFFER_SIZE & LINK_MASK) == 0 && LINK_BUFFER_SIZE <= 128,
+	"LINK_BUFFER_SIZE must be a power of two no larger than 128");
+
+// Circular buffers. Each has a head (next byte to take out) and a tail (next
+// free slot). Only the main program moves the transmit tail and receive head,
+// and only the ISRs move the transmit head and receive tail, so as long as
+// each index is a single byte no locking is needed.
+static volatile uint8_t tx_buffer[LINK_BUFFER_SIZE];
+static volatile uint8_t tx_head;
+static volatile uint8_t tx_tail;
+static volatile uint8_t rx_buffer[LINK_BUFFER_SIZE];
+static volatile uint8_t rx_head;
+static volatile uint8_t rx_tail;
+
+// Interrupt handler for USART1 Data Register Empty. Sends the next byte, or
+// turns itself off when there is nothing left to send.
+ISR(USART1_UDRE_vect)
+{
+	if (tx_head != tx_tail)
+	{
+		UDR1 = tx_buffer[tx_head];
+		tx_head = (tx_head + 1) & LINK_MASK;
+	}
+	else
+	{
+		UCSR1B &= ~(1 << UDRIE1);
+	}
+}
+
+// Interrupt handler for USART1 Receive Complete. The byte is discarded if
+// the receive buffer is full.
+ISR(USART1_RX_vect)
+{
+	uint8_t byte = UDR1;
+	uint8_t next = (rx_tail + 1) & LINK_MASK;
+	if (next != rx_head)
+	{
+		rx_buffer[rx_tail] = byte;
+		rx_tail = next;
+	}
+}
+
+void init_link(long baudrate)
+{
+	tx_head = tx_tail = 0;
+	rx_head = rx_tail = 0;
+
+	// Same rounding as init_serial_stdio().
+	UBRR1 = (uint16_t)((((SYSCLK / (8 * baudrate)) + 1) / 2) - 1);
+
+	// 8 data bits, no parity, 1 stop bit.
+	UCSR1C = (1 << UCSZ11) | (1 << UCSZ10);
+
+	// Enable the transmitter, receiver and receive complete interrupt. The
+	// data register empty interrupt is enabled when there is data to send.
+	UCSR1B = (1 << RXEN1) | (1 << TXEN1) | (1 << RXCIE1);
+}
+
+bool link_put_byte(uint8_t byte)
+{
+	uint8_t next = (tx_tail + 1) & LINK_MASK;
+	if (next == tx_head)
+	{
+		return false;
+	}
+	tx_buffer[tx_tail] = byte;
+	tx_tail = next;
+	UCSR1B |= (1 << UDRIE1);
+	return true;
+}
+
+uint8_t link_space(void)
+{
+	// One slot is always left empty, to tell a full buffer from an empty one.
+	return (tx_head - tx_tail - 1) & LINK_MASK;
+}
+
+bool link_get_byte(uint8_t *byte)
+{
+	if (rx_head == rx_tail)
+	{
+		return false;
+	}
+	*byte = rx_buffer[rx_head];
+	rx_head = (rx_head + 1) & LINK_MASK;
+	return true;
+}
\ No newline at end of file
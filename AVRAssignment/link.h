@@ -0,0 +1,55 @@
+/*
+ * link.h
+ *
+ * Author: Riley Stewart
+ *
+ * Byte link to another board over the second UART (USART1, pins PD2/RXD1
+ * and PD3/TXD1). Unlike serialio this is a raw binary link: bytes are not
+ * translated, and nothing ever blocks. Both directions are buffered and
+ * interrupt driven.
+ */
+
+#ifndef LINK_H_
+#define LINK_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// Baud rate of the link. 38400 is within 0.2% at 8MHz.
+#define LINK_BAUD	(38400L)
+
+// Sizes of the transmit and receive circular buffers, in bytes. These must
+// be powers of two no larger than 128.
+#define LINK_BUFFER_SIZE	(32)
+
+/// <summary>
+/// Initialises the link on USART1. Interrupts must be enabled for the link
+/// to send or receive anything.
+/// </summary>
+/// <param name="baudrate">The baud rate (e.g., LINK_BAUD).</param>
+void init_link(long baudrate);
+
+/// <summary>
+/// Queues a byte to send over the link.
+/// </summary>
+/// <param name="byte">The byte to send.</param>
+/// <returns>Whether the byte was queued. It is discarded if the transmit
+/// buffer is full.</returns>
+bool link_put_byte(uint8_t byte);
+
+/// <summary>
+/// Gets the number of bytes that can be queued without any being discarded.
+/// This can only grow until more bytes are queued, so a message that fits
+/// can be sent whole.
+/// </summary>
+/// <returns>The free space in the transmit buffer, in bytes.</returns>
+uint8_t link_space(void);
+
+/// <summary>
+/// Takes the next received byte from the link, if there is one.
+/// </summary>
+/// <param name="byte">Set to the byte received.</param>
+/// <returns>Whether a byte was received.</returns>
+bool link_get_byte(uint8_t *byte);
+
+#endif /* LINK_H_ */
\ No newline at end of file
@@ -0,0 +1,113 @@
+/*
+ * memstats.c
+ *
+ * Author: Riley Stewart
+ */
+
+#include "memstats.h"
+#include <stdint.h>
+#include <stdbool.h>
+#include <avr/io.h>
+#include <avr/pgmspace.h>
+#include "serialio.h"
+#include "buttons.h"
+#include "terminalio.h"
+#include "output.h"
+
+// The value RAM is painted with at startup. STACK_CANARY_STR must match, as
+// it is used in the assembly below.
+#define STACK_CANARY    	(0xC5)
+#define STACK_CANARY_STR	"0xC5"
+
+// Symbols defined by the linker script.
+extern uint8_t __data_start;
+extern uint8_t __data_end;
+extern uint8_t __bss_start;
+extern uint8_t __bss_end;
+extern uint8_t _end;
+extern uint8_t __stack;
+
+// Paints RAM from _end to the top of the stack with STACK_CANARY. This runs
+// in .init1, before the zero register has been cleared and before the
+// stack is used, so it is written in assembly and must not use the stack.
+void paint_stack(void) __attribute__((naked, used, section(".init1")));
+void paint_stack(void)
+{
+	__asm volatile (
+		"	ldi r30, lo8(_end)\n"
+		"	ldi r31, hi8(_end)\n"
+		"	ldi r24, " STACK_CANARY_STR "\n"
+		"	ldi r25, hi8(__stack)\n"
+		"	rjmp 2f\n"
+		"1:\n"
+		"	st Z+, r24\n"
+		"2:\n"
+		"	cpi r30, lo8(__stack)\n"
+		"	cpc r31, r25\n"
+		"	brlo 1b\n"
+		"	breq 1b\n"
+	);
+}
+
+uint16_t get_free_ram(void)
+{
+	return (uint8_t *)SP - &_end;
+}
+
+uint16_t get_stack_high_water(void)
+{
+	// Find the first byte above .bss that no longer holds the canary.
+	// Everything from there up to the top of RAM has been used by the
+	// stack at some point.
+	const uint8_t *p = &_end;
+	while (p <= &__stack && *p == STACK_CANARY)
+	{
+		p++;
+	}
+	return &__stack - p + 1;
+}
+
+bool stack_canary_intact(void)
+{
+	return _end == STACK_CANARY;
+}
+
+// Writes "label used/size (peak n)" for a buffer.
+static void put_buffer_usage(const char *label, uint8_t used, uint8_t size,
+	uint8_t peak)
+{
+	put_str_P(label);
+	put_u16(used);
+	put_char('/');
+	put_u16(size);
+	put_str_P(PSTR(" (peak "));
+	put_u16(peak);
+	put_str_P(PSTR(")  "));
+}
+
+void report_memory_usage(int row)
+{
+	move_terminal_cursor(row, 1);
+	put_str_P(PSTR(".data: "));
+	put_u16(&__data_end - &__data_start);
+	put_str_P(PSTR("  .bss: "));
+	put_u16(&__bss_end - &__bss_start);
+	put_str_P(PSTR("  Free: "));
+	put_u16(get_free_ram());
+	put_str_P(PSTR("  Stack peak: "));
+	put_u16(get_stack_high_water());
+	if (!stack_canary_intact())
+	{
+		put_str_P(PSTR("  STACK OVERFLOW"));
+	}
+	clear_to_end_of_line();
+
+	move_terminal_cursor(row + 1, 1);
+	put_buffer_usage(PSTR("out_buffer: "), serial_output_buffer_used(),
+		SERIAL_OUTPUT_BUFFER_SIZE, serial_output_buffer_peak());
+	put_buffer_usage(PSTR("input_buffer: "), serial_input_buffer_used(),
+		SERIAL_INPUT_BUFFER_SIZE, serial_input_buffer_peak());
+	put_buffer_usage(PSTR("button_queue: "), button_queue_used(),
+		BUTTON_QUEUE_SIZE, button_queue_peak());
+	clear_to_end_of_line();
+}
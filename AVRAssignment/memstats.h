@@ -0,0 +1,46 @@
+/*
+ * memstats.h
+ *
+ * Author: Riley Stewart
+ *
+ * RAM usage monitoring. At startup (before main() and before .data and .bss
+ * are initialised) all RAM from the end of .bss up to the top of the stack
+ * is painted with a canary value. Stack growth overwrites the canary, so the
+ * lowest overwritten address gives the stack's high water mark.
+ */
+
+#ifndef MEMSTATS_H_
+#define MEMSTATS_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/// <summary>
+/// Gets the amount of RAM currently free between the end of .bss and the
+/// stack pointer.
+/// </summary>
+/// <returns>Free RAM in bytes.</returns>
+uint16_t get_free_ram(void);
+
+/// <summary>
+/// Gets the peak stack usage since power on, found by scanning for the
+/// lowest address where the canary has been overwritten.
+/// </summary>
+/// <returns>Peak stack usage in bytes.</returns>
+uint16_t get_stack_high_water(void);
+
+/// <summary>
+/// Tests whether the stack has ever reached the end of .bss (i.e., whether
+/// the stack has collided with global variables).
+/// </summary>
+/// <returns>Whether the canary just above .bss is intact.</returns>
+bool stack_canary_intact(void);
+
+/// <summary>
+/// Writes a report of RAM usage (section sizes, free RAM, peak stack use
+/// and buffer occupancy) to the terminal, starting at the given row.
+/// </summary>
+/// <param name="row">The terminal row to start the report on.</param>
+void report_memory_usage(int row);
+
+#endif /* MEMSTATS_H_ */
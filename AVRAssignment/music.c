@@ -0,0 +1,240 @@
+/*
+ * music.c
+ *
+ * Author: Riley Stewart
+ */
+
+#include "music.h"
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <avr/io.h>
+#include <avr/interrupt.h>
+#include <avr/pgmspace.h>
+#include "buzzer.h"
+
+// A C major, A minor, F major, G major progression: a chord for half a
+// bar, then a run of plain notes above it.
+const uint8_t game_music[] PROGMEM =
+{
+	MUSIC_TEMPO, 30,
+	MUSIC_ARPEGGIO, 0x47, NOTE_C5, 4,
+	MUSIC_ARPEGGIO, 0x00, NOTE_E6, 1, NOTE_G6, 1, NOTE_E6, 2,
+	MUSIC_ARPEGGIO, 0x37, NOTE_A4, 4,
+	MUSIC_ARPEGGIO, 0x00, NOTE_C6, 1, NOTE_E6, 1, NOTE_C6, 2,
+	MUSIC_ARPEGGIO, 0x47, NOTE_F4, 4,
+	MUSIC_ARPEGGIO, 0x00, NOTE_A5, 1, NOTE_C6, 1, NOTE_A5, 2,
+	MUSIC_ARPEGGIO, 0x47, NOTE_G4, 4,
+	MUSIC_ARPEGGIO, 0x00, NOTE_B5, 1, NOTE_D6, 1, MUSIC_REST, 2,
+	MUSIC_LOOP
+};
+
+// The effects play the notes of the beeps they replace, at the same lengths
+// (one step of 80ms, and steps of 300ms).
+static const uint8_t move_sound[] PROGMEM =
+{
+	MUSIC_TEMPO, 20, NOTE_B6, 1, MUSIC_END
+};
+
+static const uint8_t start_sound[] PROGMEM =
+{
+	MUSIC_TEMPO, 75, NOTE_B6, 1, NOTE_G4, 1, MUSIC_END
+};
+
+static const uint8_t victory_sound[] PROGMEM =
+{
+	MUSIC_TEMPO, 75, NOTE_B6, 1, NOTE_DS8, 1, NOTE_B6, 1, NOTE_DS7, 1, MUSIC_END
+};
+
+// Indexed by SoundEffect
+static const uint8_t *const effect_scores[] PROGMEM =
+{
+	move_sound, start_sound, victory_sound
+};
+
+typedef struct
+{
+	const uint8_t *start;	// The score, or NULL if the channel is idle
+	const uint8_t *next;	// The next entry to read
+	uint16_t ticks;			// Ticks left of the current note or rest
+	uint8_t tempo;			// Ticks per step
+	uint8_t note;			// The current note, or MUSIC_REST
+	uint8_t arpeggio;		// Semitones to the chord's other notes, as 0xXY
+	uint8_t arpeggio_ticks;	// Ticks left of the current note of the chord
+	uint8_t phase;			// The note of the chord sounding (0, 1 or 2)
+} Channel;
+
+// Only changed with interrupts off (cli() and sei() are also barriers to the
+// compiler), or by the interrupt handler, so they need not be volatile.
+static Channel music;
+static Channel effect;
+static SoundEffect effect_playing;
+static volatile bool enabled = true;
+
+// The note the buzzer is playing, or MUSIC_REST. Only used by the
+// interrupt handler.
+static uint8_t sounding = MUSIC_REST;
+
+static void start_channel(Channel *channel, const uint8_t *score)
+{
+	channel->start = score;
+	channel->next = score;
+	channel->ticks = 0;
+	channel->tempo = MUSIC_DEFAULT_TEMPO;
+	channel->note = MUSIC_REST;
+	channel->arpeggio = 0;
+}
+
+// Reads score entries up to the next note or rest, or until
+// MUSIC_MAX_EVENTS have been read.
+static void read_score(Channel *channel)
+{
+	channel->note = MUSIC_REST;
+	for (uint8_t i = 0; i < MUSIC_MAX_EVENTS; i++)
+	{
+		uint8_t entry = pgm_read_byte(channel->next++);
+		switch (entry)
+		{
+			case MUSIC_TEMPO:
+				channel->tempo = pgm_read_byte(channel->next++);
+				break;
+			case MUSIC_ARPEGGIO:
+				channel->arpeggio = pgm_read_byte(channel->next++);
+				break;
+			case MUSIC_LOOP:
+				channel->next = channel->start;
+				break;
+			case MUSIC_END:
+				channel->start = NULL;
+				return;
+			default:
+				// A note or a rest.
+				channel->note = entry;
+				channel->ticks = pgm_read_byte(channel->next++) * channel->tempo;
+				channel->arpeggio_ticks = MUSIC_ARPEGGIO_TICKS;
+				channel->phase = 0;
+				return;
+		}
+	}
+}
+
+// Advances a channel by a tick.
+static void channel_tick(Channel *channel)
+{
+	if (!channel->start)
+	{
+		return;
+	}
+	if (channel->ticks > 1)
+	{
+		channel->ticks--;
+		if (channel->arpeggio && --channel->arpeggio_ticks == 0)
+		{
+			// Move on to the chord's next note
+			channel->arpeggio_ticks = MUSIC_ARPEGGIO_TICKS;
+			if (++channel->phase == 3)
+			{
+				channel->phase = 0;
+			}
+		}
+		return;
+	}
+	read_score(channel);
+}
+
+// The note a channel is playing, or MUSIC_REST.
+static uint8_t channel_note(Channel *channel)
+{
+	if (channel->note == MUSIC_REST)
+	{
+		return MUSIC_REST;
+	}
+	// The chord's notes are 0, then x, then y semitones above the note.
+	uint8_t note = channel->note;
+	if (channel->phase == 1)
+	{
+		note += channel->arpeggio >> 4;
+	}
+	else if (channel->phase == 2)
+	{
+		note += channel->arpeggio & 0x0F;
+	}
+	return note < NUM_NOTES ? note : NUM_NOTES - 1;
+}
+
+// The sequencer tick. Each channel moves on a tick, and the buzzer is
+// changed only if the note to play has changed.
+ISR(TIMER1_COMPA_vect)
+{
+	channel_tick(&music);
+	channel_tick(&effect);
+	uint8_t note = MUSIC_REST;
+	if (enabled)
+	{
+		note = effect.start ? channel_note(&effect) : channel_note(&music);
+	}
+	if (note != sounding)
+	{
+		sounding = note;
+		if (note == MUSIC_REST)
+		{
+			buzzer_off();
+		}
+		else
+		{
+			buzzer_play_note(note);
+		}
+	}
+}
+
+void music_play(const uint8_t *score)
+{
+	// Interrupts are turned back on only if they were on to start with.
+	uint8_t interrupts_were_enabled = bit_is_set(SREG, SREG_I);
+	cli();
+	start_channel(&music, score);
+	if (interrupts_were_enabled)
+	{
+		sei();
+	}
+}
+
+void music_stop(void)
+{
+	// The score pointer is two bytes, so turn interrupts off to clear it.
+	uint8_t interrupts_were_enabled = bit_is_set(SREG, SREG_I);
+	cli();
+	music.start = NULL;
+	music.note = MUSIC_REST;
+	if (interrupts_were_enabled)
+	{
+		sei();
+	}
+}
+
+void music_effect(SoundEffect sound)
+{
+	if (!enabled)
+	{
+		return;
+	}
+	const uint8_t *score;
+	memcpy_P(&score, &effect_scores[sound], sizeof(score));
+	uint8_t interrupts_were_enabled = bit_is_set(SREG, SREG_I);
+	cli();
+	if (!effect.start || sound >= effect_playing)
+	{
+		effect_playing = sound;
+		start_channel(&effect, score);
+	}
+	if (interrupts_were_enabled)
+	{
+		sei();
+	}
+}
+
+void music_set_enabled(bool on)
+{
+	// A single byte, so no need to turn interrupts off to write it.
+	enabled = on;
+}
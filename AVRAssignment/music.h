@@ -0,0 +1,95 @@
+/*
+ * music.h
+ *
+ * Author: Riley Stewart
+ *
+ * Background music and sound effects on the buzzer (see buzzer.h). A
+ * sequencer run by the timer 1 interrupt (every TIMER1_TICK_MS, see
+ * timer1.h) plays a score from program memory while the game runs. The
+ * buzzer plays one note at a time, so chords are faked by arpeggio: the
+ * notes of a chord are played in turn, each for MUSIC_ARPEGGIO_TICKS ticks,
+ * fast enough to be heard as one sound.
+ *
+ * Sound effects play on a second channel over the music. The music carries
+ * on silently underneath, so it is still in time when the effect ends. An
+ * effect only cuts off another effect of the same or lower priority.
+ *
+ * A score is a list of bytes, each entry one of:
+ *   note, steps         play a note (NOTE_C4 to NOTE_B8, see buzzer.h) for
+ *                       1 to 255 steps
+ *   MUSIC_REST, steps   be silent for 1 to 255 steps
+ *   MUSIC_TEMPO, ticks  set the length of a step, in ticks (a score starts
+ *                       at MUSIC_DEFAULT_TEMPO)
+ *   MUSIC_ARPEGGIO, xy  play the notes that follow as chords of the note
+ *                       and the notes x and y semitones above it (0x47 is a
+ *                       major chord, 0x37 a minor one and 0x00 a plain note)
+ *   MUSIC_LOOP          go back to the start of the score
+ *   MUSIC_END           stop
+ *
+ * The interrupt handler's work is bounded: it reads at most
+ * MUSIC_MAX_EVENTS entries per channel and writes the buzzer at most once
+ * per tick, so it takes a few microseconds and never holds up the timer 0
+ * tick or the serial interrupts for long enough for them to be missed.
+ */
+
+#ifndef MUSIC_H_
+#define MUSIC_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <avr/pgmspace.h>
+
+// Score entries other than notes (which are below NUM_NOTES).
+#define MUSIC_REST		(0xF0)
+#define MUSIC_TEMPO		(0xF1)
+#define MUSIC_ARPEGGIO	(0xF2)
+#define MUSIC_LOOP		(0xF3)
+#define MUSIC_END		(0xF4)
+
+// Ticks per step when a score starts.
+#define MUSIC_DEFAULT_TEMPO		(25)
+
+// Ticks each note of an arpeggio is played for.
+#define MUSIC_ARPEGGIO_TICKS	(2)
+
+// Most score entries read per channel per tick. A note or rest ends the
+// reading; a run of longer than this of the other entries carries on at
+// the next tick.
+#define MUSIC_MAX_EVENTS		(4)
+
+// Sound effects, in increasing order of priority.
+typedef enum
+{
+	SOUND_MOVE,
+	SOUND_START,
+	SOUND_VICTORY
+} SoundEffect;
+
+// The music played during a level.
+extern const uint8_t game_music[] PROGMEM;
+
+/// <summary>
+/// Starts playing a score in the background, from its start.
+/// </summary>
+/// <param name="score">The score, in program memory.</param>
+void music_play(const uint8_t *score);
+
+/// <summary>
+/// Stops the background music. Any sound effect plays on.
+/// </summary>
+void music_stop(void);
+
+/// <summary>
+/// Plays a sound effect over the music, unless an effect of higher
+/// priority is playing or sound is turned off.
+/// </summary>
+/// <param name="effect">The sound effect.</param>
+void music_effect(SoundEffect effect);
+
+/// <summary>
+/// Turns all sound on or off. The music keeps time while sound is off.
+/// </summary>
+/// <param name="enabled">Whether sound is on.</param>
+void music_set_enabled(bool enabled);
+
+#endif /* MUSIC_H_ */
@@ -0,0 +1,67 @@
+/*
+ * output.c
+ *
+ * Author: Riley Stewart
+ */
+
+#include "output.h"
+#include <stdint.h>
+#include <stdbool.h>
+#include <avr/pgmspace.h>
+#include "serialio.h"
+
+// Powers of ten used to find each decimal digit by repeated subtraction,
+// which is much cheaper than division on the AVR.
+static const uint16_t powers_of_ten[] PROGMEM = { 10000, 1000, 100, 10 };
+
+void put_char(char c)
+{
+	serial_put_char(c);
+}
+
+void put_str(const char *str)
+{
+	while (*str)
+	{
+		serial_put_char(*str++);
+	}
+}
+
+void put_str_P(const char *str)
+{
+	char c;
+	while ((c = pgm_read_byte(str++)))
+	{
+		serial_put_char(c);
+	}
+}
+
+void put_u16(uint16_t number)
+{
+	bool started = false;
+	for (uint8_t i = 0; i < sizeof(powers_of_ten) / sizeof(powers_of_ten[0]);
+		i++)
+	{
+		uint16_t power = pgm_read_word(&powers_of_ten[i]);
+		char digit = '0';
+		while (number >= power)
+		{
+			number -= power;
+			digit++;
+		}
+		if (started || digit != '0')
+		{
+			serial_put_char(digit);
+			started = true;
+		}
+	}
+	serial_put_char('0' + number);
+}
+
+void put_escape(uint16_t parameter, char command)
+{
+	serial_put_char('\x1b');
+	serial_put_char('[');
+	put_u16(parameter);
+	serial_put_char(command);
+}
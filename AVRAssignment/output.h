@@ -0,0 +1,48 @@
+/*
+ * output.h
+ *
+ * Author: Riley Stewart
+ *
+ * Minimal formatted output routines. These write directly into the serial
+ * output buffer (see serialio.h) without going through stdio, so they do not
+ * pull in the printf formatter and allocate nothing.
+ */
+
+#ifndef OUTPUT_H_
+#define OUTPUT_H_
+
+#include <stdint.h>
+
+/// <summary>
+/// Writes a single character. A linefeed is output as CR LF.
+/// </summary>
+/// <param name="c">The character to write.</param>
+void put_char(char c);
+
+/// <summary>
+/// Writes a string stored in RAM.
+/// </summary>
+/// <param name="str">The null-terminated string.</param>
+void put_str(const char *str);
+
+/// <summary>
+/// Writes a string stored in program memory (e.g., from PSTR()).
+/// </summary>
+/// <param name="str">The null-terminated string in program memory.</param>
+void put_str_P(const char *str);
+
+/// <summary>
+/// Writes an unsigned number in decimal, without leading zeros.
+/// </summary>
+/// <param name="number">The number to write.</param>
+void put_u16(uint16_t number);
+
+/// <summary>
+/// Writes a single-parameter escape sequence "ESC [ parameter command",
+/// e.g. put_escape(41, 'm') sets a red background.
+/// </summary>
+/// <param name="parameter">The numeric parameter.</param>
+/// <param name="command">The final character of the sequence.</param>
+void put_escape(uint16_t parameter, char command);
+
+#endif /* OUTPUT_H_ */
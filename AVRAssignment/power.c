@@ -0,0 +1,38 @@
+/*
+ * power.c
+ *
+ * Author: Riley Stewart
+ */
+
+#include "power.h"
+#include <stdint.h>
+#include <avr/io.h>
+#include <avr/interrupt.h>
+#include <avr/sleep.h>
+#include "timer0.h"
+
+// Time spent asleep, in timer 0 counts (125 per millisecond).
+static uint32_t sleep_counts;
+
+void idle_sleep(void)
+{
+	uint32_t start = get_current_time_counts();
+
+	// Interrupts are turned off while sleep is enabled, and sei() is
+	// immediately followed by the sleep instruction. The instruction after
+	// sei() always executes before any pending interrupt, so an interrupt
+	// arriving here cannot be missed and leave us asleep.
+	set_sleep_mode(SLEEP_MODE_IDLE);
+	cli();
+	sleep_enable();
+	sei();
+	sleep_cpu();
+	sleep_disable();
+
+	sleep_counts += get_current_time_counts() - start;
+}
+
+uint32_t get_sleep_time(void)
+{
+	return sleep_counts / 125;
+}
@@ -0,0 +1,30 @@
+/*
+ * power.h
+ *
+ * Author: Riley Stewart
+ *
+ * Idle power management. Loops which only wait for input can call
+ * idle_sleep() to put the CPU into idle sleep until the next interrupt
+ * (UART receive, button pin change or the timer 0 millisecond tick), rather
+ * than spinning at full power. Since timer 0 interrupts every millisecond,
+ * the CPU never sleeps for longer than 1 ms at a time.
+ */
+
+#ifndef POWER_H_
+#define POWER_H_
+
+#include <stdint.h>
+
+/// <summary>
+/// Puts the CPU into idle sleep until the next interrupt occurs. Global
+/// interrupts must be enabled before this is called.
+/// </summary>
+void idle_sleep(void);
+
+/// <summary>
+/// Gets the total time spent asleep in idle_sleep().
+/// </summary>
+/// <returns>Milliseconds spent asleep since power on.</returns>
+uint32_t get_sleep_time(void);
+
+#endif /* POWER_H_ */
@@ -17,45 +17,97 @@
 #include <avr/interrupt.h>
 #include <avr/pgmspace.h>
 
-#define F_CPU 8000000UL
-#include <util/delay.h>
-
 #include "game.h"
+#include "campaign.h"
 #include "startscrn.h"
 #include "ledmatrix.h"
 #include "buttons.h"
 #include "serialio.h"
 #include "terminalio.h"
+#include "output.h"
 #include "timer0.h"
 #include "timer1.h"
 #include "timer2.h"
 #include "buzzer.h"
+#include "music.h"
 #include "joystick.h"
+#include "power.h"
+#include "memstats.h"
+#include "ssd.h"
+#include "hint.h"
+#include "anim.h"
+#include "link.h"
+#include "versus.h"
+#include "telemetry.h"
+#include "termview.h"
+#include "editor.h"
+#include "input.h"
+
 
+// The states of the game. main() runs the handler for the current state,
+// and each handler returns the state to move to next. Handlers always return
+// to main() rather than calling each other, so the stack depth stays the
+// same no matter how many levels are played.
+typedef enum
+{
+	STATE_START,
+	STATE_PLAYING,
+	STATE_PAUSED,
+	STATE_GAME_OVER,
+	STATE_LEVEL_SELECT,
+	STATE_EDITOR,
+	STATE_INPUT_SETUP
+} GameState;
 
 // Function prototypes - these are defined below (after main()) in the order
 // given here.
 void initialise_hardware(void);
 void start_screen(void);
-void new_game(int level);
-void play_game(void);
-void handle_game_over(void);
+void new_game(void);
+GameState play_game(void);
+GameState pause_game(void);
+GameState handle_game_over(void);
+GameState level_select(void);
+GameState level_editor(void);
+GameState input_setup(void);
 
 //Global variable step counter
 uint8_t step_counter;
 
 //Global variable play time in seconds
-uint8_t play_time;
-
-//Global variable ssd numbers
-uint8_t seven_seg[10] = {63,6,91,79,102,109,125,7,127,111};
-	
-//Global variable level
-uint8_t current_level;
+uint16_t play_time;
 
 //Global variable, turns sound effects on or off
 bool buzzer_enabled;
 
+//Seven segment display digit shown next (0 = right, 1 = left)
+static uint8_t ssd_digit;
+
+//Icon flash and input timing for the level being played
+static uint32_t last_flash_time;
+static uint32_t last_target_flash_time;
+static uint32_t last_input;
+static bool accept_input;
+
+//The hint being shown, and the position it was asked for at (the hint is
+//dropped as soon as the player moves)
+static Hint hint;
+static bool hint_visible;
+static uint32_t last_hint_flash_time;
+static uint32_t hint_position;
+
+//Whether we are racing another board over the link (see versus.h)
+static bool versus_mode;
+
+//Whether the opponent was connected when it was last displayed
+static bool opponent_shown_connected;
+
+//Whether the start screen was left to edit levels rather than play
+static bool editor_requested;
+
+//Whether the start screen was left to set up the joystick and keys
+static bool input_setup_requested;
+
 /////////////////////////////// main //////////////////////////////////
 int main(void)
 {
@@ -64,22 +116,55 @@ int main(void)
 	
 	// Setup hardware and callbacks. This will turn on interrupts.
 	initialise_hardware();
-
-	// Show the start screen. Returns when the player starts the game.
-	start_screen();
-	
-	//Set the level to 1
-	current_level = 1;
 	
 	//Enable buzzer sounds
 	buzzer_enabled = true;
 
-	// Loop forever and continuously play the game.
+	// Loop forever, running the handler for the current state.
+	GameState state = STATE_START;
 	while (1)
 	{
-		new_game(current_level);
-		play_game();
-		handle_game_over();
+		switch (state)
+		{
+			case STATE_START:
+				// Show the start screen. Returns when the player
+				// starts the game, which begins from level 1.
+				start_screen();
+				campaign_reset();
+				campaign_set_racing(versus_mode);
+				if (editor_requested) {
+					state = STATE_EDITOR;
+					break;
+				}
+				if (input_setup_requested) {
+					state = STATE_INPUT_SETUP;
+					break;
+				}
+				new_game();
+				state = STATE_PLAYING;
+				break;
+			case STATE_PLAYING:
+				// The music plays only while a level is being played.
+				music_play(game_music);
+				state = play_game();
+				music_stop();
+				break;
+			case STATE_PAUSED:
+				state = pause_game();
+				break;
+			case STATE_GAME_OVER:
+				state = handle_game_over();
+				break;
+			case STATE_LEVEL_SELECT:
+				state = level_select();
+				break;
+			case STATE_EDITOR:
+				state = level_editor();
+				break;
+			case STATE_INPUT_SETUP:
+				state = input_setup();
+				break;
+		}
 	}
 }
 
@@ -88,11 +173,13 @@ void initialise_hardware(void)
 	init_ledmatrix();
 	init_buttons();
 	init_serial_stdio(19200, false);
+	init_link(LINK_BAUD);
 	init_timer0();
 	init_timer1();
 	init_timer2();
 	init_buzzer();
 	init_joystick();
+	init_input();
 
 	// Turn on global interrupts.
 	sei();
@@ -111,7 +198,18 @@ void start_screen(void)
 	move_terminal_cursor(11, 5);
 	// Change this to your name and student number. Remember to remove the
 	// chevrons - "<" and ">"!
-	printf_P(PSTR("CSSE2010/7201 Project by Riley Stewart - 48828662"));
+	put_str_P(PSTR("CSSE2010/7201 Project by Riley Stewart - 48828662"));
+	move_terminal_cursor(13, 5);
+	put_str_P(PSTR("Press 'v' to race a second board"));
+	move_terminal_cursor(14, 5);
+	put_str_P(PSTR("Press 't' to show the LED matrix on the terminal"));
+	move_terminal_cursor(15, 5);
+	put_str_P(PSTR("Press 'e' to edit custom levels"));
+	move_terminal_cursor(16, 5);
+	put_str_P(PSTR("Press 'j' to set up the joystick and keys"));
+	versus_mode = false;
+	editor_requested = false;
+	input_setup_requested = false;
 
 	// Setup the start screen on the LED matrix.
 	setup_start_screen();
@@ -144,29 +242,251 @@ void start_screen(void)
 			{
 				break;
 			}
+
+			// If the input is 'v'/'V', start a race with the board on
+			// the other end of the link.
+			if (serial_input == 'v' || serial_input == 'V')
+			{
+				versus_mode = true;
+				break;
+			}
+
+			// If the input is 'e'/'E', open the level editor.
+			if (serial_input == 'e' || serial_input == 'E')
+			{
+				editor_requested = true;
+				break;
+			}
+
+			// If the input is 'j'/'J', set up the joystick and keys.
+			if (serial_input == 'j' || serial_input == 'J')
+			{
+				input_setup_requested = true;
+				break;
+			}
+
+			// If the input is 't'/'T', switch between the LED matrix
+			// and headless mode (for boards without a matrix).
+			if (serial_input == 't' || serial_input == 'T')
+			{
+				ledmatrix_set_headless(!ledmatrix_is_headless());
+			}
+		}
+
+		// Join in if the other board has started a race.
+		if (versus_update(get_current_time()) & VERSUS_EVENT_STARTED)
+		{
+			versus_mode = true;
+			break;
 		}
 
 		// No button presses and no 's'/'S' typed into the terminal,
 		// we will loop back and do the checks again. We also update
 		// the start screen animation on the LED matrix here.
 		update_start_screen();
+
+		// Nothing else to do until the next interrupt.
+		idle_sleep();
+	}
+
+	// Clear the title so the game can be drawn on an empty terminal.
+	clear_terminal();
+}
+
+//Shows one digit of the step counter on the seven segment display. Each
+//call shows the other digit, so this must be called frequently.
+static void display_step_counter(void)
+{
+	uint8_t value;
+	if(ssd_digit == 0) {
+		value = step_counter % 10;
+		} else {
+		value = (step_counter / 10) % 10;
+	}
+	display_digit(value, ssd_digit);
+	/* Change the digit flag for next time. if 0 becomes 1, if 1 becomes 0. */
+	ssd_digit = 1 - ssd_digit;
+}
+
+//Clears terminal rows first_row to last_row (inclusive)
+static void clear_terminal_rows(int first_row, int last_row)
+{
+	for (int row = first_row; row <= last_row; row++) {
+		move_terminal_cursor(row, 0);
+		clear_to_end_of_line();
+	}
+}
+
+//Removes any hint from the LED matrix and stops any hint search
+static void cancel_hint(void)
+{
+	if (hint_status() == HINT_READY) {
+		paint_hint(hint.box_row, hint.box_col, hint.delta_row, hint.delta_col, false);
+	}
+	hint_cancel();
+}
+
+//Starts searching for a hint from the current board
+static void request_hint(void)
+{
+	cancel_hint();
+	hint_start(get_game_layout());
+	hint_position = get_position_hash();
+	move_terminal_cursor(20, 1);
+	put_str_P(PSTR("Looking for a hint..."));
+	clear_to_end_of_line();
+}
+
+//Runs the next slice of the hint search, and flashes the hint once found
+static void update_hint(uint32_t current_time)
+{
+	if (hint_status() != HINT_IDLE && get_position_hash() != hint_position) {
+		cancel_hint();
+		return;
+	}
+	if (hint_status() == HINT_SEARCHING) {
+		HintStatus status = hint_step();
+		if (status == HINT_READY) {
+			hint_get(&hint);
+			hint_visible = false;
+			last_hint_flash_time = 0;
+			move_terminal_cursor(20, 1);
+			if (hint.optimal) {
+				put_str_P(PSTR("Hint: push the flashing box"));
+			} else {
+				put_str_P(PSTR("Hint (best guess): push the flashing box"));
+			}
+			clear_to_end_of_line();
+		} else if (status == HINT_STUCK) {
+			move_terminal_cursor(20, 1);
+			put_str_P(PSTR("No solution from here, try undo ('z') or restart"));
+			clear_to_end_of_line();
+		}
+	}
+	if (hint_status() == HINT_READY && current_time >= last_hint_flash_time + 250) {
+		hint_visible = !hint_visible;
+		paint_hint(hint.box_row, hint.box_col, hint.delta_row, hint.delta_col, hint_visible);
+		last_hint_flash_time = current_time;
+	}
+}
+
+//Shows the opponent's progress in a race
+static void display_opponent(uint32_t current_time)
+{
+	const VersusOpponent *opponent = versus_opponent();
+	move_terminal_cursor(23, 1);
+	opponent_shown_connected = versus_connected(current_time);
+	if (!opponent_shown_connected) {
+		put_str_P(PSTR("Opponent: not connected"));
+	} else {
+		put_str_P(PSTR("Opponent: level "));
+		put_u16(opponent->level);
+		put_str_P(PSTR(", "));
+		put_u16(opponent->steps);
+		if (!opponent->in_sync) {
+			put_str_P(PSTR(" steps (catching up)"));
+		} else if (versus_boxes_left() == 0) {
+			put_str_P(PSTR(" steps, finished!"));
+		} else {
+			put_str_P(PSTR(" steps, "));
+			put_u16(versus_boxes_left());
+			put_str_P(PSTR(" boxes left"));
+		}
+		put_str_P(PSTR("  (link "));
+		put_u16(versus_stats()->latency);
+		put_str_P(PSTR(" ms)"));
+	}
+	clear_to_end_of_line();
+}
+
+//Sends the whole board to the opponent in a race
+static void send_versus_snapshot(void)
+{
+	if (versus_mode) {
+		versus_send_snapshot(get_game_layout(), step_counter);
+	}
+}
+
+//Tells the opponent in a race, and any telemetry reader, about a move
+static void report_move(int8_t delta_row, int8_t delta_col)
+{
+	if (versus_mode) {
+		versus_send_move(delta_row, delta_col);
+	}
+	telemetry_move(delta_row, delta_col, step_counter);
+	if (is_repeated_arrangement()) {
+		move_terminal_cursor(20, 1);
+		put_str_P(PSTR("The boxes are back where they were a few pushes ago"));
+		clear_to_end_of_line();
+	}
+}
+
+//Moves the player (diagonally if both deltas are set), and counts, reports
+//and sounds the move if it was made
+static void make_move(int8_t delta_row, int8_t delta_col)
+{
+	bool moved;
+	if (delta_row && delta_col) {
+		moved = move_diagonal(0, delta_col, delta_row, 0);
+	} else {
+		moved = move_player(delta_row, delta_col);
+	}
+	if (moved) {
+		step_counter += (delta_row && delta_col) ? 2 : 1;
+		report_move(delta_row, delta_col);
+		music_effect(SOUND_MOVE);
+		last_input = get_current_time();
+		accept_input = false;
+	}
+	last_flash_time = get_current_time();
+}
+
+//Handles messages from the opponent in a race
+static void update_versus(uint32_t current_time)
+{
+	if (!versus_mode) {
+		return;
+	}
+	uint8_t events = versus_update(current_time);
+	if (events & VERSUS_EVENT_SNAPSHOT) {
+		send_versus_snapshot();
+	}
+	//No frames arrive once the other board is unplugged or reset, so the
+	//loss of the connection is an event of its own
+	if (events || versus_connected(current_time) != opponent_shown_connected) {
+		display_opponent(current_time);
 	}
 }
 
-void new_game(int level)
+void new_game(void)
 {
-	// Clear the serial terminal.
+	// Clear the messages and game over text left by the last level. The
+	// board itself is overwritten in place, so there is no need to clear
+	// the whole terminal.
 	hide_cursor();
-	clear_terminal();
+	clear_terminal_rows(14, 20);
 
-	// Initialise the game and display.
-	initialise_game(level);
+	// Initialise the game and display. This redraws the whole matrix, so any
+	// hint from the last level only needs its search stopping.
+	if (ledmatrix_is_headless()) {
+		//The terminal may have been drawn over since the last level
+		termview_invalidate();
+	}
+	campaign_load(get_level_buffer());
+	initialise_game(get_level_buffer());
+	hint_cancel();
+	if (versus_mode) {
+		versus_start(campaign_level());
+		display_opponent(get_current_time());
+	}
+	telemetry_level_start(campaign_level(), campaign_par());
 	move_terminal_cursor(10, 1);
-	printf("Level: %d", current_level);
+	put_str_P(PSTR("Level: "));
+	put_u16(campaign_level());
+	clear_to_end_of_line();
 	
 	//Play start sound
-	DDRD |= (1 << 6); 
-	play_start_sound(buzzer_enabled);
+	music_effect(SOUND_START);
 
 	// Clear all button presses and serial inputs, so that potentially
 	// buffered inputs aren't going to make it to the new game.
@@ -175,45 +495,26 @@ void new_game(int level)
 	
 	//Reset step counter
 	step_counter = 0;
-}
-
-void play_game(void)
-{
-	//Prepare variables for joystick
-	uint16_t value_x;
-	uint16_t value_y;
-	
-	//Initialise step counter
-	step_counter = 0;
-	uint8_t value = 0;
-	uint8_t digit = 0; /* 0 = right, 1 = left */
+	ssd_digit = 0;
 	DDRC = 0xFF;
-	DDRD = (1 << 5);
+	DDRD |= (1 << 5);
 	
-	uint32_t last_flash_time = get_current_time();
-	uint32_t last_target_flash_time = get_current_time();
-	uint32_t last_animation_flash = get_current_time();
-	uint32_t last_input = 0;
-	
-	bool accept_input = true;
+	last_flash_time = get_current_time();
+	last_target_flash_time = get_current_time();
+	last_input = 0;
+	accept_input = true;
 	
+	//Start the game clock from zero
 	play_time = 0;
-	char play_time_str[20];
-	
-	uint16_t sensitivity_diagonal = 200;
-	uint16_t sensitivity_regular = 400;
-	
-	//Set rest values for joystick (ensure joystick is at rest when starting game)
-	ADMUX &= ~1;
-	ADCSRA |= (1<<ADSC);
-	while(ADCSRA & (1<<ADSC)) {;}
-	uint16_t rest_value_x = ADC;
+	start_game_clock();
 	
-	ADMUX |= 1;
-	ADCSRA |= (1<<ADSC);
-	while(ADCSRA & (1<<ADSC)) {;}
-	uint16_t rest_value_y = ADC;
+	//The joystick is at rest when the game starts (this sets its centre if
+	//it has not been calibrated)
+	input_joystick_at_rest(read_joystick_axis(0), read_joystick_axis(1));
+}
 
+GameState play_game(void)
+{
 	// We play the game until it's over.
 	while (!is_game_over())
 	{
@@ -228,126 +529,86 @@ void play_game(void)
 			serial_input = fgetc(stdin);
 		}
 		
-		if (tolower(serial_input) == 'z') {
-			if (undo_move()) {
-				step_counter--;
-			}
+		//Keys and buttons are looked up in the input map (see input.h)
+		Action action = input_key_action(serial_input);
+		if (btn != NO_BUTTON_PUSHED) {
+			action = input_button_action(btn);
 		}
 		
-		if (tolower(serial_input) == 'q') {
-			buzzer_enabled = 1 - buzzer_enabled;
-		}
+		//The joystick is read every time, so its hysteresis keeps up with it
+		int8_t delta_row;
+		int8_t delta_col;
+		input_joystick(read_joystick_axis(0), read_joystick_axis(1),
+				&delta_row, &delta_col);
 		
-		if (tolower(serial_input) == 'p') {
-			while (1) {
-				if (serial_input_available()) {
-					if (tolower(fgetc(stdin)) == 'p') {
-						break;
-					}
-				}
-				//Keep ssd looping
-				if(digit == 0) {
-					value = step_counter % 10;
-					} else {
-					value = (step_counter / 10) % 10;
+		switch (action) {
+			case ACTION_UP:
+				delta_row = 1;
+				delta_col = 0;
+				break;
+			case ACTION_DOWN:
+				delta_row = -1;
+				delta_col = 0;
+				break;
+			case ACTION_LEFT:
+				delta_row = 0;
+				delta_col = -1;
+				break;
+			case ACTION_RIGHT:
+				delta_row = 0;
+				delta_col = 1;
+				break;
+			//Take back the steps the undone move counted for (two if diagonal)
+			case ACTION_UNDO: {
+				uint8_t undone = undo_move();
+				if (undone) {
+					step_counter -= undone;
+					send_versus_snapshot();
+					telemetry_undo(step_counter);
 				}
-				PORTC = seven_seg[value];
-				PORTD = (digit << 5);
-				digit = 1 - digit;
+				break;
 			}
+			//Wind back to the level start, repainting only what has changed
+			case ACTION_RESTART:
+				if (rewind_game(0)) {
+					step_counter = 0;
+					send_versus_snapshot();
+					telemetry_undo(step_counter);
+				}
+				break;
+			case ACTION_SOUND:
+				buzzer_enabled = 1 - buzzer_enabled;
+				music_set_enabled(buzzer_enabled);
+				break;
+			case ACTION_MEMORY:
+				report_memory_usage(24);
+				break;
+			case ACTION_HINT:
+				request_hint();
+				break;
+			//Cycle through the colour themes and terminal palettes
+			case ACTION_THEME:
+				change_theme((theme_current() + 1) % NUM_THEMES, theme_palette());
+				break;
+			case ACTION_PALETTE:
+				change_theme(theme_current(), (theme_palette() + 1) % NUM_PALETTES);
+				break;
+			//Turn the binary telemetry stream on or off
+			case ACTION_TELEMETRY:
+				telemetry_enable(!telemetry_enabled());
+				if (telemetry_enabled()) {
+					telemetry_level_start(campaign_level(), campaign_par());
+				}
+				break;
+			case ACTION_PAUSE:
+				pause_game_clock();
+				return STATE_PAUSED;
+			default:
+				break;
 		}
 		
-		//Detect values x and y from joystick
-		//value x:
-		ADMUX &= ~1;
-		// Start the ADC conversion
-		ADCSRA |= (1<<ADSC);
-		while(ADCSRA & (1<<ADSC)) {
-			; /* Wait until conversion finished */
-		}
-		value_x = ADC; // read the value
-		
-		//value y:
-		ADMUX |= 1;
-		// Start the ADC conversion
-		ADCSRA |= (1<<ADSC);
-		while(ADCSRA & (1<<ADSC)) {
-			; /* Wait until conversion finished */
-		}
-		value_y = ADC; // read the value
-		
-		if ((value_x < rest_value_x-sensitivity_diagonal && value_y > rest_value_y+sensitivity_diagonal) && accept_input) {
-			if (move_diagonal(0,-1,1,0)) {
-				step_counter += 2;
-				DDRD |= (1 << 6);
-				play_move_sound(buzzer_enabled);
-				last_input = get_current_time();
-				accept_input = false;
-			}
-			last_flash_time = get_current_time();
-		} else if ((value_x < rest_value_x-sensitivity_diagonal && value_y < rest_value_y-sensitivity_diagonal) && accept_input) {
-			if (move_diagonal(0,-1,-1,0)) {
-				step_counter += 2;
-				DDRD |= (1 << 6);
-				play_move_sound(buzzer_enabled);
-				last_input = get_current_time();
-				accept_input = false;
-			}
-			last_flash_time = get_current_time();
-		} else if ((value_x > rest_value_x+sensitivity_diagonal && value_y < rest_value_y-sensitivity_diagonal) && accept_input) {
-			if (move_diagonal(0,1,-1,0)) {
-				step_counter += 2;
-				DDRD |= (1 << 6);
-				play_move_sound(buzzer_enabled);
-				last_input = get_current_time();
-				accept_input = false;
-			}
-			last_flash_time = get_current_time();
-		} else if ((value_x > rest_value_x+sensitivity_diagonal && value_y > rest_value_y+sensitivity_diagonal) && accept_input) {
-			if (move_diagonal(0,1,1,0)) {
-				step_counter += 2;
-				DDRD |= (1 << 6);
-				play_move_sound(buzzer_enabled);
-				last_input = get_current_time();
-				accept_input = false;
-			}
-			last_flash_time = get_current_time();
-		} else if ((btn == BUTTON0_PUSHED || tolower(serial_input) == 'd' || value_x > rest_value_x+sensitivity_regular) && accept_input) {
-			if (move_player(0, 1)) {
-				step_counter++; 
-				DDRD |= (1 << 6); 
-				play_move_sound(buzzer_enabled);
-				last_input = get_current_time();
-				accept_input = false;
-			}
-			last_flash_time = get_current_time();
-		} else if ((btn == BUTTON1_PUSHED || tolower(serial_input) == 's' || value_y < rest_value_y-sensitivity_regular) && accept_input) {
-			if (move_player(-1, 0)) {
-				step_counter++; 
-				DDRD |= (1 << 6); 
-				play_move_sound(buzzer_enabled);
-				last_input = get_current_time();
-				accept_input = false;
-			}
-			last_flash_time = get_current_time();
-		} else if ((btn == BUTTON2_PUSHED || tolower(serial_input) == 'w' || value_y > rest_value_y+sensitivity_regular) && accept_input) {
-			if (move_player(1, 0)) {
-				step_counter++; 
-				DDRD |= (1 << 6); 
-				play_move_sound(buzzer_enabled);
-				last_input = get_current_time();
-				accept_input = false;
-			}
-			last_flash_time = get_current_time();
-		} else if ((btn == BUTTON3_PUSHED || tolower(serial_input) == 'a' || value_x < rest_value_x-sensitivity_regular) && accept_input) {
-			if (move_player(0, -1)) {
-				step_counter++; 
-				DDRD |= (1 << 6); 
-				play_move_sound(buzzer_enabled);
-				last_input = get_current_time();
-				accept_input = false;
-			}
-			last_flash_time = get_current_time();
+		if ((delta_row || delta_col) && accept_input) {
+			make_move(delta_row, delta_col);
 		}
 
 		uint32_t current_time = get_current_time();
@@ -368,60 +629,108 @@ void play_game(void)
 			accept_input = true;
 		}
 		
-		//Display step counter on seven segment display
-		if(digit == 0) {
-			value = step_counter % 10;
-			} else {
-			value = (step_counter / 10) % 10;
+		//Search for and show any hint the player asked for
+		update_hint(current_time);
+		
+		//Draw the next frame of any box animations
+		anim_update();
+		
+		//Keep up with the opponent in a race
+		update_versus(current_time);
+		
+		//Without an LED matrix, draw this frame's changes on the terminal
+		if (ledmatrix_is_headless()) {
+			termview_set_status(step_counter, play_time);
+			termview_render();
 		}
-		PORTC = seven_seg[value];
-		PORTD = (digit << 5);
-		/* Change the digit flag for next time. if 0 becomes 1, if 1 becomes 0. */
-		digit = 1 - digit;
 		
-		//Increment timer if necessary
-		if (get_current_time() % 1000 == 0) {
+		//Display step counter on seven segment display
+		display_step_counter();
+		
+		//Update the play time display when the game clock ticks over
+		if (game_clock_seconds_changed()) {
+			play_time = get_game_clock_seconds();
 			move_terminal_cursor(22, 1);
-			sprintf(play_time_str, "%d", play_time);
-			printf("%s", play_time_str);
-			play_time++;
-			_delay_ms(10);
+			put_u16(play_time);
+			clear_to_end_of_line();
+			telemetry_tick(current_time, play_time);
 		}
-		DDRD &= (11111101);
 	}
-	DDRD |= (1 << 6); 
-	play_victory_sound(buzzer_enabled);
-	DDRD &= (11111101);
-	handle_game_over();
+	//Stop the clock so the score uses the time the level was solved
+	pause_game_clock();
+	play_time = get_game_clock_seconds();
+	//Unlock the next level
+	campaign_complete_level();
+	music_effect(SOUND_VICTORY);
+	return STATE_GAME_OVER;
+}
+
+GameState pause_game(void)
+{
+	while (1) {
+		if (serial_input_available()) {
+			if (input_key_action(fgetc(stdin)) == ACTION_PAUSE) {
+				break;
+			}
+		}
+		//Keep ssd looping
+		display_step_counter();
+		idle_sleep();
+	}
+	resume_game_clock();
+	return STATE_PLAYING;
 }
 
 void increment_step_counter(void) {
 	step_counter++;
 }
 
-void handle_game_over(void)
+GameState handle_game_over(void)
 {
 	move_terminal_cursor(14, 10);
-	printf_P(PSTR("GAME OVER"));
+	put_str_P(PSTR("GAME OVER"));
 	move_terminal_cursor(15, 10);
-	printf_P(PSTR("Press 'r'/'R' to restart, 'e'/'E' to exit,"));
+	put_str_P(PSTR("Press 'r'/'R' to restart, 'e'/'E' to exit, 'n'/'N' for"));
 	move_terminal_cursor(16, 10);
-	printf_P(PSTR("or press 'n'/'N' to progress to level 2"));
+	put_str_P(PSTR("the next level, 'b'/'B' for the previous level or"));
+	move_terminal_cursor(17, 10);
+	put_str_P(PSTR("'l'/'L' to select a level"));
 	
-	//calculate and print score
-	int score = 0;
-	if (200-step_counter > 0) {
-		score += 200-step_counter;
+	//calculate and print score, against the level's pars
+	uint16_t pushes = get_push_count();
+	uint16_t score = campaign_score(step_counter, pushes, play_time);
+	move_terminal_cursor(18, 10);
+	put_str_P(PSTR("Score: "));
+	put_u16(score);
+	put_str_P(PSTR("  Moves: "));
+	put_u16(step_counter);
+	if (campaign_par()) {
+		put_str_P(PSTR(" (par "));
+		put_u16(campaign_par());
+		put_char(')');
 	}
-	if (1200-play_time > 0) {
-		score += 1200-play_time;
+	put_str_P(PSTR("  Pushes: "));
+	put_u16(pushes);
+	if (campaign_push_par()) {
+		put_str_P(PSTR(" (par "));
+		put_u16(campaign_push_par());
+		put_char(')');
+	}
+	telemetry_level_clear(campaign_level(), step_counter, play_time, score);
+	
+	//Report how long the CPU has spent in idle sleep
+	move_terminal_cursor(19, 10);
+	put_str_P(PSTR("Time asleep: "));
+	put_u16(get_sleep_time() / 1000);
+	put_str_P(PSTR(" s"));
+	
+	//Scroll a banner across the LED matrix until the player moves on
+	if (campaign_level() == NUM_LEVELS) {
+		anim_start_banner(BANNER_YOU_WIN);
+	} else {
+		anim_start_banner(BANNER_LEVEL_CLEAR);
 	}
-	move_terminal_cursor(18, 10);
-	printf("Score: %d", score);
 
-	//For ssd
-	int digit = 0;
-	int value;
 	// Do nothing until a valid input is made.
 	while (1)
 	{
@@ -435,26 +744,526 @@ void handle_game_over(void)
 
 		// Check serial input.
 		if (toupper(serial_input) == 'R') {
-			new_game(current_level);
-			play_game();
+			new_game();
+			return STATE_PLAYING;
 		} else if (toupper(serial_input) == 'E') {
-			current_level = 1;
-			start_screen();
-			new_game(current_level);
-			play_game();
-		} else if (toupper(serial_input) == 'N') {
-			current_level = 2;
-			new_game(current_level);
-			play_game();
+			anim_cancel();
+			return STATE_START;
+		} else if ((toupper(serial_input) == 'N' && campaign_next())
+				|| (toupper(serial_input) == 'B' && campaign_previous())) {
+			new_game();
+			return STATE_PLAYING;
+		} else if (toupper(serial_input) == 'L') {
+			anim_cancel();
+			return STATE_LEVEL_SELECT;
 		}
 		
-		if(digit == 0) {
-			value = step_counter % 10;
+		anim_update();
+		update_versus(get_current_time());
+		if (ledmatrix_is_headless()) {
+			termview_render();
+		}
+		display_step_counter();
+		idle_sleep();
+	}
+}
+
+GameState level_select(void)
+{
+	clear_terminal_rows(14, 21);
+	move_terminal_cursor(14, 10);
+	put_str_P(PSTR("SELECT LEVEL"));
+	
+	//List each level with its par, or show that it is still locked. The
+	//custom levels from the level editor follow the built in levels.
+	for (uint8_t level = 1; level <= NUM_CAMPAIGN_LEVELS; level++) {
+		move_terminal_cursor(15 + level, 10);
+		put_u16(level);
+		if (level > NUM_LEVELS) {
+			if (campaign_is_unlocked(level)) {
+				put_str_P(PSTR(": custom"));
+			} else if (versus_mode) {
+				//The opponent's board has no copy of the custom levels
+				put_str_P(PSTR(": custom (not in a race)"));
 			} else {
-			value = (step_counter / 10) % 10;
+				put_str_P(PSTR(": custom (empty)"));
+			}
+		} else if (campaign_is_unlocked(level)) {
+			put_str_P(PSTR(": par "));
+			put_u16(get_level_par(level));
+			put_str_P(PSTR(" moves, "));
+			put_u16(get_level_push_par(level));
+			put_str_P(PSTR(" pushes"));
+		} else {
+			put_str_P(PSTR(": locked"));
+		}
+	}
+	move_terminal_cursor(15, 10);
+	put_str_P(PSTR("Press a level number, or 'e'/'E' to exit"));
+	
+	while (1)
+	{
+		if (serial_input_available())
+		{
+			int serial_input = fgetc(stdin);
+			if (serial_input >= '1' && serial_input <= '9'
+					&& campaign_select(serial_input - '0')) {
+				new_game();
+				return STATE_PLAYING;
+			} else if (toupper(serial_input) == 'E') {
+				return STATE_START;
+			}
 		}
-		PORTC = seven_seg[value];
-		PORTD = (digit << 5);
-		digit = 1- digit;
+		display_step_counter();
+		idle_sleep();
 	}
-}
\ No newline at end of file
+}
+//Shows the square under the level editor's cursor
+static void show_editor_cursor(void)
+{
+	uint8_t row;
+	uint8_t col;
+	uint8_t object = editor_cursor(&row, &col);
+	move_terminal_cursor(19, 1);
+	put_str_P(PSTR("Cursor: row "));
+	put_u16(row);
+	put_str_P(PSTR(", column "));
+	put_u16(col);
+	switch (object) {
+		case WALL:
+			put_str_P(PSTR(", wall"));
+			break;
+		case BOX:
+			put_str_P(PSTR(", box"));
+			break;
+		case TARGET:
+			put_str_P(PSTR(", target"));
+			break;
+		case BOX | TARGET:
+			put_str_P(PSTR(", box on a target"));
+			break;
+		default:
+			put_str_P(PSTR(", room"));
+			break;
+	}
+	clear_to_end_of_line();
+}
+
+//Shows what saving the level found
+static void show_editor_status(EditorStatus status)
+{
+	move_terminal_cursor(20, 1);
+	switch (status) {
+		case EDITOR_CHECKING:
+			put_str_P(PSTR("Checking the level can be solved..."));
+			break;
+		case EDITOR_SAVED:
+			put_str_P(PSTR("Saved"));
+			break;
+		case EDITOR_SAVED_UNPROVEN:
+			put_str_P(PSTR("Saved, but no solution was found in time"));
+			break;
+		case EDITOR_NO_BOXES:
+			put_str_P(PSTR("Not saved: there are no boxes"));
+			break;
+		case EDITOR_COUNT_MISMATCH:
+			put_str_P(PSTR("Not saved: there must be as many targets as boxes"));
+			break;
+		case EDITOR_ALREADY_SOLVED:
+			put_str_P(PSTR("Not saved: every box is already on a target"));
+			break;
+		case EDITOR_PLAYER_BLOCKED:
+			put_str_P(PSTR("Not saved: the player starts on a wall or box"));
+			break;
+		case EDITOR_UNREACHABLE:
+			put_str_P(PSTR("Not saved: the player can't get to every box and target"));
+			break;
+		case EDITOR_UNSOLVABLE:
+			put_str_P(PSTR("Not saved: the level can't be solved"));
+			break;
+		default:
+			break;
+	}
+	clear_to_end_of_line();
+}
+
+//Loads a custom level slot into the level editor
+static void open_editor_slot(uint8_t slot)
+{
+	if (ledmatrix_is_headless()) {
+		termview_invalidate();
+	}
+	editor_start(slot);
+	move_terminal_cursor(10, 1);
+	put_str_P(PSTR("Level editor: custom level "));
+	put_u16(NUM_LEVELS + 1 + slot);
+	if (!editor_is_saved()) {
+		put_str_P(PSTR(" (new)"));
+	}
+	clear_to_end_of_line();
+	show_editor_cursor();
+	show_editor_status(EDITOR_EDITING);
+}
+
+GameState level_editor(void)
+{
+	hide_cursor();
+	open_editor_slot(editor_slot());
+	move_terminal_cursor(14, 1);
+	put_str_P(PSTR("Move: joystick or w/a/s/d    Change square: B0 or space"));
+	move_terminal_cursor(15, 1);
+	put_str_P(PSTR("Set square: '-' room, '#' wall, '$' box, '.' target, '*' box on target"));
+	move_terminal_cursor(16, 1);
+	put_str_P(PSTR("Player start: B1 or '@'    Save: B2 or enter    Play: B3 or 'p'"));
+	move_terminal_cursor(17, 1);
+	put_str_P(PSTR("Custom level: '1' to '"));
+	put_char('0' + LEVELSTORE_SLOTS);
+	put_str_P(PSTR("'    Exit: 'e'"));
+	clear_button_presses();
+	clear_serial_input_buffer();
+
+	//The joystick must be at rest when the editor opens
+	input_joystick_at_rest(read_joystick_axis(0), read_joystick_axis(1));
+	uint32_t last_cursor_move = 0;
+	uint32_t last_cursor_flash = 0;
+	uint32_t last_player_flash = 0;
+	EditorStatus status = EDITOR_EDITING;
+
+	while (1) {
+		ButtonState btn = button_pushed();
+		int serial_input = -1;
+		if (serial_input_available()) {
+			serial_input = fgetc(stdin);
+		}
+		uint32_t current_time = get_current_time();
+
+		//Move the cursor with the keys, or with the joystick (repeating
+		//every 200ms while it is held)
+		int8_t delta_row;
+		int8_t delta_col;
+		input_joystick(read_joystick_axis(0), read_joystick_axis(1),
+				&delta_row, &delta_col);
+		if (current_time < last_cursor_move + 200) {
+			delta_row = 0;
+			delta_col = 0;
+		}
+		switch (tolower(serial_input)) {
+			case 'w':
+				delta_row = 1;
+				break;
+			case 's':
+				delta_row = -1;
+				break;
+			case 'd':
+				delta_col = 1;
+				break;
+			case 'a':
+				delta_col = -1;
+				break;
+		}
+		if (delta_row || delta_col) {
+			editor_move_cursor(delta_row, delta_col);
+			show_editor_cursor();
+			last_cursor_move = current_time;
+			last_cursor_flash = current_time;
+		}
+
+		//Change the square under the cursor
+		bool edited = true;
+		if (btn == BUTTON0_PUSHED || serial_input == ' ') {
+			editor_cycle();
+		} else if (serial_input == '-') {
+			editor_set(ROOM);
+		} else if (serial_input == '#') {
+			editor_set(WALL);
+		} else if (serial_input == '$') {
+			editor_set(BOX);
+		} else if (serial_input == '.') {
+			editor_set(TARGET);
+		} else if (serial_input == '*') {
+			editor_set(BOX | TARGET);
+		} else if (btn == BUTTON1_PUSHED || serial_input == '@') {
+			edited = editor_place_player();
+		} else {
+			edited = false;
+		}
+		if (edited) {
+			status = EDITOR_EDITING;
+			show_editor_cursor();
+			show_editor_status(status);
+		}
+
+		if (btn == BUTTON2_PUSHED || serial_input == '\r' || serial_input == '\n') {
+			status = editor_save();
+			show_editor_status(status);
+		} else if (btn == BUTTON3_PUSHED || tolower(serial_input) == 'p') {
+			if (editor_is_saved() && campaign_select(NUM_LEVELS + 1 + editor_slot())) {
+				new_game();
+				return STATE_PLAYING;
+			}
+			move_terminal_cursor(20, 1);
+			put_str_P(PSTR("Save the level before playing it"));
+			clear_to_end_of_line();
+		} else if (serial_input >= '1' && serial_input < '1' + LEVELSTORE_SLOTS) {
+			open_editor_slot(serial_input - '1');
+			status = EDITOR_EDITING;
+		} else if (tolower(serial_input) == 'e') {
+			return STATE_START;
+		}
+
+		//Run the next slice of the check for a solution
+		if (status == EDITOR_CHECKING) {
+			status = editor_update();
+			if (status != EDITOR_CHECKING) {
+				show_editor_status(status);
+			}
+		}
+
+		if (current_time >= last_cursor_flash + 250) {
+			editor_flash_cursor();
+			last_cursor_flash = current_time;
+		}
+		if (current_time >= last_player_flash + 200) {
+			flash_player();
+			last_player_flash = current_time;
+		}
+		if (ledmatrix_is_headless()) {
+			termview_render();
+		}
+		if (status != EDITOR_CHECKING) {
+			idle_sleep();
+		}
+	}
+}
+
+//Shows a message on the joystick and keys screen
+static void show_setup_message(const char *message)
+{
+	move_terminal_cursor(22, 1);
+	put_str_P(message);
+	clear_to_end_of_line();
+}
+
+//Lists each action with the key bound to it, and the joystick's profile
+static void show_input_map(void)
+{
+	for (uint8_t action = ACTION_UP; action < NUM_ACTIONS; action++) {
+		move_terminal_cursor(3 + action, 5);
+		char key = input_action_key(action);
+		put_char(key ? key : '-');
+		put_str_P(PSTR("  "));
+		put_str_P(input_action_name(action));
+		clear_to_end_of_line();
+	}
+	uint8_t deadzone;
+	uint8_t threshold;
+	uint8_t hysteresis;
+	input_get_thresholds(&deadzone, &threshold, &hysteresis);
+	move_terminal_cursor(17, 5);
+	put_str_P(input_is_calibrated() ? PSTR("Joystick calibrated")
+			: PSTR("Joystick not calibrated"));
+	put_str_P(PSTR(", deadzone "));
+	put_u16(deadzone);
+	put_str_P(PSTR(", threshold "));
+	put_u16(threshold);
+	put_str_P(PSTR(" (of 127)"));
+	clear_to_end_of_line();
+}
+
+//Asks for the key to bind to an action
+static void ask_for_key(Action action)
+{
+	move_terminal_cursor(22, 1);
+	put_str_P(PSTR("Press the key for "));
+	put_str_P(input_action_name(action));
+	put_str_P(PSTR(" (a letter), or enter to keep it"));
+	clear_to_end_of_line();
+}
+
+//Shows why a key was not taken for an action, or which action it was taken
+//from, under the prompt
+static void show_key_warning(char key, const char *message, Action action)
+{
+	move_terminal_cursor(23, 1);
+	if (key) {
+		put_char('\'');
+		put_char(tolower(key));
+		put_char('\'');
+	}
+	put_str_P(message);
+	put_str_P(input_action_name(action));
+	clear_to_end_of_line();
+}
+
+//Whether an action must have a key, as the game cannot be played or paused
+//without it
+static bool needs_key(Action action)
+{
+	return (action >= ACTION_UP && action <= ACTION_RIGHT)
+			|| action == ACTION_PAUSE;
+}
+
+//Shows a joystick deflection as a signed number
+static void put_deflection(int8_t deflection)
+{
+	put_char(deflection < 0 ? '-' : '+');
+	put_u16(deflection < 0 ? -deflection : deflection);
+	put_str_P(PSTR("  "));
+}
+
+//Averages a few readings of a joystick axis
+static uint16_t read_joystick_average(uint8_t axis)
+{
+	uint16_t total = 0;
+	for (uint8_t i = 0; i < 8; i++) {
+		total += read_joystick_axis(axis);
+	}
+	return total / 8;
+}
+
+GameState input_setup(void)
+{
+	typedef enum {
+		SETUP_MENU,
+		SETUP_BINDING,		//Asking for the key of each action in turn
+		SETUP_CENTRE,		//Waiting for the joystick to be left at rest
+		SETUP_EXTENTS		//Sampling the joystick as it is moved round
+	} SetupStep;
+	SetupStep step = SETUP_MENU;
+	Action binding = ACTION_NONE;
+	uint32_t last_reading = 0;
+
+	clear_terminal();
+	move_terminal_cursor(2, 5);
+	put_str_P(PSTR("Joystick and keys"));
+	show_input_map();
+	move_terminal_cursor(20, 5);
+	put_str_P(PSTR("'k' change keys  'j' calibrate joystick  '+'/'-' thresholds"));
+	move_terminal_cursor(21, 5);
+	put_str_P(PSTR("'r' restore defaults  'e' exit"));
+	clear_button_presses();
+	clear_serial_input_buffer();
+
+	while (1) {
+		bool pushed = (button_pushed() != NO_BUTTON_PUSHED);
+		int serial_input = -1;
+		if (serial_input_available()) {
+			serial_input = fgetc(stdin);
+		}
+		bool confirm = pushed || serial_input == '\r' || serial_input == '\n';
+		uint32_t current_time = get_current_time();
+
+		if (step == SETUP_MENU) {
+			uint8_t deadzone;
+			uint8_t threshold;
+			uint8_t hysteresis;
+			input_get_thresholds(&deadzone, &threshold, &hysteresis);
+			if (tolower(serial_input) == 'k') {
+				step = SETUP_BINDING;
+				binding = ACTION_UP;
+				ask_for_key(binding);
+			} else if (tolower(serial_input) == 'j') {
+				step = SETUP_CENTRE;
+				show_setup_message(PSTR("Leave the joystick at rest, then press a button or enter"));
+			} else if (serial_input == '+' || serial_input == '-') {
+				//The deadzone stays half the threshold
+				threshold += (serial_input == '+') ? 8 : -8;
+				if (input_set_thresholds(threshold / 2, threshold, hysteresis)) {
+					input_save();
+					show_input_map();
+				}
+			} else if (tolower(serial_input) == 'r') {
+				input_restore_defaults();
+				input_joystick_at_rest(read_joystick_average(0),
+						read_joystick_average(1));
+				input_save();
+				show_input_map();
+				show_setup_message(PSTR("Defaults restored"));
+			} else if (tolower(serial_input) == 'e') {
+				return STATE_START;
+			}
+		} else if (step == SETUP_BINDING) {
+			bool is_letter = isalpha(serial_input);
+			Action owner = input_key_action(serial_input);
+			if (is_letter && owner != ACTION_NONE && owner < binding) {
+				//The keys set earlier in this pass are kept, so none of
+				//those actions is left without a key
+				show_key_warning(serial_input, PSTR(" is already the key for "), owner);
+			} else if (confirm && !input_action_key(binding) && needs_key(binding)) {
+				show_key_warning(0, PSTR("There must be a key for "), binding);
+			} else if (confirm || is_letter) {
+				move_terminal_cursor(23, 1);
+				clear_to_end_of_line();
+				if (is_letter) {
+					//The new key replaces the action's old keys. A key taken
+					//from an action still to come is asked for again then.
+					char key;
+					while ((key = input_action_key(binding))) {
+						input_bind(key, ACTION_NONE);
+					}
+					input_bind(serial_input, binding);
+					if (owner != ACTION_NONE && owner != binding) {
+						show_key_warning(serial_input, PSTR(" was taken from "), owner);
+					}
+				}
+				show_input_map();
+				if (++binding == NUM_ACTIONS) {
+					input_save();
+					step = SETUP_MENU;
+					show_setup_message(PSTR("Keys saved"));
+				} else {
+					ask_for_key(binding);
+				}
+			}
+		} else if (step == SETUP_CENTRE) {
+			if (confirm) {
+				input_calibrate_start(read_joystick_average(0),
+						read_joystick_average(1));
+				step = SETUP_EXTENTS;
+				show_setup_message(PSTR("Move the joystick round its edge a few times, then press a button or enter"));
+			}
+		} else {
+			input_calibrate_sample(read_joystick_axis(0), read_joystick_axis(1));
+			if (confirm) {
+				if (input_calibrate_finish()) {
+					input_save();
+					show_setup_message(PSTR("Joystick calibrated"));
+				} else {
+					show_setup_message(PSTR("The joystick did not move far enough, so it was not calibrated"));
+				}
+				show_input_map();
+				step = SETUP_MENU;
+			}
+		}
+
+		//Show what the joystick is doing, ten times a second
+		if (step == SETUP_MENU && current_time >= last_reading + 100) {
+			int8_t delta_row;
+			int8_t delta_col;
+			uint16_t x = read_joystick_axis(0);
+			uint16_t y = read_joystick_axis(1);
+			input_joystick(x, y, &delta_row, &delta_col);
+			move_terminal_cursor(18, 5);
+			put_str_P(PSTR("Joystick x "));
+			put_deflection(input_joystick_deflection(0, x));
+			put_str_P(PSTR("y "));
+			put_deflection(input_joystick_deflection(1, y));
+			put_str_P(PSTR("move "));
+			if (delta_row) {
+				put_str_P(input_action_name(delta_row > 0 ? ACTION_UP : ACTION_DOWN));
+				put_char(' ');
+			}
+			if (delta_col) {
+				put_str_P(input_action_name(delta_col > 0 ? ACTION_RIGHT : ACTION_LEFT));
+			}
+			if (!delta_row && !delta_col) {
+				put_str_P(input_action_name(ACTION_NONE));
+			}
+			clear_to_end_of_line();
+			last_reading = current_time;
+		}
+		if (step == SETUP_MENU) {
+			idle_sleep();
+		}
+	}
+}
@@ -36,18 +36,20 @@
 // bytes have been output). NOTE: OUTPUT_BUFFER_SIZE can not be larger than
 // 255 without changing the type of the variables below (currently defined as
 // 8-bit unsigned ints).
-#define OUTPUT_BUFFER_SIZE 255
+#define OUTPUT_BUFFER_SIZE SERIAL_OUTPUT_BUFFER_SIZE
 volatile char out_buffer[OUTPUT_BUFFER_SIZE];
 volatile uint8_t out_insert_pos;
 volatile uint8_t bytes_in_out_buffer;
+static uint8_t out_buffer_peak;
 
 // Circular buffer to hold incoming characters. Works on same principle
 // as output buffer.
-#define INPUT_BUFFER_SIZE 16
+#define INPUT_BUFFER_SIZE SERIAL_INPUT_BUFFER_SIZE
 volatile char input_buffer[INPUT_BUFFER_SIZE];
 volatile uint8_t input_insert_pos;
 volatile uint8_t bytes_in_input_buffer;
 volatile uint8_t input_overrun;
+static uint8_t input_buffer_peak;
 
 // Variable to keep track of whether incoming characters are to be echoed
 // back or not.
@@ -89,6 +91,10 @@ static int uart_put_char(char c, FILE *stream)
 	cli();
 	out_buffer[out_insert_pos++] = c;
 	bytes_in_out_buffer++;
+	if (bytes_in_out_buffer > out_buffer_peak)
+	{
+		out_buffer_peak = bytes_in_out_buffer;
+	}
 	if (out_insert_pos == OUTPUT_BUFFER_SIZE)
 	{
 		// Wrap around buffer pointer if necessary.
@@ -251,6 +257,10 @@ ISR(USART0_RX_vect)
 		// There is room in the input buffer.
 		input_buffer[input_insert_pos++] = c;
 		bytes_in_input_buffer++;
+		if (bytes_in_input_buffer > input_buffer_peak)
+		{
+			input_buffer_peak = bytes_in_input_buffer;
+		}
 		if (input_insert_pos == INPUT_BUFFER_SIZE)
 		{
 			// Wrap around buffer pointer if necessary.
@@ -292,6 +302,46 @@ void init_serial_stdio(long baudrate, bool echo)
 	stdin = &serialio;
 }
 
+void serial_put_char(char c)
+{
+	uart_put_char(c, 0);
+}
+
+bool serial_try_put(const uint8_t *data, uint8_t length)
+{
+	// Check for space and copy with interrupts off, so the block is never
+	// split by a character echoed from the receive ISR.
+	bool interrupts_enabled = bit_is_set(SREG, SREG_I);
+	cli();
+	if (OUTPUT_BUFFER_SIZE - bytes_in_out_buffer < length)
+	{
+		if (interrupts_enabled)
+		{
+			sei();
+		}
+		return false;
+	}
+	for (uint8_t i = 0; i < length; i++)
+	{
+		out_buffer[out_insert_pos++] = data[i];
+		if (out_insert_pos == OUTPUT_BUFFER_SIZE)
+		{
+			out_insert_pos = 0;
+		}
+	}
+	bytes_in_out_buffer += length;
+	if (bytes_in_out_buffer > out_buffer_peak)
+	{
+		out_buffer_peak = bytes_in_out_buffer;
+	}
+	UCSR0B |= (1 << UDRIE0);
+	if (interrupts_enabled)
+	{
+		sei();
+	}
+	return true;
+}
+
 bool serial_input_available(void)
 {
 	return bytes_in_input_buffer != 0;
@@ -303,3 +353,23 @@ void clear_serial_input_buffer(void)
 	input_insert_pos = 0;
 	bytes_in_input_buffer = 0;
 }
+
+uint8_t serial_output_buffer_used(void)
+{
+	return bytes_in_out_buffer;
+}
+
+uint8_t serial_output_buffer_peak(void)
+{
+	return out_buffer_peak;
+}
+
+uint8_t serial_input_buffer_used(void)
+{
+	return bytes_in_input_buffer;
+}
+
+uint8_t serial_input_buffer_peak(void)
+{
+	return input_buffer_peak;
+}
\ No newline at end of file
@@ -13,6 +13,11 @@
 #include <stdint.h>
 #include <stdbool.h>
 
+// Sizes of the output and input circular buffers, in bytes. Neither can be
+// larger than 255.
+#define SERIAL_OUTPUT_BUFFER_SIZE	255
+#define SERIAL_INPUT_BUFFER_SIZE	16
+
 /// <summary>
 /// Initialises serial I/O using the UART. This function must be called
 /// before any of the standard I/O functions. This function should only
@@ -22,6 +27,25 @@
 /// <param name="echo">Whether inputs are echoed back.</param>
 void init_serial_stdio(long baudrate, bool echo);
 
+/// <summary>
+/// Writes a character to the serial output buffer without going through
+/// stdio. Blocks until there is space in the buffer if interrupts are
+/// enabled, otherwise the character is discarded when the buffer is full.
+/// A linefeed is output as CR LF.
+/// </summary>
+/// <param name="c">The character to write.</param>
+void serial_put_char(char c);
+
+/// <summary>
+/// Writes a block of bytes to the serial output buffer, without any
+/// translation. Never blocks: if the whole block does not fit in the buffer
+/// nothing is written.
+/// </summary>
+/// <param name="data">The bytes to write.</param>
+/// <param name="length">The number of bytes.</param>
+/// <returns>Whether the bytes were written.</returns>
+bool serial_try_put(const uint8_t *data, uint8_t length);
+
 /// <summary>
 /// Tests if input is available from the serial port. If there is
 /// input available, then it can be read with a suitable standard I/O
@@ -36,4 +60,30 @@ bool serial_input_available(void);
 /// </summary>
 void clear_serial_input_buffer(void);
 
+/// <summary>
+/// Gets the number of bytes waiting in the output buffer.
+/// </summary>
+/// <returns>Bytes waiting to be transmitted.</returns>
+uint8_t serial_output_buffer_used(void);
+
+/// <summary>
+/// Gets the largest number of bytes that have been waiting in the output
+/// buffer at once.
+/// </summary>
+/// <returns>Peak output buffer occupancy.</returns>
+uint8_t serial_output_buffer_peak(void);
+
+/// <summary>
+/// Gets the number of received bytes waiting in the input buffer.
+/// </summary>
+/// <returns>Bytes waiting to be read.</returns>
+uint8_t serial_input_buffer_used(void);
+
+/// <summary>
+/// Gets the largest number of bytes that have been waiting in the input
+/// buffer at once.
+/// </summary>
+/// <returns>Peak input buffer occupancy.</returns>
+uint8_t serial_input_buffer_peak(void);
+
 #endif /* SERIALIO_H_ */
@@ -2,12 +2,28 @@
  * ssd.h
  *
  *  Author: Riley Stewart
+ *
+ * Seven segment display on port C, with the digit select line on pin D5.
  */ 
 
+#ifndef SSD_H_
+#define SSD_H_
+
 #include <stdint.h>
 
-void display_digit(uint8_t number, uint8_t digit);
+/// <summary>
+/// Looks up the segment pattern for a decimal digit. The table is stored in
+/// flash so it does not take up any SRAM.
+/// </summary>
+/// <param name="number">The digit to look up (0-9).</param>
+/// <returns>The segment pattern, or 0 (blank) for values above 9.</returns>
+uint8_t ssd_segments(uint8_t number);
 
-void init_ssd(void);
+/// <summary>
+/// Shows a digit on one side of the seven segment display.
+/// </summary>
+/// <param name="number">The digit to show (0-9).</param>
+/// <param name="digit">Which side to show it on (0 = right, 1 = left).</param>
+void display_digit(uint8_t number, uint8_t digit);
 
-void increment_counter(void);
\ No newline at end of file
+#endif /* SSD_H_ */
\ No newline at end of file
@@ -106,8 +106,8 @@ static const uint64_t title_data[] PROGMEM =
 // The colour definitions for the ASCII terminal title art. The positions
 // represent the columns which colour changes occur (highest to lowest), and
 // each position has a corresponding terminal attribute.
-const uint8_t title_pos[] = { 58, 48, 40, 32, 23, 15, 6 };
-const DisplayParameter title_attr[] = { BG_CYAN, BG_WHITE, BG_RED,
+static const uint8_t title_pos[] PROGMEM = { 58, 48, 40, 32, 23, 15, 6 };
+static const uint8_t title_attr[] PROGMEM = { BG_CYAN, BG_WHITE, BG_RED,
 	BG_YELLOW, BG_BLUE, BG_GREEN, BG_MAGENTA };
 
 // For course staff: Code and defintions blow this point should not be
@@ -241,9 +241,10 @@ static bool display_title_pixel(uint8_t line, uint8_t col, bool coloured)
 		{
 			for (uint8_t j = 0; j < countof(title_pos); j++)
 			{
-				if (col <= title_pos[j])
+				if (col <= pgm_read_byte(&title_pos[j]))
 				{
-					set_display_attribute(title_attr[j]);
+					set_display_attribute(
+						(DisplayParameter)pgm_read_byte(&title_attr[j]));
 				}
 			}
 			coloured = true;
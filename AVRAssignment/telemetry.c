@@ -0,0 +1,103 @@
+/*
+ * telemetry.c
+ *
+ * Author: Riley Stewart
+ */
+
+#include "telemetry.h"
+#include <stdint.h>
+#include <stdbool.h>
+#include <util/crc16.h>
+#include "serialio.h"
+
+// Packet framing around the payload: start, length, type and two CRC bytes.
+#define PACKET_OVERHEAD	(5)
+
+static bool enabled;
+static uint16_t dropped;
+
+void telemetry_enable(bool enable)
+{
+	enabled = enable;
+}
+
+bool telemetry_enabled(void)
+{
+	return enabled;
+}
+
+uint16_t telemetry_dropped(void)
+{
+	return dropped;
+}
+
+void telemetry_send(TelemetryType type, const uint8_t *payload, uint8_t length)
+{
+	if (!enabled)
+	{
+		return;
+	}
+
+	// The packet is built whole first, so it goes into the output buffer
+	// in one piece or not at all.
+	uint8_t packet[TELEMETRY_MAX_PAYLOAD + PACKET_OVERHEAD];
+	uint16_t crc = 0;
+	packet[0] = TELEMETRY_START;
+	packet[1] = length;
+	packet[2] = type;
+	for (uint8_t i = 0; i < length; i++)
+	{
+		packet[3 + i] = payload[i];
+	}
+	for (uint8_t i = 1; i < length + 3; i++)
+	{
+		crc = _crc_xmodem_update(crc, packet[i]);
+	}
+	packet[length + 3] = crc & 0xFF;
+	packet[length + 4] = crc >> 8;
+
+	if (!serial_try_put(packet, length + PACKET_OVERHEAD))
+	{
+		dropped++;
+	}
+}
+
+void telemetry_level_start(uint8_t level, uint16_t par)
+{
+	uint8_t payload[] = { level, par & 0xFF, par >> 8 };
+	telemetry_send(TELEMETRY_LEVEL_START, payload, sizeof(payload));
+}
+
+void telemetry_move(int8_t delta_row, int8_t delta_col, uint8_t steps)
+{
+	uint8_t payload[] = { (uint8_t)delta_row, (uint8_t)delta_col, steps };
+	telemetry_send(TELEMETRY_MOVE, payload, sizeof(payload));
+}
+
+void telemetry_push(uint8_t from_row, uint8_t from_col, uint8_t to_row,
+	uint8_t to_col, bool on_target)
+{
+	uint8_t payload[] = { from_row, from_col, to_row, to_col, on_target };
+	telemetry_send(TELEMETRY_PUSH, payload, sizeof(payload));
+}
+
+void telemetry_undo(uint8_t steps)
+{
+	telemetry_send(TELEMETRY_UNDO, &steps, 1);
+}
+
+void telemetry_level_clear(uint8_t level, uint8_t steps, uint16_t play_time,
+	uint16_t score)
+{
+	uint8_t payload[] = { level, steps, play_time & 0xFF, play_time >> 8,
+		score & 0xFF, score >> 8 };
+	telemetry_send(TELEMETRY_LEVEL_CLEAR, payload, sizeof(payload));
+}
+
+void telemetry_tick(uint32_t time, uint16_t play_time)
+{
+	uint8_t payload[] = { time & 0xFF, (time >> 8) & 0xFF, (time >> 16) & 0xFF,
+		time >> 24, play_time & 0xFF, play_time >> 8, dropped & 0xFF,
+		dropped >> 8 };
+	telemetry_send(TELEMETRY_TICK, payload, sizeof(payload));
+}
\ No newline at end of file
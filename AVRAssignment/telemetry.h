@@ -0,0 +1,116 @@
+/*
+ * telemetry.h
+ *
+ * Author: Riley Stewart
+ *
+ * Binary telemetry, sent on the same serial port as the terminal. Each
+ * event is sent as a packet:
+ *
+ *     STX  length  type  payload (length bytes)  CRC (2 bytes)
+ *
+ * STX (0x02) is never part of the terminal text, so a reader can pick the
+ * packets out of the text (see tools/teldecode.c). The CRC is CRC-16/XMODEM
+ * over the length, type and payload, sent low byte first, as are all
+ * multi-byte values.
+ *
+ * Telemetry is off until enabled. A packet that does not fit in the serial
+ * output buffer is dropped and counted rather than waited for, so the game
+ * never stalls for it.
+ */
+
+#ifndef TELEMETRY_H_
+#define TELEMETRY_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#define TELEMETRY_START			(0x02)
+#define TELEMETRY_MAX_PAYLOAD	(8)
+
+typedef enum
+{
+	TELEMETRY_LEVEL_START = 1,	// level, par (2)
+	TELEMETRY_MOVE,				// delta_row, delta_col, steps
+	TELEMETRY_PUSH,				// from_row, from_col, to_row, to_col, on_target
+	TELEMETRY_UNDO,				// steps
+	TELEMETRY_LEVEL_CLEAR,		// level, steps, play_time (2), score (2)
+	TELEMETRY_TICK				// time in ms (4), play_time (2), dropped (2)
+} TelemetryType;
+
+/// <summary>
+/// Turns telemetry on or off.
+/// </summary>
+/// <param name="enable">Whether to send telemetry.</param>
+void telemetry_enable(bool enable);
+
+/// <summary>
+/// Tests whether telemetry is on.
+/// </summary>
+/// <returns>Whether telemetry is being sent.</returns>
+bool telemetry_enabled(void);
+
+/// <summary>
+/// Gets the number of packets dropped because the output buffer was full.
+/// </summary>
+/// <returns>The number of packets dropped.</returns>
+uint16_t telemetry_dropped(void);
+
+/// <summary>
+/// Sends a packet, if telemetry is on. The packet is dropped if there is
+/// not room for all of it in the serial output buffer.
+/// </summary>
+/// <param name="type">The packet type.</param>
+/// <param name="payload">The payload.</param>
+/// <param name="length">The payload length (up to TELEMETRY_MAX_PAYLOAD).</param>
+void telemetry_send(TelemetryType type, const uint8_t *payload, uint8_t length);
+
+/// <summary>
+/// Reports that a level was started (or restarted).
+/// </summary>
+/// <param name="level">The level number.</param>
+/// <param name="par">The par for the level.</param>
+void telemetry_level_start(uint8_t level, uint16_t par);
+
+/// <summary>
+/// Reports a player move.
+/// </summary>
+/// <param name="delta_row">The change in row (-1, 0 or 1).</param>
+/// <param name="delta_col">The change in column (-1, 0 or 1).</param>
+/// <param name="steps">The step count after the move.</param>
+void telemetry_move(int8_t delta_row, int8_t delta_col, uint8_t steps);
+
+/// <summary>
+/// Reports a box push. This is sent before the move that made it.
+/// </summary>
+/// <param name="from_row">The row the box was on.</param>
+/// <param name="from_col">The column the box was on.</param>
+/// <param name="to_row">The row the box was pushed to.</param>
+/// <param name="to_col">The column the box was pushed to.</param>
+/// <param name="on_target">Whether the box is now on a target.</param>
+void telemetry_push(uint8_t from_row, uint8_t from_col, uint8_t to_row,
+	uint8_t to_col, bool on_target);
+
+/// <summary>
+/// Reports that a move was undone.
+/// </summary>
+/// <param name="steps">The step count after the undo.</param>
+void telemetry_undo(uint8_t steps);
+
+/// <summary>
+/// Reports that a level was solved.
+/// </summary>
+/// <param name="level">The level number.</param>
+/// <param name="steps">The number of steps taken.</param>
+/// <param name="play_time">The time taken, in seconds.</param>
+/// <param name="score">The score.</param>
+void telemetry_level_clear(uint8_t level, uint8_t steps, uint16_t play_time,
+	uint16_t score);
+
+/// <summary>
+/// Reports the time, along with the number of packets dropped so far.
+/// </summary>
+/// <param name="time">The time since power on, in milliseconds.</param>
+/// <param name="play_time">The time on the game clock, in seconds.</param>
+void telemetry_tick(uint32_t time, uint16_t play_time);
+
+#endif /* TELEMETRY_H_ */
\ No newline at end of file
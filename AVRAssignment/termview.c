@@ -0,0 +1,246 @@
+/*
+ * termview.c
+ *
+ * Author: Riley Stewart
+ */
+
+#include "termview.h"
+#include <stdint.h>
+#include <stdbool.h>
+#include <avr/pgmspace.h>
+#include "ledmatrix.h"
+#include "terminalio.h"
+#include "output.h"
+#include "theme.h"
+
+#define STATUS_LENGTH	(24)
+
+// Each number on the status line is five characters, enough for any uint16_t.
+#define STATUS_NUMBER_WIDTH	(5)
+
+// The image, and a bit per pixel (bit n of a row is column n) that is set
+// when the pixel has changed since the last render.
+static MatrixData frame;
+static uint16_t dirty[MATRIX_NUM_ROWS];
+
+// The status line, with a bit per character that has changed, and the
+// numbers on it.
+static char status[STATUS_LENGTH];
+static uint32_t status_dirty;
+static uint16_t status_moves;
+static uint16_t status_seconds;
+
+// Powers of ten for the digits of a status number, from the highest.
+static const uint16_t powers_of_ten[] PROGMEM = { 10000, 1000, 100, 10 };
+
+// Where the terminal cursor is after the last character sent, and the
+// background colour in use (or -1 if not known).
+static uint8_t cursor_row;
+static uint8_t cursor_col;
+static int16_t current_colour;
+
+void termview_set_pixel(uint8_t row, uint8_t col, PixelColour colour)
+{
+	if (frame[row][col] != colour)
+	{
+		frame[row][col] = colour;
+		dirty[row] |= (1U << col);
+	}
+}
+
+PixelColour termview_get_pixel(uint8_t row, uint8_t col)
+{
+	return frame[row][col];
+}
+
+static void set_status_char(uint8_t position, char c)
+{
+	if (status[position] != c)
+	{
+		status[position] = c;
+		status_dirty |= (1UL << position);
+	}
+}
+
+// Writes a number into the status line, right aligned in
+// STATUS_NUMBER_WIDTH characters. The digits are found by subtraction, as in
+// put_u16(), since the AVR has no divide instruction.
+static void set_status_number(uint8_t position, uint16_t number)
+{
+	bool started = false;
+	for (uint8_t i = 0; i < STATUS_NUMBER_WIDTH - 1; i++)
+	{
+		uint16_t power = pgm_read_word(&powers_of_ten[i]);
+		char digit = '0';
+		while (number >= power)
+		{
+			number -= power;
+			digit++;
+		}
+		started = started || digit != '0';
+		set_status_char(position + i, started ? digit : ' ');
+	}
+	set_status_char(position + STATUS_NUMBER_WIDTH - 1, '0' + number);
+}
+
+static void set_status_text(uint8_t position, const char *text)
+{
+	for (char c; (c = pgm_read_byte(text)); text++, position++)
+	{
+		set_status_char(position, c);
+	}
+}
+
+void termview_set_status(uint16_t moves, uint16_t seconds)
+{
+	// This is called on every pass of the main loop, but the numbers only
+	// change with a move or a second. The labels are written by
+	// termview_invalidate().
+	if (moves != status_moves)
+	{
+		status_moves = moves;
+		set_status_number(6, moves);
+	}
+	if (seconds != status_seconds)
+	{
+		status_seconds = seconds;
+		set_status_number(18, seconds);
+	}
+}
+
+void termview_invalidate(void)
+{
+	for (uint8_t row = 0; row < MATRIX_NUM_ROWS; row++)
+	{
+		dirty[row] = (1UL << MATRIX_NUM_COLUMNS) - 1;
+	}
+	// "Moves: nnnnn  Time: nnnnns"
+	set_status_text(0, PSTR("Moves:"));
+	set_status_number(6, status_moves);
+	set_status_text(11, PSTR("  Time:"));
+	set_status_number(18, status_seconds);
+	set_status_text(23, PSTR("s"));
+	status_dirty = (1UL << STATUS_LENGTH) - 1;
+	current_colour = -1;
+	cursor_row = 0xFF;
+}
+
+// Moves the cursor, unless it is already in the right place.
+static void move_cursor(uint8_t row, uint8_t col)
+{
+	if (row != cursor_row || col != cursor_col)
+	{
+		move_terminal_cursor(row, col);
+		cursor_row = row;
+		cursor_col = col;
+	}
+}
+
+// Picks the nearest of the eight basic colours (dim or bright) to an LED
+// colour, which is only ever a mix of red and green.
+static uint8_t basic_colour(uint8_t red, uint8_t green)
+{
+	uint8_t brightest = red > green ? red : green;
+	uint8_t colour;
+	if (brightest == 0)
+	{
+		return 40;
+	}
+	if (green * 2 < red)
+	{
+		colour = 1;		// red
+	}
+	else if (red * 2 < green)
+	{
+		colour = 2;		// green
+	}
+	else
+	{
+		colour = 3;		// yellow
+	}
+	return (brightest > 7 ? 100 : 40) + colour;
+}
+
+// Sets the terminal background to an LED colour, in the theme's palette.
+static void set_colour(PixelColour colour)
+{
+	if (current_colour == colour)
+	{
+		return;
+	}
+	current_colour = colour;
+	uint8_t red = colour & 0x0F;
+	uint8_t green = colour >> 4;
+	switch (theme_palette())
+	{
+		case PALETTE_256:
+			// Nearest point of the 6x6x6 colour cube.
+			put_str_P(PSTR("\x1b[48;5;"));
+			put_u16(16 + 36 * ((red * 5 + 7) / 15) + 6 * ((green * 5 + 7) / 15));
+			put_char('m');
+			break;
+		case PALETTE_TRUECOLOUR:
+			put_str_P(PSTR("\x1b[48;2;"));
+			put_u16(red * 17);
+			put_char(';');
+			put_u16(green * 17);
+			put_str_P(PSTR(";0m"));
+			break;
+		default:
+			put_escape(basic_colour(red, green), 'm');
+			break;
+	}
+}
+
+void termview_render(void)
+{
+	// The top row of the matrix is drawn at the top of the view.
+	for (uint8_t row = 0; row < MATRIX_NUM_ROWS; row++)
+	{
+		uint16_t changed = dirty[row];
+		if (!changed)
+		{
+			continue;
+		}
+		uint8_t terminal_row = TERMVIEW_ROW + MATRIX_NUM_ROWS - 1 - row;
+		for (uint8_t col = 0; changed; col++, changed >>= 1)
+		{
+			if (changed & 1)
+			{
+				move_cursor(terminal_row, TERMVIEW_COL + 2 * col);
+				set_colour(frame[row][col]);
+				put_str_P(PSTR("  "));
+				cursor_col += 2;
+			}
+		}
+		dirty[row] = 0;
+	}
+
+	if (status_dirty)
+	{
+		if (current_colour != -1)
+		{
+			normal_display_mode();
+			current_colour = -1;
+		}
+		for (uint8_t i = 0; i < STATUS_LENGTH; i++)
+		{
+			if (status_dirty & (1UL << i))
+			{
+				move_cursor(TERMVIEW_STATUS_ROW, TERMVIEW_COL + i);
+				put_char(status[i] ? status[i] : ' ');
+				cursor_col++;
+			}
+		}
+		status_dirty = 0;
+	}
+
+	// Leave the terminal as other code expects it. Any other output moves
+	// the cursor, so its position is forgotten too.
+	if (current_colour != -1)
+	{
+		normal_display_mode();
+	}
+	current_colour = -1;
+	cursor_row = 0xFF;
+}
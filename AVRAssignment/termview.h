@@ -0,0 +1,63 @@
+/*
+ * termview.h
+ *
+ * Author: Riley Stewart
+ *
+ * Terminal view of the LED matrix, for boards with no matrix attached (see
+ * ledmatrix_set_headless()). The matrix image is kept in RAM, with each
+ * pixel drawn as a double-width cell in its colour, and a status line with
+ * the move counter and timer sits below it.
+ *
+ * Changes are collected until termview_render(), which sends everything
+ * that changed since the last render as one burst, skipping cursor moves
+ * and colour changes where it can.
+ */
+
+#ifndef TERMVIEW_H_
+#define TERMVIEW_H_
+
+#include <stdint.h>
+#include "ledmatrix.h"
+
+// Terminal position of the top left cell (the top row of the matrix).
+#define TERMVIEW_ROW	(1)
+#define TERMVIEW_COL	(1)
+
+// Terminal row of the status line.
+#define TERMVIEW_STATUS_ROW	(TERMVIEW_ROW + MATRIX_NUM_ROWS + 2)
+
+/// <summary>
+/// Sets the colour of a pixel of the view.
+/// </summary>
+/// <param name="row">The row of the pixel.</param>
+/// <param name="col">The column of the pixel.</param>
+/// <param name="colour">The new colour.</param>
+void termview_set_pixel(uint8_t row, uint8_t col, PixelColour colour);
+
+/// <summary>
+/// Gets the colour of a pixel of the view.
+/// </summary>
+/// <param name="row">The row of the pixel.</param>
+/// <param name="col">The column of the pixel.</param>
+/// <returns>The colour of the pixel.</returns>
+PixelColour termview_get_pixel(uint8_t row, uint8_t col);
+
+/// <summary>
+/// Sets the move counter and timer shown on the status line.
+/// </summary>
+/// <param name="moves">The number of moves.</param>
+/// <param name="seconds">The time in seconds.</param>
+void termview_set_status(uint16_t moves, uint16_t seconds);
+
+/// <summary>
+/// Marks the whole view as needing to be drawn again, e.g. after the
+/// terminal has been cleared.
+/// </summary>
+void termview_invalidate(void);
+
+/// <summary>
+/// Sends everything that changed since the last render to the terminal.
+/// </summary>
+void termview_render(void);
+
+#endif /* TERMVIEW_H_ */
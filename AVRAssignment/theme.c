@@ -0,0 +1,164 @@
+/*
+ * theme.c
+ *
+ * Author: Riley Stewart
+ */
+
+#include "theme.h"
+#include <stdint.h>
+#include <stddef.h>
+#include <avr/pgmspace.h>
+#include "output.h"
+
+// The colours of one item. sgr is the SGR background code for the basic 16
+// colour palette and xterm is the index into the xterm 256 colour palette.
+typedef struct
+{
+	PixelColour led;
+	uint8_t sgr;
+	uint8_t xterm;
+	uint8_t red;
+	uint8_t green;
+	uint8_t blue;
+} ThemeColour;
+
+static const ThemeColour themes[NUM_THEMES][NUM_THEME_ITEMS] PROGMEM =
+{
+	[THEME_CLASSIC] =
+	{
+		[ITEM_ROOM]      = { COLOUR_BLACK,        100, 242, 0x6C, 0x6C, 0x6C },
+		[ITEM_WALL]      = { COLOUR_YELLOW,       103, 227, 0xFF, 0xFF, 0x5F },
+		[ITEM_BOX]       = { COLOUR_ORANGE,        43, 172, 0xD7, 0x87, 0x00 },
+		[ITEM_TARGET]    = { COLOUR_RED,           41, 160, 0xD7, 0x00, 0x00 },
+		[ITEM_DONE]      = { COLOUR_GREEN,        102,  83, 0x5F, 0xFF, 0x5F },
+		[ITEM_PLAYER]    = { COLOUR_DARK_GREEN,    42,  28, 0x00, 0x87, 0x00 },
+		[ITEM_HINT_BOX]  = { COLOUR_LIGHT_ORANGE, 105, 214, 0xFF, 0xAF, 0x00 },
+		[ITEM_HINT_PUSH] = { COLOUR_LIGHT_YELLOW, 107, 229, 0xFF, 0xFF, 0xAF }
+	},
+	// Full brightness LEDs only, and terminal colours as far apart as
+	// possible, with plain black rooms.
+	[THEME_HIGH_CONTRAST] =
+	{
+		[ITEM_ROOM]      = { COLOUR_BLACK,         40,  16, 0x00, 0x00, 0x00 },
+		[ITEM_WALL]      = { COLOUR_YELLOW,       107, 231, 0xFF, 0xFF, 0xFF },
+		[ITEM_BOX]       = { COLOUR_ORANGE,       103, 226, 0xFF, 0xFF, 0x00 },
+		[ITEM_TARGET]    = { COLOUR_RED,          105, 201, 0xFF, 0x00, 0xFF },
+		[ITEM_DONE]      = { COLOUR_GREEN,        102,  46, 0x00, 0xFF, 0x00 },
+		[ITEM_PLAYER]    = { COLOUR_GREEN,        106,  51, 0x00, 0xFF, 0xFF },
+		[ITEM_HINT_BOX]  = { COLOUR_RED,          104,  21, 0x00, 0x00, 0xFF },
+		[ITEM_HINT_PUSH] = { COLOUR_YELLOW,       101, 196, 0xFF, 0x00, 0x00 }
+	},
+	// Low brightness LEDs and dark terminal colours, for a dark room.
+	[THEME_DIM] =
+	{
+		[ITEM_ROOM]      = { COLOUR_BLACK,         40, 233, 0x12, 0x12, 0x12 },
+		[ITEM_WALL]      = { 0x22,                 47, 240, 0x58, 0x58, 0x58 },
+		[ITEM_BOX]       = { COLOUR_LIGHT_ORANGE,  43,  94, 0x87, 0x5F, 0x00 },
+		[ITEM_TARGET]    = { 0x03,                 41,  52, 0x5F, 0x00, 0x00 },
+		[ITEM_DONE]      = { 0x30,                 42,  22, 0x00, 0x5F, 0x00 },
+		[ITEM_PLAYER]    = { COLOUR_DARK_GREEN,    42,  28, 0x00, 0x87, 0x00 },
+		[ITEM_HINT_BOX]  = { COLOUR_LIGHT_YELLOW,  45,  90, 0x87, 0x00, 0x87 },
+		[ITEM_HINT_PUSH] = { COLOUR_LIGHT_GREEN,   46,  30, 0x00, 0x87, 0x87 }
+	}
+};
+
+static Theme current_theme = THEME_CLASSIC;
+static TerminalPalette current_palette = PALETTE_16;
+
+void theme_select(Theme theme, TerminalPalette palette)
+{
+	current_theme = theme;
+	current_palette = palette;
+}
+
+Theme theme_current(void)
+{
+	return current_theme;
+}
+
+TerminalPalette theme_palette(void)
+{
+	return current_palette;
+}
+
+PixelColour theme_led(ThemeItem item)
+{
+	return pgm_read_byte(&themes[current_theme][item].led);
+}
+
+void theme_set_background(ThemeItem item)
+{
+	const ThemeColour *colour = &themes[current_theme][item];
+	switch (current_palette)
+	{
+		case PALETTE_256:
+			put_str_P(PSTR("\x1b[48;5;"));
+			put_u16(pgm_read_byte(&colour->xterm));
+			break;
+		case PALETTE_TRUECOLOUR:
+			put_str_P(PSTR("\x1b[48;2;"));
+			put_u16(pgm_read_byte(&colour->red));
+			put_char(';');
+			put_u16(pgm_read_byte(&colour->green));
+			put_char(';');
+			put_u16(pgm_read_byte(&colour->blue));
+			break;
+		default:
+			put_escape(pgm_read_byte(&colour->sgr), 'm');
+			return;
+	}
+	put_char('m');
+}
+
+uint8_t theme_led_changes(Theme theme)
+{
+	uint8_t changes = 0;
+	for (uint8_t item = 0; item < NUM_THEME_ITEMS; item++)
+	{
+		if (pgm_read_byte(&themes[theme][item].led)
+			!= pgm_read_byte(&themes[current_theme][item].led))
+		{
+			changes |= (1 << item);
+		}
+	}
+	return changes;
+}
+
+uint8_t theme_terminal_changes(Theme theme, TerminalPalette palette)
+{
+	// Colours from different palettes are never exactly the same.
+	if (palette != current_palette)
+	{
+		return (1 << NUM_THEME_ITEMS) - 1;
+	}
+
+	uint8_t changes = 0;
+	for (uint8_t item = 0; item < NUM_THEME_ITEMS; item++)
+	{
+		const uint8_t *from = (const uint8_t *)&themes[current_theme][item];
+		const uint8_t *to = (const uint8_t *)&themes[theme][item];
+		uint8_t first;
+		uint8_t last;
+		if (palette == PALETTE_16)
+		{
+			first = last = offsetof(ThemeColour, sgr);
+		}
+		else if (palette == PALETTE_256)
+		{
+			first = last = offsetof(ThemeColour, xterm);
+		}
+		else
+		{
+			first = offsetof(ThemeColour, red);
+			last = offsetof(ThemeColour, blue);
+		}
+		for (uint8_t i = first; i <= last; i++)
+		{
+			if (pgm_read_byte(from + i) != pgm_read_byte(to + i))
+			{
+				changes |= (1 << item);
+			}
+		}
+	}
+	return changes;
+}
\ No newline at end of file
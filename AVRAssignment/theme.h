@@ -0,0 +1,104 @@
+/*
+ * theme.h
+ *
+ * Author: Riley Stewart
+ *
+ * Colour themes. A theme gives the LED matrix colour and the terminal
+ * colour of each kind of square. The themes are stored in program memory,
+ * and the terminal colours can be sent as the basic 16 colours, as an
+ * index into the 256 colour palette or as 24-bit colour, depending on what
+ * the terminal supports.
+ */
+
+#ifndef THEME_H_
+#define THEME_H_
+
+#include <stdint.h>
+#include "pixel_colour.h"
+
+// The things a theme gives colours to.
+typedef enum
+{
+	ITEM_ROOM,
+	ITEM_WALL,
+	ITEM_BOX,
+	ITEM_TARGET,
+	ITEM_DONE,		// A box on a target
+	ITEM_PLAYER,
+	ITEM_HINT_BOX,	// The box a hint says to push
+	ITEM_HINT_PUSH,	// The square a hint says to push it into
+	NUM_THEME_ITEMS
+} ThemeItem;
+
+typedef enum
+{
+	THEME_CLASSIC,
+	THEME_HIGH_CONTRAST,
+	THEME_DIM,
+	NUM_THEMES
+} Theme;
+
+// How terminal colours are sent.
+typedef enum
+{
+	PALETTE_16,			// SGR 40-47 and 100-107, supported everywhere
+	PALETTE_256,		// SGR 48;5;n
+	PALETTE_TRUECOLOUR,	// SGR 48;2;r;g;b
+	NUM_PALETTES
+} TerminalPalette;
+
+/// <summary>
+/// Selects the theme and terminal palette to use. Nothing is redrawn.
+/// </summary>
+/// <param name="theme">The theme to use.</param>
+/// <param name="palette">How to send terminal colours.</param>
+void theme_select(Theme theme, TerminalPalette palette);
+
+/// <summary>
+/// Gets the theme in use.
+/// </summary>
+/// <returns>The current theme.</returns>
+Theme theme_current(void);
+
+/// <summary>
+/// Gets the terminal palette in use.
+/// </summary>
+/// <returns>The current terminal palette.</returns>
+TerminalPalette theme_palette(void);
+
+/// <summary>
+/// Gets the LED matrix colour of an item in the current theme.
+/// </summary>
+/// <param name="item">The item.</param>
+/// <returns>The colour of the item.</returns>
+PixelColour theme_led(ThemeItem item);
+
+/// <summary>
+/// Sets the terminal background colour to the colour of an item in the
+/// current theme and palette.
+/// </summary>
+/// <param name="item">The item.</param>
+void theme_set_background(ThemeItem item);
+
+/// <summary>
+/// Finds which items would change colour on the LED matrix if another theme
+/// was selected.
+/// </summary>
+/// <param name="theme">The theme that would be selected.</param>
+/// <returns>A bit mask with bit (1 << item) set for each item that would
+/// change colour.</returns>
+uint8_t theme_led_changes(Theme theme);
+
+/// <summary>
+/// Finds which items would change colour on the terminal if another theme
+/// and palette were selected.
+/// </summary>
+/// <param name="theme">The theme that would be selected.</param>
+/// <param name="palette">The palette that would be selected.</param>
+/// <returns>A bit mask with bit (1 << item) set for each item that would
+/// change colour.</returns>
+uint8_t theme_terminal_changes(Theme theme, TerminalPalette palette);
+
+_Static_assert(NUM_THEME_ITEMS <= 8, "theme change masks are 8 bits");
+
+#endif /* THEME_H_ */
\ No newline at end of file
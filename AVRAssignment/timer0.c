@@ -13,6 +13,13 @@
 // overflow every ~49 days.
 static volatile uint32_t clock_ticks_ms;
 
+// The game clock. Milliseconds within the current second and whole seconds
+// are kept separately so that the interrupt handler never has to divide.
+static volatile bool game_clock_running;
+static volatile uint16_t game_clock_ms;
+static volatile uint16_t game_clock_seconds;
+static volatile bool game_clock_changed;
+
 void init_timer0(void)
 {
 	// Reset clock tick count. L indicates a long (32 bit) constant.
@@ -59,9 +66,83 @@ uint32_t get_current_time(void)
 	return result;
 }
 
+uint32_t get_current_time_counts(void)
+{
+	uint8_t interrupts_were_enabled = bit_is_set(SREG, SREG_I);
+	cli();
+	uint32_t ms = clock_ticks_ms;
+	uint8_t count = TCNT0;
+	// If the compare match has happened but the interrupt has not run yet
+	// (because interrupts are off), the millisecond count is one behind.
+	if ((TIFR0 & (1 << OCF0A)) && count < OCR0A)
+	{
+		ms++;
+	}
+	if (interrupts_were_enabled)
+	{
+		sei();
+	}
+	return ms * (OCR0A + 1) + count;
+}
+
+void start_game_clock(void)
+{
+	uint8_t interrupts_were_enabled = bit_is_set(SREG, SREG_I);
+	cli();
+	game_clock_ms = 0;
+	game_clock_seconds = 0;
+	game_clock_changed = true;
+	game_clock_running = true;
+	if (interrupts_were_enabled)
+	{
+		sei();
+	}
+}
+
+void pause_game_clock(void)
+{
+	game_clock_running = false;
+}
+
+void resume_game_clock(void)
+{
+	game_clock_running = true;
+}
+
+uint16_t get_game_clock_seconds(void)
+{
+	uint8_t interrupts_were_enabled = bit_is_set(SREG, SREG_I);
+	cli();
+	uint16_t result = game_clock_seconds;
+	if (interrupts_were_enabled)
+	{
+		sei();
+	}
+	return result;
+}
+
+bool game_clock_seconds_changed(void)
+{
+	// A single byte flag, so no need to turn interrupts off to read it.
+	if (game_clock_changed)
+	{
+		game_clock_changed = false;
+		return true;
+	}
+	return false;
+}
+
 // Interrupt handler for clock tick.
 ISR(TIMER0_COMPA_vect)
 {
 	// Increment our clock tick count.
 	clock_ticks_ms++;
+
+	// Advance the game clock if it is running.
+	if (game_clock_running && ++game_clock_ms == 1000)
+	{
+		game_clock_ms = 0;
+		game_clock_seconds++;
+		game_clock_changed = true;
+	}
 }
@@ -16,6 +16,7 @@
 #define TIMER0_H_
 
 #include <stdint.h>
+#include <stdbool.h>
 
 /// <summary>
 /// Initialises timer 0 for system clock. An interrupt will be generated
@@ -31,4 +32,42 @@ void init_timer0(void);
 /// <returns>Milliseconds since timer 0 was initialised.</returns>
 uint32_t get_current_time(void);
 
+/// <summary>
+/// Gets the current time in timer 0 counts (8 microseconds each, 125 per
+/// millisecond) since the timer was initialised. Useful for measuring
+/// intervals shorter than a millisecond.
+/// </summary>
+/// <returns>Timer 0 counts since timer 0 was initialised.</returns>
+uint32_t get_current_time_counts(void);
+
+/// <summary>
+/// Resets the game clock to zero and starts it running. The game clock is
+/// advanced by the timer 0 interrupt, so it does not depend on how often
+/// the main loop runs.
+/// </summary>
+void start_game_clock(void);
+
+/// <summary>
+/// Stops the game clock. Time does not accumulate until it is resumed.
+/// </summary>
+void pause_game_clock(void);
+
+/// <summary>
+/// Restarts the game clock after pause_game_clock().
+/// </summary>
+void resume_game_clock(void);
+
+/// <summary>
+/// Gets the number of whole seconds the game clock has been running for.
+/// </summary>
+/// <returns>Game clock seconds.</returns>
+uint16_t get_game_clock_seconds(void);
+
+/// <summary>
+/// Tests whether the game clock seconds count has changed since this
+/// function was last called, and clears the indication.
+/// </summary>
+/// <returns>Whether the seconds count has changed.</returns>
+bool game_clock_seconds_changed(void);
+
 #endif /* TIMER0_H_ */
@@ -10,6 +10,21 @@
 
 void init_timer1(void)
 {
-	// Setup timer 1.
+	// Clear the timer.
 	TCNT1 = 0;
+
+	// Divide the 8MHz clock by 64 and count up to 499, for an interrupt
+	// every 64 x 500 clock cycles, i.e. every 4 milliseconds. The counter
+	// is reset to 0 when it reaches the output compare value.
+	OCR1A = (8000000UL / 64 / 1000) * TIMER1_TICK_MS - 1;
+
+	// Clear on compare match (CTC mode), dividing the clock by 64. This
+	// starts the timer running.
+	TCCR1A = 0;
+	TCCR1B = (1 << WGM12) | (1 << CS11) | (1 << CS10);
+
+	// Enable an interrupt on output compare match, clearing the interrupt
+	// flag first by writing a 1 to it.
+	TIFR1 = (1 << OCF1A);
+	TIMSK1 |= (1 << OCIE1A);
 }
@@ -3,14 +3,20 @@
  *
  * Author: Peter Sutton
  *
- * Timer 1 skeleton.
+ * Timer 1 generates the music sequencer's tick (see music.h): an interrupt
+ * every TIMER1_TICK_MS milliseconds, handled in music.c.
  */
 
 #ifndef TIMER1_H_
 #define TIMER1_H_
 
+// The time between timer 1 interrupts, in milliseconds.
+#define TIMER1_TICK_MS	(4)
+
 /// <summary>
-/// Skeletal timer 1 initialisation function.
+/// Initialises timer 1 to generate an interrupt every TIMER1_TICK_MS
+/// milliseconds. Interrupts have to be enabled globally before the
+/// interrupts will fire.
 /// </summary>
 void init_timer1(void);
 
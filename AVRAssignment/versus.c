@@ -0,0 +1,281 @@
+/*
+ * versus.c
+ *
+ * Author: Riley Stewart
+ */
+
+#include "versus.h"
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include "game.h"
+#include "link.h"
+
+#define FRAME_START	(0x80)
+#define POSITION(row, col)	((uint8_t)((row) << 4 | (col)))
+
+static VersusOpponent opponent;
+static VersusStats stats;
+
+// The level we are playing, as last sent to the opponent.
+static uint8_t own_level;
+
+// Sequence number of the next frame to send, and the one expected next.
+static uint8_t send_sequence;
+static uint8_t receive_sequence;
+
+// The first byte of a frame that is waiting for its data byte, or 0.
+static uint8_t frame_header;
+
+// Whether a snapshot is being received with no frames lost so far.
+static bool receiving_snapshot;
+
+// The outstanding latency measurement.
+static uint8_t ping_token;
+static uint32_t ping_time;
+static bool ping_waiting;
+
+static void send_frame(VersusMessage type, uint8_t data)
+{
+	uint8_t header = FRAME_START | (type << 4) | send_sequence;
+	// A frame is only sent whole. A frame that does not fit is not sent at
+	// all, and shows up at the other end as a gap in the sequence numbers.
+	send_sequence = (send_sequence + 1) & 0x0F;
+	if (link_space() < 2 || !link_put_byte(header)
+		|| !link_put_byte(data & 0x7F))
+	{
+		stats.frames_dropped++;
+	}
+}
+
+// Sets the opponent's copy of the boxes and targets from the start of a level.
+static void load_level(uint8_t level)
+{
+	LevelLayout layout;
+	decode_level(level, &layout);
+	for (uint8_t row = 0; row < MATRIX_NUM_ROWS; row++)
+	{
+		uint16_t boxes = 0;
+		uint16_t targets = 0;
+		for (uint8_t col = 0; col < MATRIX_NUM_COLUMNS; col++)
+		{
+			if (layout.board[row][col] & BOX)
+			{
+				boxes |= (1U << col);
+			}
+			if (layout.board[row][col] & TARGET)
+			{
+				targets |= (1U << col);
+			}
+		}
+		opponent.boxes[row] = boxes;
+		opponent.targets[row] = targets;
+	}
+	opponent.level = level;
+	opponent.steps = 0;
+	opponent.player_row = layout.player_row;
+	opponent.player_col = layout.player_col;
+	opponent.in_sync = true;
+}
+
+// Moves the opponent's player, pushing a box if there is one in the way.
+static void apply_move(uint8_t data)
+{
+	int8_t delta_row = (int8_t)(data & 0x03) - 1;
+	int8_t delta_col = (int8_t)((data >> 2) & 0x03) - 1;
+	uint8_t row = WRAP_ROW(opponent.player_row + delta_row);
+	uint8_t col = WRAP_COL(opponent.player_col + delta_col);
+	if (opponent.boxes[row] & (1U << col))
+	{
+		uint8_t box_row = WRAP_ROW(row + delta_row);
+		uint8_t box_col = WRAP_COL(col + delta_col);
+		opponent.boxes[row] &= ~(1U << col);
+		opponent.boxes[box_row] |= (1U << box_col);
+	}
+	opponent.player_row = row;
+	opponent.player_col = col;
+	// A diagonal move counts as two steps, as it does on the board. Steps
+	// stop at 127, the most a snapshot can send.
+	opponent.steps += (delta_row && delta_col) ? 2 : 1;
+	if (opponent.steps > 127)
+	{
+		opponent.steps = 127;
+	}
+}
+
+// Handles one whole frame, and returns the VERSUS_EVENT_ flags for it.
+static uint8_t handle_frame(uint8_t header, uint8_t data, uint32_t now)
+{
+	VersusMessage type = (header >> 4) & 0x07;
+	uint8_t sequence = header & 0x0F;
+	uint8_t events = 0;
+
+	stats.frames_received++;
+	stats.last_frame_time = now;
+	if (sequence != receive_sequence)
+	{
+		// Frames were lost, so the copy of the opponent can no longer be
+		// trusted until a snapshot arrives.
+		stats.frames_lost += (sequence - receive_sequence) & 0x0F;
+		if (opponent.in_sync || receiving_snapshot)
+		{
+			send_frame(VERSUS_RESYNC, 0);
+		}
+		opponent.in_sync = false;
+		receiving_snapshot = false;
+		events |= VERSUS_EVENT_PROGRESS;
+	}
+	receive_sequence = (sequence + 1) & 0x0F;
+
+	switch (type)
+	{
+		case VERSUS_MOVE:
+			if (opponent.in_sync)
+			{
+				apply_move(data);
+				events |= VERSUS_EVENT_PROGRESS;
+			}
+			break;
+		case VERSUS_START:
+			if (data >= 1 && data <= NUM_LEVELS)
+			{
+				load_level(data);
+				events |= VERSUS_EVENT_STARTED | VERSUS_EVENT_PROGRESS;
+			}
+			break;
+		case VERSUS_PLAYER_AT:
+			memset(opponent.boxes, 0, sizeof(opponent.boxes));
+			opponent.player_row = data >> 4;
+			opponent.player_col = data & 0x0F;
+			opponent.in_sync = false;
+			receiving_snapshot = true;
+			break;
+		case VERSUS_BOX_AT:
+			opponent.boxes[data >> 4] |= (1U << (data & 0x0F));
+			break;
+		case VERSUS_SNAPSHOT_END:
+			if (receiving_snapshot)
+			{
+				opponent.steps = data;
+				opponent.in_sync = true;
+				receiving_snapshot = false;
+				events |= VERSUS_EVENT_PROGRESS;
+			}
+			break;
+		case VERSUS_RESYNC:
+			events |= VERSUS_EVENT_SNAPSHOT;
+			break;
+		case VERSUS_PING:
+			send_frame(VERSUS_PONG, data);
+			break;
+		case VERSUS_PONG:
+			if (ping_waiting && data == ping_token)
+			{
+				ping_waiting = false;
+				stats.latency = (uint16_t)((now - ping_time + 1) / 2);
+				if (stats.latency > stats.max_latency)
+				{
+					stats.max_latency = stats.latency;
+				}
+				events |= VERSUS_EVENT_LATENCY;
+			}
+			break;
+	}
+	return events;
+}
+
+void versus_start(uint8_t level)
+{
+	own_level = level;
+	send_frame(VERSUS_START, level);
+}
+
+void versus_send_move(int8_t delta_row, int8_t delta_col)
+{
+	send_frame(VERSUS_MOVE, (uint8_t)((delta_row + 1) | ((delta_col + 1) << 2)));
+}
+
+void versus_send_snapshot(const LevelLayout *state, uint8_t steps)
+{
+	// The level start comes first, so the targets are right even if the
+	// opponent missed the original start message.
+	send_frame(VERSUS_START, own_level);
+	send_frame(VERSUS_PLAYER_AT, POSITION(state->player_row, state->player_col));
+	for (uint8_t row = 0; row < MATRIX_NUM_ROWS; row++)
+	{
+		for (uint8_t col = 0; col < MATRIX_NUM_COLUMNS; col++)
+		{
+			if (state->board[row][col] & BOX)
+			{
+				send_frame(VERSUS_BOX_AT, POSITION(row, col));
+			}
+		}
+	}
+	send_frame(VERSUS_SNAPSHOT_END, steps > 127 ? 127 : steps);
+}
+
+uint8_t versus_update(uint32_t now)
+{
+	uint8_t events = 0;
+	uint8_t byte;
+	while (link_get_byte(&byte))
+	{
+		if (byte & FRAME_START)
+		{
+			// A header without data before it means that byte was lost,
+			// which the sequence number of this frame will show.
+			frame_header = byte;
+		}
+		else if (frame_header)
+		{
+			events |= handle_frame(frame_header, byte, now);
+			frame_header = 0;
+		}
+	}
+
+	// Start a new latency measurement every so often, or if the last ping
+	// or its answer was lost. A lost request for a snapshot is sent again
+	// at the same time.
+	if (now - ping_time >= VERSUS_PING_INTERVAL)
+	{
+		if (stats.frames_received && !opponent.in_sync && !receiving_snapshot)
+		{
+			send_frame(VERSUS_RESYNC, 0);
+		}
+		ping_token = (ping_token + 1) & 0x7F;
+		ping_time = now;
+		ping_waiting = true;
+		send_frame(VERSUS_PING, ping_token);
+	}
+	return events;
+}
+
+const VersusOpponent *versus_opponent(void)
+{
+	return &opponent;
+}
+
+uint8_t versus_boxes_left(void)
+{
+	uint8_t count = 0;
+	for (uint8_t row = 0; row < MATRIX_NUM_ROWS; row++)
+	{
+		uint16_t loose = opponent.boxes[row] & ~opponent.targets[row];
+		while (loose)
+		{
+			loose &= loose - 1;
+			count++;
+		}
+	}
+	return count;
+}
+
+bool versus_connected(uint32_t now)
+{
+	return stats.frames_received && now - stats.last_frame_time < VERSUS_TIMEOUT;
+}
+
+const VersusStats *versus_stats(void)
+{
+	return &stats;
+}
\ No newline at end of file
@@ -0,0 +1,139 @@
+/*
+ * versus.h
+ *
+ * Author: Riley Stewart
+ *
+ * Versus mode protocol. Two boards joined by the link (see link.h) race
+ * through the same level, and each keeps a copy of the other's boxes and
+ * player so it can show the opponent's progress.
+ *
+ * Every message is a two byte frame. The first byte has its top bit set and
+ * holds the message type and a 4-bit sequence number; the second byte has
+ * its top bit clear and holds 7 bits of data:
+ *
+ *     1 t t t s s s s    0 d d d d d d d
+ *
+ * so a receiver can always find the start of the next frame. A move is sent
+ * as the change in the player's position, and whether a box was pushed is
+ * worked out from the receiver's copy of the boxes. A receiver that sees a
+ * gap in the sequence numbers asks for a snapshot of the whole position.
+ *
+ * This module does not use any AVR hardware other than through link.h, so
+ * it can also be built on the host (see tools/).
+ */
+
+#ifndef VERSUS_H_
+#define VERSUS_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "levels.h"
+
+// Time between latency measurements, in milliseconds.
+#define VERSUS_PING_INTERVAL	(1000)
+
+// The opponent is shown as disconnected after this long without a frame,
+// in milliseconds.
+#define VERSUS_TIMEOUT	(3000)
+
+// Message types (the t bits of the first byte).
+typedef enum
+{
+	VERSUS_MOVE,		// data: (delta_row + 1) | (delta_col + 1) << 2
+	VERSUS_START,		// data: level; the sender is at the start of it
+	VERSUS_PLAYER_AT,	// data: row << 4 | col; first part of a snapshot
+	VERSUS_BOX_AT,		// data: row << 4 | col; one box of a snapshot
+	VERSUS_SNAPSHOT_END,// data: steps (up to 127); the snapshot is complete
+	VERSUS_RESYNC,		// data: unused; please send a snapshot
+	VERSUS_PING,		// data: token
+	VERSUS_PONG			// data: the token of the ping being answered
+} VersusMessage;
+
+// Events returned by versus_update(), as bit flags.
+#define VERSUS_EVENT_STARTED	(1 << 0)	// The opponent started a level
+#define VERSUS_EVENT_PROGRESS	(1 << 1)	// The opponent's position changed
+#define VERSUS_EVENT_SNAPSHOT	(1 << 2)	// Send a snapshot, see below
+#define VERSUS_EVENT_LATENCY	(1 << 3)	// A new latency was measured
+
+// What is known about the opponent.
+typedef struct
+{
+	uint8_t level;
+	uint8_t steps;		// Up to 127
+	uint8_t player_row;
+	uint8_t player_col;
+	// One bit per column (bit 0 = column 0) for each row.
+	uint16_t boxes[MATRIX_NUM_ROWS];
+	uint16_t targets[MATRIX_NUM_ROWS];
+	// False from a lost frame until a snapshot has been received.
+	bool in_sync;
+} VersusOpponent;
+
+typedef struct
+{
+	uint16_t frames_received;
+	uint16_t frames_lost;
+	uint16_t frames_dropped;	// Not sent because the link was full
+	uint16_t latency;			// One way, in milliseconds (half the round trip)
+	uint16_t max_latency;
+	uint32_t last_frame_time;
+} VersusStats;
+
+/// <summary>
+/// Tells the opponent we are starting a level. Call this whenever a level
+/// is started or restarted.
+/// </summary>
+/// <param name="level">The level number.</param>
+void versus_start(uint8_t level);
+
+/// <summary>
+/// Tells the opponent the player moved.
+/// </summary>
+/// <param name="delta_row">The change in row (-1, 0 or 1).</param>
+/// <param name="delta_col">The change in column (-1, 0 or 1).</param>
+void versus_send_move(int8_t delta_row, int8_t delta_col);
+
+/// <summary>
+/// Sends the whole position to the opponent. Call this after any change
+/// that is not a move (e.g. an undo) and whenever versus_update() returns
+/// VERSUS_EVENT_SNAPSHOT.
+/// </summary>
+/// <param name="state">The board and player position.</param>
+/// <param name="steps">The number of steps taken.</param>
+void versus_send_snapshot(const LevelLayout *state, uint8_t steps);
+
+/// <summary>
+/// Handles received frames and measures the latency. This must be called
+/// frequently, and at least once every frame time for the latency to stay
+/// under a frame.
+/// </summary>
+/// <param name="now">The current time in milliseconds.</param>
+/// <returns>The VERSUS_EVENT_ flags for what happened.</returns>
+uint8_t versus_update(uint32_t now);
+
+/// <summary>
+/// Gets what is known about the opponent.
+/// </summary>
+/// <returns>The opponent's state.</returns>
+const VersusOpponent *versus_opponent(void);
+
+/// <summary>
+/// Counts the opponent's boxes that are not on a target.
+/// </summary>
+/// <returns>The number of boxes left to place.</returns>
+uint8_t versus_boxes_left(void);
+
+/// <summary>
+/// Tests whether a frame has been received from the opponent recently.
+/// </summary>
+/// <param name="now">The current time in milliseconds.</param>
+/// <returns>Whether a frame arrived in the last VERSUS_TIMEOUT ms.</returns>
+bool versus_connected(uint32_t now);
+
+/// <summary>
+/// Gets the link statistics.
+/// </summary>
+/// <returns>The statistics.</returns>
+const VersusStats *versus_stats(void);
+
+#endif /* VERSUS_H_ */
\ No newline at end of file
@@ -0,0 +1,128 @@
+/*
+ * zobrist.c
+ *
+ * Author: Riley Stewart
+ */
+
+#include "zobrist.h"
+#include <stdint.h>
+#include <avr/pgmspace.h>
+#include "game.h"
+
+#define NUM_SQUARES	(MATRIX_NUM_ROWS * MATRIX_NUM_COLUMNS)
+
+// Keys are indexed by row * MATRIX_NUM_COLUMNS + column. They are the
+// xorshift32 sequence (shifts 13, 17, 5) from 0x2545F491, boxes first.
+static const uint32_t box_keys[NUM_SQUARES] PROGMEM =
+{
+	// Row 0
+	0xE124B63A, 0x8B9A74AB, 0x64E1B3AC, 0x00174626,
+	0xF2ADBBAF, 0xFED75123, 0x8A94501A, 0x12751A71,
+	0x96573F6C, 0x46EA7191, 0x13D2EA5D, 0x9DB4CF31,
+	0x8E0F4E18, 0x9E43C23E, 0x268A56BC, 0xE7E1F2D2,
+	// Row 1
+	0xEEC01FEF, 0x4A8CA751, 0x12BBE422, 0xA9CDF49D,
+	0xFC95B972, 0x3CC0494F, 0x88DFC4DB, 0x78D703D9,
+	0x8D219E6F, 0x63680239, 0x06CD666E, 0xEA1E9EAE,
+	0x00A30B2B, 0x590D22C8, 0x57DFD022, 0x16A31F2F,
+	// Row 2
+	0xDD9E740C, 0x70E04DE3, 0x52DE38ED, 0x2DB9938C,
+	0xE6CB9168, 0x083DB87B, 0x59627BA2, 0xD4D02589,
+	0xDC4CDA99, 0xA4E4FBD6, 0x485AE539, 0x8B4427A7,
+	0xF9A8CF9F, 0xEB30A9F2, 0x3FDC4855, 0x6C00D4FE,
+	// Row 3
+	0xA57AD991, 0x37585015, 0x960739B8, 0x57302520,
+	0x211591AA, 0xF7339F7A, 0x1F4F3F94, 0xEF05BA8A,
+	0x52CE02A0, 0xC1D3364D, 0x44427DC0, 0x74B57F9D,
+	0xB390F5FE, 0x08C30E49, 0x4849434C, 0x643E98DC,
+	// Row 4
+	0x538D2A8E, 0x2D4EADE0, 0xE6A8E2B9, 0xA5084706,
+	0x10F2EFB2, 0xED95AF30, 0x5603E229, 0x629C364A,
+	0x6EF58860, 0x20C5141C, 0xCA9C72DF, 0xDC31A73C,
+	0xF21C39B7, 0xD0768762, 0x13C222CF, 0xA4E6C942,
+	// Row 5
+	0xC4184305, 0x43682219, 0xA24F100C, 0x4998B54B,
+	0xB90EA0B3, 0xCE0631DF, 0x0F876DE1, 0xA55CA37C,
+	0x17544745, 0x6829BBFB, 0xB5887E50, 0xF2064D51,
+	0x4E226067, 0x47FEAF70, 0xD00C2978, 0xF1437EC9,
+	// Row 6
+	0x4DD82104, 0x76E83AF8, 0x47574643, 0x5C71400C,
+	0xFA6FBCB4, 0xB2DE7348, 0xEA5EEF73, 0xC1A201CB,
+	0xB2FF01C6, 0x0A3AFC05, 0xE2F4ADD8, 0x9EBD599F,
+	0x845AC858, 0x776578F0, 0xD7198D6D, 0x303F98D7,
+	// Row 7
+	0xA78631E5, 0x56EE8638, 0x431160AC, 0x8F9E32EE,
+	0x71B917EF, 0x3BDF17ED, 0xFD79B4FC, 0xB72C70EF,
+	0x1F000297, 0xF50F4AFE, 0x96401E16, 0x25D00E37,
+	0xA6C97BBC, 0xBE695303, 0x152659E7, 0x1D400BAA
+};
+
+static const uint32_t player_keys[NUM_SQUARES] PROGMEM =
+{
+	// Row 0
+	0x9A9DF3B0, 0xB997D965, 0x15D05F38, 0xD8DD5443,
+	0x38F4A049, 0x334710D7, 0xFAEE9759, 0x28B1C83B,
+	0x2762BCE0, 0x6F2E177F, 0x15F5927F, 0x50FE15E2,
+	0xDA0184A3, 0xB827ACC9, 0xFA6BE8D6, 0x695C06AE,
+	// Row 1
+	0xD8BFFF2A, 0xCC0F3C67, 0x5BFAFD66, 0x8E91D6ED,
+	0x3DC9B5AB, 0x64E6D2B5, 0x68B5904D, 0x8D37FF73,
+	0x29ED65FF, 0x2F0A2D96, 0x3DA3C18A, 0xF7C6CB23,
+	0xFAF53232, 0xCAD8D10B, 0xCFC2F797, 0xB73BBEEF,
+	// Row 2
+	0xDC21ED1C, 0xD1C1A67D, 0x44C0EBBA, 0x6F476B41,
+	0xC7CE4096, 0xF44C6878, 0x5129CFF9, 0x720DA9D2,
+	0x21C6C369, 0xCCD8683C, 0xFA2E92B3, 0x2764376F,
+	0x90B972CB, 0x62E9FADB, 0xEBE43442, 0xC0E41C74,
+	// Row 3
+	0x2E3D05E1, 0x5EAD3681, 0xF7D03D5F, 0xFF0F0922,
+	0xDB4380D7, 0xC07F9A1B, 0x54A09325, 0x9E4618A7,
+	0xF70817CE, 0x4BC40BF6, 0x9DEF7BCB, 0x20527280,
+	0xAE4AF5A1, 0xEF2B161E, 0x30FA8DAA, 0x48B05CAD,
+	// Row 4
+	0x279E7ADF, 0xF078391D, 0x1C27B4B0, 0xBC89FCE8,
+	0xE1831122, 0xF7450ED1, 0x857FB65E, 0x053DBF04,
+	0xE971AB2A, 0x5E842120, 0x8EA9C270, 0x6A14B963,
+	0x5A2C581F, 0xF4D5C188, 0xD07818BA, 0xBE8910AD,
+	// Row 5
+	0x0F032283, 0x013D926A, 0xDD61F192, 0x892BC75B,
+	0xC9DB28DB, 0x34C3C9DB, 0xF2E96BC7, 0x2DAD65EF,
+	0xA3086987, 0x69230DFB, 0x1B115F15, 0x2E8F0AEC,
+	0x358F4DA5, 0x5B4BF4B8, 0x9E402C96, 0xE1868E9F,
+	// Row 6
+	0x3AFBA015, 0x91DDCA49, 0x3A0B3E63, 0xE5296080,
+	0xEE19879C, 0x03A775C9, 0x4EDA4B86, 0xF2FB8233,
+	0xD509CECD, 0x76D30C05, 0xFD27522C, 0xFB39EA3D,
+	0x09BB0942, 0x7AFCDC6B, 0xCF4856B3, 0x7654DBFC,
+	// Row 7
+	0x484E8049, 0x90BA612A, 0x4F76A3C5, 0xFAC78602,
+	0x4AFFA321, 0x6DE051EC, 0x9C61A242, 0xAD1F7C96,
+	0x133E27D0, 0x2F4DCA72, 0x567BEF13, 0x58AAC13F,
+	0x11290E59, 0x2CA4F328, 0xEAF4E348, 0xA526D8C6
+};
+
+uint32_t zobrist_box(uint8_t row, uint8_t col)
+{
+	return pgm_read_dword(&box_keys[row * MATRIX_NUM_COLUMNS + col]);
+}
+
+uint32_t zobrist_player(uint8_t row, uint8_t col)
+{
+	return pgm_read_dword(&player_keys[row * MATRIX_NUM_COLUMNS + col]);
+}
+
+uint32_t zobrist_hash(const LevelLayout *state)
+{
+	uint32_t hash = zobrist_player(state->player_row, state->player_col);
+	for (uint8_t row = 0; row < MATRIX_NUM_ROWS; row++)
+	{
+		for (uint8_t col = 0; col < MATRIX_NUM_COLUMNS; col++)
+		{
+			if (state->board[row][col] & BOX)
+			{
+				hash ^= zobrist_box(row, col);
+			}
+		}
+	}
+	return hash;
+}
@@ -0,0 +1,47 @@
+/*
+ * zobrist.h
+ *
+ * Author: Riley Stewart
+ *
+ * Zobrist hashing of game positions. Every square has a random key for a
+ * box being on it and another for the player being on it, and a position's
+ * hash is the XOR of the keys of its boxes and its player. Walls and
+ * targets never move, so they are left out. A move changes the hash by two
+ * XORs (the player's old and new squares), and a push by two more (the
+ * box's), so the game keeps its hash up to date as it goes rather than
+ * hashing the whole board.
+ *
+ * The keys are kept in flash. This module does not use any AVR hardware,
+ * so it can also be built on the host (see tools/).
+ */
+
+#ifndef ZOBRIST_H_
+#define ZOBRIST_H_
+
+#include <stdint.h>
+#include "levels.h"
+
+/// <summary>
+/// Gets the key for a box on a square.
+/// </summary>
+/// <param name="row">The row of the square.</param>
+/// <param name="col">The column of the square.</param>
+/// <returns>The key to XOR into the hash.</returns>
+uint32_t zobrist_box(uint8_t row, uint8_t col);
+
+/// <summary>
+/// Gets the key for the player on a square.
+/// </summary>
+/// <param name="row">The row of the square.</param>
+/// <param name="col">The column of the square.</param>
+/// <returns>The key to XOR into the hash.</returns>
+uint32_t zobrist_player(uint8_t row, uint8_t col);
+
+/// <summary>
+/// Hashes a whole position, for a starting point to update from.
+/// </summary>
+/// <param name="state">The board and player position to hash.</param>
+/// <returns>The position's hash.</returns>
+uint32_t zobrist_hash(const LevelLayout *state);
+
+#endif /* ZOBRIST_H_ */
@@ -0,0 +1,303 @@
+/*
+ * editcheck.c
+ *
+ * Author: Riley Stewart
+ *
+ * Checks the level editor (AVRAssignment/editor.c) and the custom level
+ * store (levelstore.c) on the host, with the EEPROM held in memory and the
+ * LED matrix modelled by ledsim.h:
+ *
+ *   - each built in level is drawn square by square in the editor and
+ *     saved; it must pass the checks, load back the same, and be playable
+ *     as a custom level, except in a race
+ *   - after every edit the matrix must show the board, and the edit must
+ *     have sent no more than one pixel
+ *   - saving a level again unchanged must not write the EEPROM
+ *   - levels with each kind of problem must be rejected, with the right
+ *     reason, without writing the EEPROM
+ *
+ * Usage: editcheck
+ */
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include "editor.h"
+#include "levelstore.h"
+#include "campaign.h"
+#include "game.h"
+#include "levels.h"
+#include "hal.h"
+#include "ledsim.h"
+
+static LedSim matrix;
+static unsigned failures;
+
+static void to_matrix(uint8_t byte)
+{
+	ledsim_feed(&matrix, byte);
+}
+
+static const char *const status_names[] = { "editing", "checking", "saved",
+	"saved (unproven)", "no boxes", "box and target counts differ",
+	"already solved", "player blocked", "unreachable", "unsolvable" };
+
+// Reads a level in the notation of levels.c, top row first.
+static void parse_level(const char *text, LevelLayout *layout)
+{
+	for (uint8_t row = 0; row < MATRIX_NUM_ROWS; row++)
+	{
+		uint8_t board_row = MATRIX_NUM_ROWS - 1 - row;
+		for (uint8_t col = 0; col < MATRIX_NUM_COLUMNS; col++)
+		{
+			uint8_t object = ROOM;
+			switch (*text++)
+			{
+				case '#':
+					object = WALL;
+					break;
+				case '$':
+					object = BOX;
+					break;
+				case '*':
+					object = BOX | TARGET;
+					break;
+				case '+':
+					object = TARGET;
+					// Fallthrough.
+				case '@':
+					layout->player_row = board_row;
+					layout->player_col = col;
+					break;
+				case '.':
+					object = TARGET;
+					break;
+			}
+			layout->board[board_row][col] = object;
+		}
+	}
+}
+
+// Checks the matrix shows the board, apart from the player (who may be
+// flashed on or off).
+static bool matrix_shows_board(void)
+{
+	LevelLayout state;
+	get_game_state(&state);
+	for (uint8_t row = 0; row < MATRIX_NUM_ROWS; row++)
+	{
+		for (uint8_t col = 0; col < MATRIX_NUM_COLUMNS; col++)
+		{
+			bool player = (row == state.player_row && col == state.player_col);
+			if (matrix.image[row][col] != square_colour(row, col)
+				&& !(player && matrix.image[row][col] == theme_led(ITEM_PLAYER)))
+			{
+				return false;
+			}
+		}
+	}
+	return true;
+}
+
+// Draws a level in the editor square by square, moving the cursor over the
+// board as a player would, and checking each edit.
+static bool draw_level(const LevelLayout *layout, unsigned *edits,
+	uint32_t *bytes)
+{
+	uint8_t row;
+	uint8_t col;
+	editor_cursor(&row, &col);
+	for (uint8_t i = 0; i < MATRIX_NUM_ROWS * MATRIX_NUM_COLUMNS; i++)
+	{
+		uint8_t to_row = i / MATRIX_NUM_COLUMNS;
+		uint8_t to_col = i % MATRIX_NUM_COLUMNS;
+		editor_move_cursor(to_row - row, to_col - col);
+		row = to_row;
+		col = to_col;
+		uint8_t object = layout->board[row][col];
+		if (get_square(row, col) == object)
+		{
+			continue;
+		}
+		uint32_t before = matrix.pixel_writes;
+		editor_set(object);
+		(*edits)++;
+		*bytes += matrix.pixel_writes - before;
+		if (matrix.pixel_writes - before > 1 || !matrix_shows_board())
+		{
+			printf("  edit of (%u,%u) drew the wrong pixels\n", row, col);
+			return false;
+		}
+	}
+	editor_move_cursor(layout->player_row - row, layout->player_col - col);
+	return editor_place_player();
+}
+
+static EditorStatus save(void)
+{
+	EditorStatus status = editor_save();
+	while (status == EDITOR_CHECKING)
+	{
+		status = editor_update();
+	}
+	return status;
+}
+
+static void check_level(uint8_t level)
+{
+	LevelLayout layout;
+	LevelLayout loaded;
+	LevelLayout played;
+	decode_level(level, &layout);
+	uint8_t slot = level % LEVELSTORE_SLOTS;
+
+	editor_start(slot);
+	unsigned edits = 0;
+	uint32_t pixels = 0;
+	bool ok = draw_level(&layout, &edits, &pixels);
+	EditorStatus status = save();
+	ok = ok && (status == EDITOR_SAVED);
+	ok = ok && levelstore_load(slot, &loaded)
+		&& memcmp(&loaded, &layout, sizeof(layout)) == 0;
+
+	// Playable from the campaign, as a custom level, but not in a race as
+	// the other board could not decode it.
+	campaign_set_racing(true);
+	ok = ok && !campaign_select(NUM_LEVELS + 1 + slot);
+	campaign_set_racing(false);
+	ok = ok && campaign_select(NUM_LEVELS + 1 + slot);
+	campaign_load(&played);
+	ok = ok && memcmp(&played, &layout, sizeof(layout)) == 0;
+
+	// Saving again changes nothing in the EEPROM.
+	uint32_t written = eeprom_bytes_written;
+	ok = ok && save() == EDITOR_SAVED && eeprom_bytes_written == written;
+
+	printf("level %u: %u edits, %.1f pixels per edit, %s, into slot %u: %s\n",
+		level, edits, edits ? (double)pixels / edits : 0.0,
+		status_names[status], slot, ok ? "ok" : "FAILED");
+	failures += !ok;
+}
+
+typedef struct
+{
+	const char *name;
+	const char *text;
+	EditorStatus expected;
+} BadLevel;
+
+static const BadLevel bad_levels[] = {
+	{ "no boxes",
+		"################"
+		"#--------------#"
+		"#-@------------#"
+		"#--------------#"
+		"#--------------#"
+		"#--------------#"
+		"#--------------#"
+		"################", EDITOR_NO_BOXES },
+	{ "more boxes than targets",
+		"################"
+		"#--------------#"
+		"#-@---$--$--.--#"
+		"#--------------#"
+		"#--------------#"
+		"#--------------#"
+		"#--------------#"
+		"################", EDITOR_COUNT_MISMATCH },
+	{ "already solved",
+		"################"
+		"#--------------#"
+		"#-@---*--------#"
+		"#--------------#"
+		"#--------------#"
+		"#--------------#"
+		"#--------------#"
+		"################", EDITOR_ALREADY_SOLVED },
+	{ "player in a wall",
+		"################"
+		"#--------------#"
+		"#-----$---.----#"
+		"#--------------#"
+		"#--------------#"
+		"#--------------#"
+		"#--------------#"
+		"#######@########", EDITOR_PLAYER_BLOCKED },
+	{ "box walled off",
+		"################"
+		"#--------#-----#"
+		"#-@------#--$--#"
+		"#--------#-----#"
+		"#----.---#-----#"
+		"#--------#-----#"
+		"#--------#-----#"
+		"################", EDITOR_UNREACHABLE },
+	{ "box in a corner",
+		"################"
+		"#$-------------#"
+		"#-@------------#"
+		"#--------------#"
+		"#--------.-----#"
+		"#--------------#"
+		"#--------------#"
+		"################", EDITOR_UNSOLVABLE },
+	{ "boxes jammed together",
+		"################"
+		"#--------------#"
+		"#-@--------.---#"
+		"#--------------#"
+		"#------$$------#"
+		"#------##----.-#"
+		"#--------------#"
+		"################", EDITOR_UNSOLVABLE },
+};
+
+static void check_bad_level(const BadLevel *bad)
+{
+	LevelLayout layout;
+	parse_level(bad->text, &layout);
+	editor_start(LEVELSTORE_SLOTS - 1);
+	unsigned edits = 0;
+	uint32_t pixels = 0;
+	draw_level(&layout, &edits, &pixels);
+	if (bad->expected == EDITOR_PLAYER_BLOCKED)
+	{
+		// The editor will not put the player on a wall, so put the wall
+		// under the player instead.
+		editor_set(ROOM);
+		editor_place_player();
+		editor_set(WALL);
+	}
+	uint32_t written = eeprom_bytes_written;
+	EditorStatus status = save();
+	bool ok = (status == bad->expected) && eeprom_bytes_written == written;
+	printf("%-24s %-28s %s\n", bad->name, status_names[status],
+		ok ? "ok" : "FAILED");
+	failures += !ok;
+}
+
+int main(void)
+{
+	hal_spi_sink = to_matrix;
+	ledsim_reset(&matrix);
+	for (uint8_t slot = 0; slot < LEVELSTORE_SLOTS; slot++)
+	{
+		if (levelstore_exists(slot))
+		{
+			printf("slot %u is not empty at the start\n", slot);
+			failures++;
+		}
+	}
+	for (uint8_t level = 1; level <= NUM_LEVELS; level++)
+	{
+		check_level(level);
+	}
+	for (size_t i = 0; i < sizeof(bad_levels) / sizeof(bad_levels[0]); i++)
+	{
+		check_bad_level(&bad_levels[i]);
+	}
+	printf("%lu EEPROM bytes written, %u failures\n",
+		(unsigned long)eeprom_bytes_written, failures);
+	return failures ? 1 : 0;
+}
@@ -0,0 +1,68 @@
+/*
+ * hal.c
+ *
+ * Author: Riley Stewart
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "hal.h"
+#include "serialio.h"
+#include "spi.h"
+#include "timer0.h"
+#include <avr/eeprom.h>
+
+uint32_t hal_serial_bytes;
+uint32_t hal_spi_bytes;
+uint32_t hal_time;
+uint32_t eeprom_bytes_written;
+void (*hal_serial_sink)(uint8_t byte);
+void (*hal_spi_sink)(uint8_t byte);
+
+static void serial_byte(uint8_t byte)
+{
+	hal_serial_bytes++;
+	if (hal_serial_sink)
+	{
+		hal_serial_sink(byte);
+	}
+}
+
+void serial_put_char(char c)
+{
+	// As on the board, a linefeed is sent as CR LF.
+	if (c == '\n')
+	{
+		serial_byte('\r');
+	}
+	serial_byte((uint8_t)c);
+}
+
+bool serial_try_put(const uint8_t *data, uint8_t length)
+{
+	for (uint8_t i = 0; i < length; i++)
+	{
+		serial_byte(data[i]);
+	}
+	return true;
+}
+
+void spi_setup_master(uint8_t clockdivider)
+{
+	(void)clockdivider;
+}
+
+uint8_t spi_send_byte(uint8_t byte)
+{
+	hal_spi_bytes++;
+	if (hal_spi_sink)
+	{
+		hal_spi_sink(byte);
+	}
+	return 0;
+}
+
+uint32_t get_current_time(void)
+{
+	return hal_time;
+}
@@ -0,0 +1,35 @@
+/*
+ * hal.h
+ *
+ * Author: Riley Stewart
+ *
+ * Host stand-ins for the hardware modules the game core uses (serial port,
+ * SPI and the millisecond timer), so the game's own drawing code can be run
+ * and measured on a PC. Bytes sent to the serial port and over SPI are
+ * counted, and can be passed on to a model of the terminal or the matrix.
+ * The EEPROM is plain memory (see host/avr/eeprom.h), with the bytes
+ * written counted in eeprom_bytes_written.
+ */
+
+#ifndef HAL_H_
+#define HAL_H_
+
+#include <stdint.h>
+
+// Totals of the bytes sent since the program started.
+extern uint32_t hal_serial_bytes;
+extern uint32_t hal_spi_bytes;
+
+// Total of the EEPROM bytes changed since the program started.
+extern uint32_t eeprom_bytes_written;
+
+// The time returned by get_current_time(), in milliseconds.
+extern uint32_t hal_time;
+
+// If set, called with every byte sent to the serial port.
+extern void (*hal_serial_sink)(uint8_t byte);
+
+// If set, called with every byte sent over SPI.
+extern void (*hal_spi_sink)(uint8_t byte);
+
+#endif /* HAL_H_ */
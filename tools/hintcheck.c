@@ -0,0 +1,249 @@
+/*
+ * hintcheck.c
+ *
+ * Author: Riley Stewart
+ *
+ * Checks the quality of the on-device hint search (AVRAssignment/hint.c)
+ * against the full solver. For each level it follows the hints from the
+ * start position to the end, and after every hint checks with the solver
+ * whether the hinted push kept the fewest-pushes solution in reach.
+ *
+ * Usage: hintcheck [level ...]          from the level start positions
+ *        hintcheck -r count [level ...] from count positions per level made
+ *                                       by random pushes from the start
+ * All levels are checked if none are given.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include "game.h"
+#include "levels.h"
+#include "hint.h"
+#include "solver.h"
+
+static char direction_name(const Hint *hint)
+{
+	if (hint->delta_row > 0)
+	{
+		return 'U';
+	}
+	if (hint->delta_row < 0)
+	{
+		return 'D';
+	}
+	return hint->delta_col > 0 ? 'R' : 'L';
+}
+
+static void apply_hint(LevelLayout *state, const Hint *hint)
+{
+	uint8_t to_row = WRAP_ROW(hint->box_row + hint->delta_row);
+	uint8_t to_col = WRAP_COL(hint->box_col + hint->delta_col);
+	state->board[hint->box_row][hint->box_col] &= ~BOX;
+	state->board[to_row][to_col] |= BOX;
+	state->player_row = hint->box_row;
+	state->player_col = hint->box_col;
+}
+
+// Counters over every position checked.
+static uint32_t total_hints;
+static uint32_t total_good;
+static uint32_t total_fallback;
+static uint32_t max_nodes;
+static bool verbose = true;
+
+// Follows the hints from a position until it is solved. Returns whether
+// every hint kept an optimal solution.
+static bool follow_hints(LevelLayout *state)
+{
+	Solution solution;
+	if (!solve(state, SOLVE_PUSHES, &solution))
+	{
+		printf("  no solution\n");
+		return false;
+	}
+	uint16_t optimal_pushes = solution.pushes;
+	uint16_t remaining = solution.pushes;
+	uint16_t pushes = 0;
+	uint16_t good_hints = 0;
+	while (remaining > 0)
+	{
+		if (pushes >= 2 * optimal_pushes + 10)
+		{
+			printf("  gave up after %u pushes (optimal %u)\n", pushes,
+				optimal_pushes);
+			return false;
+		}
+		hint_start(state);
+		while (hint_step() == HINT_SEARCHING)
+		{
+		}
+		Hint hint;
+		if (!hint_get(&hint))
+		{
+			printf("  push %2u: no hint (status %d)\n", pushes + 1,
+				hint_status());
+			return false;
+		}
+		uint32_t nodes = hint_nodes_searched();
+		if (nodes > max_nodes)
+		{
+			max_nodes = nodes;
+		}
+		apply_hint(state, &hint);
+		pushes++;
+		bool solvable = solve(state, SOLVE_PUSHES, &solution);
+		bool good = solvable && solution.pushes == remaining - 1;
+		if (verbose || !good)
+		{
+			printf("  push %2u: box (%u,%2u) %c  %-8s %6lu nodes  %s\n",
+				pushes, hint.box_row, hint.box_col, direction_name(&hint),
+				hint.optimal ? "optimal" : "fallback", (unsigned long)nodes,
+				good ? "ok" : (solvable ? "detour" : "DEADLOCK"));
+		}
+		good_hints += good;
+		total_hints++;
+		total_good += good;
+		total_fallback += !hint.optimal;
+		if (!solvable)
+		{
+			return false;
+		}
+		remaining = solution.pushes;
+	}
+	if (verbose)
+	{
+		printf("  solved in %u pushes (optimal %u)\n", pushes,
+			optimal_pushes);
+	}
+	return good_hints == pushes;
+}
+
+// Makes a random push that the player can reach. Returns false if there is
+// no push to make.
+static bool random_push(LevelLayout *state)
+{
+	bool reached[MATRIX_NUM_ROWS][MATRIX_NUM_COLUMNS] = {{ false }};
+	uint8_t queue[MATRIX_NUM_ROWS * MATRIX_NUM_COLUMNS][2];
+	uint8_t head = 0;
+	uint8_t tail = 0;
+	static const int8_t delta[4][2] = { { 1, 0 }, { -1, 0 }, { 0, 1 }, { 0, -1 } };
+	Hint pushes[MATRIX_NUM_ROWS * MATRIX_NUM_COLUMNS * 4];
+	unsigned num_pushes = 0;
+
+	reached[state->player_row][state->player_col] = true;
+	queue[tail][0] = state->player_row;
+	queue[tail++][1] = state->player_col;
+	while (head != tail)
+	{
+		uint8_t row = queue[head][0];
+		uint8_t col = queue[head++][1];
+		for (uint8_t dir = 0; dir < 4; dir++)
+		{
+			uint8_t next_row = WRAP_ROW(row + delta[dir][0]);
+			uint8_t next_col = WRAP_COL(col + delta[dir][1]);
+			uint8_t object = state->board[next_row][next_col];
+			if (object & BOX)
+			{
+				uint8_t to_row = WRAP_ROW(next_row + delta[dir][0]);
+				uint8_t to_col = WRAP_COL(next_col + delta[dir][1]);
+				if (!(state->board[to_row][to_col] & (WALL | BOX)))
+				{
+					Hint *push = &pushes[num_pushes++];
+					push->box_row = next_row;
+					push->box_col = next_col;
+					push->delta_row = delta[dir][0];
+					push->delta_col = delta[dir][1];
+				}
+			}
+			else if (!(object & WALL) && !reached[next_row][next_col])
+			{
+				reached[next_row][next_col] = true;
+				queue[tail][0] = next_row;
+				queue[tail++][1] = next_col;
+			}
+		}
+	}
+	if (num_pushes == 0)
+	{
+		return false;
+	}
+	apply_hint(state, &pushes[rand() % num_pushes]);
+	return true;
+}
+
+// Checks hints from the start of a level. Returns whether every hint kept
+// an optimal solution.
+static bool check_level(uint8_t level)
+{
+	LevelLayout state;
+	decode_level(level, &state);
+	printf("level %u:\n", level);
+	return follow_hints(&state);
+}
+
+// Checks hints from positions reached by random pushes from the start of a
+// level, skipping positions that can no longer be solved.
+static bool check_scrambled(uint8_t level, unsigned count)
+{
+	bool all_good = true;
+	unsigned checked = 0;
+	printf("level %u, %u scrambled positions:\n", level, count);
+	while (checked < count)
+	{
+		LevelLayout state;
+		Solution solution;
+		decode_level(level, &state);
+		unsigned scramble = 4 + rand() % 12;
+		for (unsigned i = 0; i < scramble && random_push(&state); i++)
+		{
+		}
+		if (!solve(&state, SOLVE_PUSHES, &solution) || solution.pushes == 0)
+		{
+			continue;
+		}
+		all_good &= follow_hints(&state);
+		checked++;
+	}
+	return all_good;
+}
+
+int main(int argc, char *argv[])
+{
+	unsigned scrambled = 0;
+	int first_level = 1;
+	if (argc > 2 && argv[1][0] == '-' && argv[1][1] == 'r')
+	{
+		scrambled = (unsigned)atoi(argv[2]);
+		first_level = 3;
+		verbose = false;
+		srand(1);
+	}
+
+	bool all_good = true;
+	for (int level = 1; level <= NUM_LEVELS; level++)
+	{
+		bool selected = (first_level >= argc);
+		for (int i = first_level; i < argc; i++)
+		{
+			selected |= (atoi(argv[i]) == level);
+		}
+		if (!selected)
+		{
+			continue;
+		}
+		if (scrambled)
+		{
+			all_good &= check_scrambled((uint8_t)level, scrambled);
+		}
+		else
+		{
+			all_good &= check_level((uint8_t)level);
+		}
+	}
+	printf("%lu hints, %lu optimal, %lu fallback, most nodes %lu\n",
+		(unsigned long)total_hints, (unsigned long)total_good,
+		(unsigned long)total_fallback, (unsigned long)max_nodes);
+	return all_good ? 0 : 1;
+}
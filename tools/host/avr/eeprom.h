@@ -0,0 +1,51 @@
+/*
+ * avr/eeprom.h (host)
+ *
+ * Host stand-in for the avr-libc EEPROM functions used by the game. On the
+ * host EEMEM variables are ordinary variables, so the EEPROM is just RAM
+ * that starts out as zeros rather than erased (0xFF) bytes. Writes are
+ * counted in eeprom_bytes_written, to see how much wear a save causes.
+ * They are put in a section of their own, as on the AVR, so the RAM report
+ * (see the Makefile) does not count them.
+ */
+
+#ifndef HOST_AVR_EEPROM_H_
+#define HOST_AVR_EEPROM_H_
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+
+#define EEMEM	__attribute__((section(".eeprom")))
+
+extern uint32_t eeprom_bytes_written;
+
+static inline void eeprom_read_block(void *dst, const void *src, size_t n)
+{
+	memcpy(dst, src, n);
+}
+
+// Like the real one, only writes the bytes that are different.
+static inline void eeprom_update_block(const void *src, void *dst, size_t n)
+{
+	for (size_t i = 0; i < n; i++)
+	{
+		if (((uint8_t *)dst)[i] != ((const uint8_t *)src)[i])
+		{
+			((uint8_t *)dst)[i] = ((const uint8_t *)src)[i];
+			eeprom_bytes_written++;
+		}
+	}
+}
+
+static inline uint8_t eeprom_read_byte(const uint8_t *address)
+{
+	return *address;
+}
+
+static inline void eeprom_update_byte(uint8_t *address, uint8_t value)
+{
+	eeprom_update_block(&value, address, 1);
+}
+
+#endif /* HOST_AVR_EEPROM_H_ */
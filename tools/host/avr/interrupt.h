@@ -0,0 +1,20 @@
+/*
+ * avr/interrupt.h (host)
+ *
+ * Host stand-in for avr-libc's interrupt control. There are no interrupts
+ * on the host, so enabling and disabling them does nothing, and an
+ * interrupt handler is a plain function named after its vector, which a
+ * tool calls to simulate the interrupt.
+ */
+
+#ifndef HOST_AVR_INTERRUPT_H_
+#define HOST_AVR_INTERRUPT_H_
+
+#include <avr/io.h>
+
+#define sei()
+#define cli()
+
+#define ISR(vector)	void vector(void)
+
+#endif /* HOST_AVR_INTERRUPT_H_ */
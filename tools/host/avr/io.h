@@ -0,0 +1,117 @@
+/*
+ * avr/io.h (host)
+ *
+ * Host stand-in for the ATmega324A's registers, so the modules that drive
+ * the hardware can be compiled on a PC to measure their RAM (see the
+ * ram-report target in the Makefile). The registers are only declared, as
+ * nothing on the host runs this code, and only the bits the game uses are
+ * named.
+ */
+
+#ifndef HOST_AVR_IO_H_
+#define HOST_AVR_IO_H_
+
+#include <stdint.h>
+
+#define HOST_REG8(name)		extern volatile uint8_t name;
+#define HOST_REG16(name)	extern volatile uint16_t name;
+
+HOST_REG8(DDRA) HOST_REG8(DDRB) HOST_REG8(DDRC) HOST_REG8(DDRD)
+HOST_REG8(PORTA) HOST_REG8(PORTB) HOST_REG8(PORTC) HOST_REG8(PORTD)
+HOST_REG8(PINA) HOST_REG8(PINB) HOST_REG8(PINC) HOST_REG8(PIND)
+HOST_REG8(ADMUX) HOST_REG8(ADCSRA) HOST_REG16(ADC) HOST_REG8(ADCH)
+HOST_REG8(ADCL) HOST_REG8(DIDR0)
+HOST_REG8(TCNT0) HOST_REG8(OCR0A) HOST_REG8(OCR0B) HOST_REG8(TCCR0A)
+HOST_REG8(TCCR0B) HOST_REG8(TIMSK0) HOST_REG8(TIFR0)
+HOST_REG16(TCNT1) HOST_REG16(OCR1A) HOST_REG16(OCR1B) HOST_REG8(TCCR1A)
+HOST_REG8(TCCR1B) HOST_REG8(TIMSK1) HOST_REG8(TIFR1)
+HOST_REG8(TCNT2) HOST_REG8(OCR2A) HOST_REG8(OCR2B) HOST_REG8(TCCR2A)
+HOST_REG8(TCCR2B) HOST_REG8(TIMSK2) HOST_REG8(TIFR2)
+HOST_REG8(PCICR) HOST_REG8(PCIFR) HOST_REG8(PCMSK0) HOST_REG8(PCMSK1)
+HOST_REG8(PCMSK2) HOST_REG8(PCMSK3)
+HOST_REG16(UBRR0) HOST_REG8(UCSR0A) HOST_REG8(UCSR0B) HOST_REG8(UCSR0C)
+HOST_REG8(UDR0)
+HOST_REG16(UBRR1) HOST_REG8(UCSR1A) HOST_REG8(UCSR1B) HOST_REG8(UCSR1C)
+HOST_REG8(UDR1)
+HOST_REG8(SREG) HOST_REG8(SPCR0) HOST_REG8(SPSR0) HOST_REG8(SPDR0)
+HOST_REG8(SMCR) HOST_REG8(MCUSR) HOST_REG8(MCUCR) HOST_REG16(SP)
+HOST_REG8(PRR0)
+
+#define SREG_I	7
+#define ADSC	6
+#define ADEN	7
+#define ADPS0	0
+#define ADPS1	1
+#define ADPS2	2
+#define REFS0	6
+#define MUX0	0
+#define WGM00	0
+#define WGM01	1
+#define WGM02	3
+#define WGM10	0
+#define WGM11	1
+#define WGM12	3
+#define WGM13	4
+#define WGM20	0
+#define WGM21	1
+#define WGM22	3
+#define CS00	0
+#define CS01	1
+#define CS02	2
+#define CS10	0
+#define CS11	1
+#define CS12	2
+#define CS20	0
+#define CS21	1
+#define CS22	2
+#define COM2A0	6
+#define COM2A1	7
+#define COM2B0	4
+#define COM2B1	5
+#define OCIE0A	1
+#define OCF0A	1
+#define OCIE1A	1
+#define OCF1A	1
+#define OCIE2A	1
+#define TOIE2	0
+#define PCIE0	0
+#define PCIE1	1
+#define PCIF1	1
+#define PCINT8	0
+#define PCINT9	1
+#define PCINT10	2
+#define PCINT11	3
+#define RXEN0	4
+#define TXEN0	3
+#define RXCIE0	7
+#define UDRIE0	5
+#define TXCIE0	6
+#define UDRE0	5
+#define RXEN1	4
+#define TXEN1	3
+#define RXCIE1	7
+#define UDRIE1	5
+#define UDRE1	5
+#define UCSZ10	1
+#define UCSZ11	2
+#define U2X1	1
+#define SPE0	6
+#define MSTR0	4
+#define SPI2X0	0
+#define SPR00	0
+#define SPR10	1
+#define SPIF0	7
+#define DDB4	4
+#define DDB5	5
+#define DDB7	7
+#define PORTB4	4
+
+#define RAMSTART	(0x0100)
+#define RAMEND		(0x08FF)
+#define E2END		(0x03FF)
+
+#define _BV(bit)				(1 << (bit))
+#define bit_is_set(sfr, bit)	((sfr) & _BV(bit))
+#define bit_is_clear(sfr, bit)	(!((sfr) & _BV(bit)))
+
+#endif /* HOST_AVR_IO_H_ */
@@ -0,0 +1,25 @@
+/*
+ * avr/pgmspace.h (host)
+ *
+ * Host stand-in for avr-libc's program memory support, so modules that keep
+ * tables in flash can be built and run on a PC. There is only one address
+ * space on the host, so program memory reads are plain reads.
+ */
+
+#ifndef HOST_AVR_PGMSPACE_H_
+#define HOST_AVR_PGMSPACE_H_
+
+#include <stdint.h>
+#include <string.h>
+
+#define PROGMEM	__attribute__((section(".progmem.data")))
+#define PSTR(s)	(__extension__({ static const char host_pstr_[] PROGMEM = (s); \
+	&host_pstr_[0]; }))
+
+#define pgm_read_byte(address)	(*(const uint8_t *)(address))
+#define pgm_read_word(address)	(*(const uint16_t *)(address))
+#define pgm_read_dword(address)	(*(const uint32_t *)(address))
+#define memcpy_P(dest, src, n)	memcpy((dest), (src), (n))
+#define strlen_P(s)				strlen(s)
+
+#endif /* HOST_AVR_PGMSPACE_H_ */
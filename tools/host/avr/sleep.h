@@ -0,0 +1,19 @@
+/*
+ * avr/sleep.h (host)
+ *
+ * Host stand-in for avr-libc's sleep functions. There is nothing to put to
+ * sleep on the host, so they do nothing.
+ */
+
+#ifndef HOST_AVR_SLEEP_H_
+#define HOST_AVR_SLEEP_H_
+
+#define SLEEP_MODE_IDLE		(0)
+
+#define set_sleep_mode(mode)	((void)(mode))
+#define sleep_enable()			((void)0)
+#define sleep_disable()			((void)0)
+#define sleep_cpu()				((void)0)
+#define sleep_mode()			((void)0)
+
+#endif /* HOST_AVR_SLEEP_H_ */
@@ -0,0 +1,37 @@
+/*
+ * fdev.h (host)
+ *
+ * Host stand-in for avr-libc's stdio streams, forced into each module the
+ * RAM report compiles (see the Makefile). Only serialio.c sets up a stream,
+ * and the host's FILE is several times the size of avr-libc's, so FILE is
+ * replaced with a copy of avr-libc's struct. The code is only compiled, to
+ * measure it, so the stream is never used.
+ */
+
+#ifndef HOST_FDEV_H_
+#define HOST_FDEV_H_
+
+#include <stdio.h>
+#include <stdint.h>
+
+struct host_avr_file
+{
+	char *buf;
+	unsigned char unget;
+	uint8_t flags;
+	int size;
+	int len;
+	int (*put)(char, struct host_avr_file *);
+	int (*get)(struct host_avr_file *);
+	void *udata;
+};
+
+#define FILE	struct host_avr_file
+
+#define _FDEV_SETUP_READ	(0x01)
+#define _FDEV_SETUP_WRITE	(0x02)
+#define _FDEV_SETUP_RW		(_FDEV_SETUP_READ | _FDEV_SETUP_WRITE)
+
+#define FDEV_SETUP_STREAM(p, g, f)	{ .put = (p), .get = (g), .flags = (f) }
+
+#endif /* HOST_FDEV_H_ */
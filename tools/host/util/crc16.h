@@ -0,0 +1,35 @@
+/*
+ * util/crc16.h (host)
+ *
+ * Host stand-in for the avr-libc CRC functions used by the game.
+ */
+
+#ifndef HOST_UTIL_CRC16_H_
+#define HOST_UTIL_CRC16_H_
+
+#include <stdint.h>
+
+// CRC-16/XMODEM (polynomial 0x1021, initial value 0), one byte at a time.
+static inline uint16_t _crc_xmodem_update(uint16_t crc, uint8_t data)
+{
+	crc ^= (uint16_t)data << 8;
+	for (uint8_t i = 0; i < 8; i++)
+	{
+		crc = (crc & 0x8000) ? (uint16_t)((crc << 1) ^ 0x1021)
+			: (uint16_t)(crc << 1);
+	}
+	return crc;
+}
+
+// CRC-8/CCITT (polynomial 0x07), one byte at a time.
+static inline uint8_t _crc8_ccitt_update(uint8_t crc, uint8_t data)
+{
+	crc ^= data;
+	for (uint8_t i = 0; i < 8; i++)
+	{
+		crc = (crc & 0x80) ? (uint8_t)((crc << 1) ^ 0x07) : (uint8_t)(crc << 1);
+	}
+	return crc;
+}
+
+#endif /* HOST_UTIL_CRC16_H_ */
@@ -0,0 +1,283 @@
+/*
+ * inputcheck.c
+ *
+ * Author: Riley Stewart
+ *
+ * Checks the input mapping (AVRAssignment/input.c) on the host, with the
+ * EEPROM held in memory:
+ *
+ *   - with a blank EEPROM, the default key map gives the keys the game
+ *     used before their actions, in either case, and every other key none
+ *   - keys can be rebound, and the map and the joystick profile load back
+ *     from the EEPROM the same; saving them again unchanged writes nothing
+ *   - the uncalibrated joystick model gives the same directions as the
+ *     fixed thresholds it replaced, over a grid of readings
+ *   - a joystick held at a threshold, with noise on the reading, does not
+ *     chatter between directions, as it does with no hysteresis
+ *   - calibration scales each side of each axis to its own extent, and a
+ *     calibration that finds too little movement is not used
+ *
+ * Usage: inputcheck
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <ctype.h>
+#include "input.h"
+
+uint32_t eeprom_bytes_written;
+
+static unsigned failures;
+
+static void report(const char *name, bool ok)
+{
+	printf("%-48s %s\n", name, ok ? "ok" : "FAILED");
+	failures += !ok;
+}
+
+static void check_key_map(void)
+{
+	static const struct
+	{
+		char key;
+		Action action;
+	} defaults[] = {
+		{ 'w', ACTION_UP }, { 's', ACTION_DOWN }, { 'a', ACTION_LEFT },
+		{ 'd', ACTION_RIGHT }, { 'z', ACTION_UNDO }, { 'p', ACTION_PAUSE },
+		{ 'q', ACTION_SOUND }, { 'h', ACTION_HINT }, { 't', ACTION_THEME },
+		{ 'c', ACTION_PALETTE }, { 'x', ACTION_TELEMETRY },
+		{ 'm', ACTION_MEMORY }, { 'r', ACTION_RESTART }
+	};
+	const size_t num_defaults = sizeof(defaults) / sizeof(defaults[0]);
+
+	init_input();
+	bool ok = true;
+	for (int key = -1; key < 256; key++)
+	{
+		Action expected = ACTION_NONE;
+		for (size_t i = 0; i < num_defaults; i++)
+		{
+			if (key >= 0 && tolower(key) == defaults[i].key)
+			{
+				expected = defaults[i].action;
+			}
+		}
+		if (input_key_action(key) != expected)
+		{
+			printf("  key %d gives action %d, not %d\n", key,
+				input_key_action(key), expected);
+			ok = false;
+		}
+	}
+	report("default key map", ok);
+
+	ok = input_button_action(BUTTON0_PUSHED) == ACTION_RIGHT
+		&& input_button_action(BUTTON1_PUSHED) == ACTION_DOWN
+		&& input_button_action(BUTTON2_PUSHED) == ACTION_UP
+		&& input_button_action(BUTTON3_PUSHED) == ACTION_LEFT
+		&& input_button_action(NO_BUTTON_PUSHED) == ACTION_NONE;
+	report("button actions", ok);
+
+	// Bind i/j/k/l to the directions, and unbind w.
+	ok = input_bind('i', ACTION_UP) && input_bind('K', ACTION_DOWN)
+		&& input_bind('j', ACTION_LEFT) && input_bind('l', ACTION_RIGHT)
+		&& input_bind('w', ACTION_NONE)
+		&& !input_bind('1', ACTION_UP) && !input_bind('[', ACTION_UP)
+		&& !input_bind('@', ACTION_UP);
+	ok = ok && input_key_action('I') == ACTION_UP
+		&& input_key_action('k') == ACTION_DOWN
+		&& input_key_action('w') == ACTION_NONE
+		&& input_action_key(ACTION_UP) == 'i'
+		&& input_key_action('1') == ACTION_NONE;
+	report("rebinding", ok);
+
+	input_set_thresholds(40, 90, 10);
+	input_save();
+	uint32_t written = eeprom_bytes_written;
+	input_save();
+	ok = (eeprom_bytes_written == written);
+	input_restore_defaults();
+	init_input();
+	uint8_t deadzone;
+	uint8_t threshold;
+	uint8_t hysteresis;
+	input_get_thresholds(&deadzone, &threshold, &hysteresis);
+	ok = ok && input_key_action('i') == ACTION_UP
+		&& input_key_action('w') == ACTION_NONE
+		&& deadzone == 40 && threshold == 90 && hysteresis == 10;
+	report("saved and loaded, resaved with no writes", ok);
+	printf("  %lu EEPROM bytes written by the first save\n",
+		(unsigned long)written);
+
+	ok = !input_set_thresholds(40, 30, 10) && !input_set_thresholds(10, 90, 10)
+		&& !input_set_thresholds(40, 128, 10);
+	report("bad thresholds refused", ok);
+
+	input_restore_defaults();
+	input_save();
+}
+
+// The direction the fixed thresholds used before gave for a reading.
+static void old_direction(int x, int y, int rest_x, int rest_y,
+	int8_t *delta_row, int8_t *delta_col)
+{
+	const int diagonal = 200;
+	const int regular = 400;
+	*delta_row = 0;
+	*delta_col = 0;
+	if ((x < rest_x - diagonal || x > rest_x + diagonal)
+		&& (y < rest_y - diagonal || y > rest_y + diagonal))
+	{
+		*delta_row = (y > rest_y) ? 1 : -1;
+		*delta_col = (x > rest_x) ? 1 : -1;
+	}
+	else if (x > rest_x + regular)
+	{
+		*delta_col = 1;
+	}
+	else if (y < rest_y - regular)
+	{
+		*delta_row = -1;
+	}
+	else if (y > rest_y + regular)
+	{
+		*delta_row = 1;
+	}
+	else if (x < rest_x - regular)
+	{
+		*delta_col = -1;
+	}
+}
+
+static bool near(int value, int rest)
+{
+	int offset = abs(value - rest);
+	return abs(offset - 200) <= 4 || abs(offset - 400) <= 4;
+}
+
+static void check_fixed_thresholds(void)
+{
+	const int rest_x = 512;
+	const int rest_y = 512;
+	input_restore_defaults();
+	input_joystick_at_rest(rest_x, rest_y);
+	unsigned points = 0;
+	unsigned differ = 0;
+	bool ok = true;
+	for (int x = 0; x <= 1023; x += 3)
+	{
+		for (int y = 0; y <= 1023; y += 3)
+		{
+			int8_t row;
+			int8_t col;
+			int8_t old_row;
+			int8_t old_col;
+			// From rest each time, so no axis is engaged to start with.
+			input_joystick(rest_x, rest_y, &row, &col);
+			input_joystick(x, y, &row, &col);
+			old_direction(x, y, rest_x, rest_y, &old_row, &old_col);
+			points++;
+			if (row != old_row || col != old_col)
+			{
+				differ++;
+				if (!near(x, rest_x) && !near(y, rest_y))
+				{
+					printf("  (%d,%d) gives (%d,%d), not (%d,%d)\n", x, y,
+						row, col, old_row, old_col);
+					ok = false;
+				}
+			}
+		}
+	}
+	report("same directions as the fixed thresholds", ok);
+	printf("  %u of %u readings differ, all within 4 of a threshold\n",
+		differ, points);
+}
+
+// Holds the joystick near the threshold, with noise on the reading, and
+// counts the changes of direction.
+static unsigned chatter(uint8_t hysteresis)
+{
+	input_restore_defaults();
+	input_set_thresholds(INPUT_DEFAULT_DEADZONE, INPUT_DEFAULT_THRESHOLD,
+		hysteresis);
+	input_joystick_at_rest(512, 512);
+	srand(1);
+	unsigned changes = 0;
+	int8_t last_col = 0;
+	for (int i = 0; i < 10000; i++)
+	{
+		int8_t row;
+		int8_t col;
+		input_joystick(512 + 400 + rand() % 41 - 20, 512, &row, &col);
+		changes += (col != last_col);
+		last_col = col;
+	}
+	return changes;
+}
+
+static void check_hysteresis(void)
+{
+	unsigned with = chatter(INPUT_DEFAULT_HYSTERESIS);
+	unsigned without = chatter(0);
+	report("no chatter at a threshold", with <= 1 && without > 100);
+	printf("  %u changes of direction in 10000 noisy readings, %u with no "
+		"hysteresis\n", with, without);
+}
+
+static void check_calibration(void)
+{
+	input_restore_defaults();
+
+	// Too little movement is not used.
+	input_calibrate_start(512, 512);
+	input_calibrate_sample(512 + INPUT_MIN_SPAN, 512 + INPUT_MIN_SPAN);
+	input_calibrate_sample(512 - INPUT_MIN_SPAN + 1, 512 - INPUT_MIN_SPAN);
+	bool ok = !input_calibrate_finish() && !input_is_calibrated();
+	report("too little movement not used", ok);
+
+	// A joystick off centre, with a different travel each way.
+	const int centre_x = 400;
+	const int centre_y = 600;
+	const int low_x = 100;
+	const int high_x = 1000;
+	const int low_y = 300;
+	const int high_y = 800;
+	input_calibrate_start(centre_x, centre_y);
+	for (int i = 0; i < 100; i++)
+	{
+		input_calibrate_sample(low_x + (high_x - low_x) * i / 99,
+			low_y + (high_y - low_y) * (99 - i) / 99);
+	}
+	ok = input_calibrate_finish() && input_is_calibrated();
+	ok = ok && input_joystick_deflection(0, centre_x) == 0
+		&& input_joystick_deflection(0, high_x) == 127
+		&& input_joystick_deflection(0, low_x) == -127
+		&& input_joystick_deflection(1, high_y) == 127
+		&& input_joystick_deflection(1, low_y) == -127
+		&& input_joystick_deflection(0, 1023) == 127
+		&& input_joystick_deflection(0, 0) == -127;
+	int half_right = input_joystick_deflection(0, (centre_x + high_x) / 2);
+	int half_left = input_joystick_deflection(0, (centre_x + low_x) / 2);
+	ok = ok && abs(half_right - 63) <= 1 && abs(half_left + 63) <= 1;
+	report("calibrated extents", ok);
+
+	// Calibrated, the centre is not moved by a reading at rest.
+	input_joystick_at_rest(512, 512);
+	ok = input_joystick_deflection(0, centre_x) == 0;
+	report("calibrated centre kept", ok);
+
+	input_restore_defaults();
+}
+
+int main(void)
+{
+	check_key_map();
+	check_fixed_thresholds();
+	check_hysteresis();
+	check_calibration();
+	printf("%u failures\n", failures);
+	return failures ? 1 : 0;
+}
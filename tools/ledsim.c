@@ -0,0 +1,317 @@
+/*
+ * ledsim.c
+ *
+ * Author: Riley Stewart
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "ledsim.h"
+
+#define NUM_PIXELS	(MATRIX_NUM_ROWS * MATRIX_NUM_COLUMNS)
+
+// No command is being received.
+#define NO_COMMAND	(-1)
+
+// Size of one LED in a PNG, in image pixels.
+#define DOT_SIZE	(24)
+
+void ledsim_reset(LedSim *sim)
+{
+	memset(sim, 0, sizeof(*sim));
+	sim->command = NO_COMMAND;
+}
+
+bool ledsim_idle(const LedSim *sim)
+{
+	return sim->command == NO_COMMAND;
+}
+
+static void set_pixel(LedSim *sim, uint8_t row, uint8_t col,
+	PixelColour colour)
+{
+	sim->pixel_writes++;
+	if (sim->image[row][col] == colour)
+	{
+		sim->redundant_writes++;
+	}
+	sim->image[row][col] = colour;
+}
+
+// Shifts the image by one LED. The row or column shifted in is blank.
+static void shift(LedSim *sim, int8_t delta_row, int8_t delta_col)
+{
+	MatrixData shifted = {{ COLOUR_BLACK }};
+	for (uint8_t row = 0; row < MATRIX_NUM_ROWS; row++)
+	{
+		for (uint8_t col = 0; col < MATRIX_NUM_COLUMNS; col++)
+		{
+			uint8_t from_row = row - delta_row;
+			uint8_t from_col = col - delta_col;
+			if (from_row < MATRIX_NUM_ROWS && from_col < MATRIX_NUM_COLUMNS)
+			{
+				shifted[row][col] = sim->image[from_row][from_col];
+			}
+		}
+	}
+	memcpy(sim->image, shifted, sizeof(shifted));
+}
+
+// Gets the number of bytes that follow a command, or -1 if the command is
+// not known.
+static int command_length(uint8_t command)
+{
+	switch (command)
+	{
+		case LEDSIM_UPDATE_ALL:
+			return NUM_PIXELS;
+		case LEDSIM_UPDATE_PIXEL:
+			return 2;
+		case LEDSIM_UPDATE_ROW:
+			return 1 + MATRIX_NUM_COLUMNS;
+		case LEDSIM_UPDATE_COL:
+			return 1 + MATRIX_NUM_ROWS;
+		case LEDSIM_SHIFT_DISPLAY:
+			return 1;
+		case LEDSIM_CLEAR_SCREEN:
+			return 0;
+		default:
+			return -1;
+	}
+}
+
+static void run_command(LedSim *sim)
+{
+	const uint8_t *data = sim->data;
+	switch (sim->command)
+	{
+		case LEDSIM_UPDATE_ALL:
+			for (uint8_t i = 0; i < NUM_PIXELS; i++)
+			{
+				set_pixel(sim, i / MATRIX_NUM_COLUMNS, i % MATRIX_NUM_COLUMNS,
+					data[i]);
+			}
+			break;
+		case LEDSIM_UPDATE_PIXEL:
+			set_pixel(sim, (data[0] >> 4) & 0x07, data[0] & 0x0F, data[1]);
+			break;
+		case LEDSIM_UPDATE_ROW:
+			for (uint8_t col = 0; col < MATRIX_NUM_COLUMNS; col++)
+			{
+				set_pixel(sim, data[0] & 0x07, col, data[1 + col]);
+			}
+			break;
+		case LEDSIM_UPDATE_COL:
+			for (uint8_t row = 0; row < MATRIX_NUM_ROWS; row++)
+			{
+				set_pixel(sim, row, data[0] & 0x0F, data[1 + row]);
+			}
+			break;
+		case LEDSIM_SHIFT_DISPLAY:
+			// Bit 0 shifts right, bit 1 left, bit 2 down and bit 3 up.
+			shift(sim, (data[0] & 0x08) ? 1 : (data[0] & 0x04) ? -1 : 0,
+				(data[0] & 0x01) ? 1 : (data[0] & 0x02) ? -1 : 0);
+			break;
+		case LEDSIM_CLEAR_SCREEN:
+			memset(sim->image, COLOUR_BLACK, sizeof(sim->image));
+			break;
+	}
+	sim->command = NO_COMMAND;
+}
+
+void ledsim_feed(LedSim *sim, uint8_t byte)
+{
+	sim->bytes++;
+	if (sim->command == NO_COMMAND)
+	{
+		if (command_length(byte) < 0)
+		{
+			sim->bad_commands++;
+			return;
+		}
+		sim->commands++;
+		sim->command = byte;
+		sim->used = 0;
+	}
+	else
+	{
+		sim->data[sim->used++] = byte;
+	}
+	if (sim->used == command_length(sim->command))
+	{
+		run_command(sim);
+	}
+}
+
+// ---- Drawing ----
+
+static void split_colour(PixelColour colour, uint8_t *red, uint8_t *green)
+{
+	*red = colour & 0x0F;
+	*green = colour >> 4;
+}
+
+void ledsim_print(const LedSim *sim, FILE *file)
+{
+	for (int row = MATRIX_NUM_ROWS - 1; row >= 0; row--)
+	{
+		for (uint8_t col = 0; col < MATRIX_NUM_COLUMNS; col++)
+		{
+			uint8_t red;
+			uint8_t green;
+			split_colour(sim->image[row][col], &red, &green);
+			char c;
+			if (red == 0 && green == 0)
+			{
+				c = '.';
+			}
+			else if (red == 0)
+			{
+				c = 'G';
+			}
+			else if (green == 0)
+			{
+				c = 'R';
+			}
+			else
+			{
+				c = (red >= 2 * green) ? 'O' : 'Y';
+			}
+			if ((red > green ? red : green) < 8 && c != '.')
+			{
+				c += 'a' - 'A';
+			}
+			fputc(c, file);
+		}
+		fputc('\n', file);
+	}
+}
+
+static uint32_t crc32(uint32_t crc, const uint8_t *data, size_t length)
+{
+	crc = ~crc;
+	for (size_t i = 0; i < length; i++)
+	{
+		crc ^= data[i];
+		for (int bit = 0; bit < 8; bit++)
+		{
+			crc = (crc >> 1) ^ (0xEDB88320 & -(crc & 1));
+		}
+	}
+	return ~crc;
+}
+
+static void put_u32(uint8_t *out, uint32_t value)
+{
+	out[0] = value >> 24;
+	out[1] = value >> 16;
+	out[2] = value >> 8;
+	out[3] = value;
+}
+
+static bool write_chunk(FILE *file, const char *type, const uint8_t *data,
+	uint32_t length)
+{
+	uint8_t header[8];
+	uint8_t trailer[4];
+	put_u32(header, length);
+	memcpy(header + 4, type, 4);
+	uint32_t crc = crc32(crc32(0, header + 4, 4), data, length);
+	put_u32(trailer, crc);
+	return fwrite(header, 1, 8, file) == 8
+		&& fwrite(data, 1, length, file) == length
+		&& fwrite(trailer, 1, 4, file) == 4;
+}
+
+bool ledsim_write_png(const LedSim *sim, const char *name)
+{
+	const uint32_t width = MATRIX_NUM_COLUMNS * DOT_SIZE;
+	const uint32_t height = MATRIX_NUM_ROWS * DOT_SIZE;
+	const uint32_t line = 1 + 3 * width;
+	const uint32_t raw_size = line * height;
+
+	// The image, each line starting with filter type 0 (none).
+	uint8_t *raw = calloc(raw_size, 1);
+	// A zlib stream of uncompressed deflate blocks, of at most 65535 bytes.
+	uint32_t num_blocks = (raw_size + 65534) / 65535;
+	uint8_t *zlib = malloc(2 + raw_size + 5 * num_blocks + 4);
+	if (!raw || !zlib)
+	{
+		free(raw);
+		free(zlib);
+		return false;
+	}
+	for (uint32_t y = 0; y < height; y++)
+	{
+		uint8_t row = MATRIX_NUM_ROWS - 1 - y / DOT_SIZE;
+		for (uint32_t x = 0; x < width; x++)
+		{
+			uint8_t col = x / DOT_SIZE;
+			int dx = 2 * (int)(x % DOT_SIZE) - DOT_SIZE + 1;
+			int dy = 2 * (int)(y % DOT_SIZE) - DOT_SIZE + 1;
+			int radius = DOT_SIZE - 6;
+			if (dx * dx + dy * dy > radius * radius)
+			{
+				continue;
+			}
+			uint8_t red;
+			uint8_t green;
+			split_colour(sim->image[row][col], &red, &green);
+			uint8_t *pixel = raw + y * line + 1 + 3 * x;
+			// Off LEDs are drawn dark grey, so the grid can be seen.
+			pixel[0] = (red || green) ? red * 17 : 0x20;
+			pixel[1] = (red || green) ? green * 17 : 0x20;
+			pixel[2] = (red || green) ? 0 : 0x20;
+		}
+	}
+
+	uint32_t used = 0;
+	zlib[used++] = 0x78;
+	zlib[used++] = 0x01;
+	uint32_t a = 1;
+	uint32_t b = 0;
+	for (uint32_t done = 0; done < raw_size;)
+	{
+		uint32_t size = raw_size - done > 65535 ? 65535 : raw_size - done;
+		zlib[used++] = (done + size == raw_size);
+		zlib[used++] = size & 0xFF;
+		zlib[used++] = size >> 8;
+		zlib[used++] = ~size & 0xFF;
+		zlib[used++] = (~size >> 8) & 0xFF;
+		memcpy(zlib + used, raw + done, size);
+		for (uint32_t i = 0; i < size; i++)
+		{
+			a = (a + raw[done + i]) % 65521;
+			b = (b + a) % 65521;
+		}
+		used += size;
+		done += size;
+	}
+	put_u32(zlib + used, b << 16 | a);
+	used += 4;
+
+	// 8 bit RGB, no interlacing.
+	uint8_t ihdr[13] = { 0 };
+	put_u32(ihdr, width);
+	put_u32(ihdr + 4, height);
+	ihdr[8] = 8;
+	ihdr[9] = 2;
+
+	static const uint8_t signature[8] = { 0x89, 'P', 'N', 'G', '\r', '\n',
+		0x1A, '\n' };
+	FILE *file = fopen(name, "wb");
+	bool ok = file && fwrite(signature, 1, 8, file) == 8
+		&& write_chunk(file, "IHDR", ihdr, sizeof(ihdr))
+		&& write_chunk(file, "IDAT", zlib, used)
+		&& write_chunk(file, "IEND", NULL, 0);
+	if (file && fclose(file) != 0)
+	{
+		ok = false;
+	}
+	free(raw);
+	free(zlib);
+	return ok;
+}
@@ -0,0 +1,78 @@
+/*
+ * ledsim.h
+ *
+ * Author: Riley Stewart
+ *
+ * A model of the LED matrix's firmware, for checking what the game sends
+ * over SPI without a matrix. It takes the same commands as the matrix
+ * (see ledmatrix.c), keeps the image the matrix would show, and counts the
+ * bytes and commands it is sent. A pixel written with the colour it already
+ * has is counted as a redundant write, as it costs bandwidth and changes
+ * nothing.
+ */
+
+#ifndef LEDSIM_H_
+#define LEDSIM_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include "ledmatrix.h"
+
+// The matrix's commands.
+typedef enum
+{
+	LEDSIM_UPDATE_ALL = 0x00,
+	LEDSIM_UPDATE_PIXEL = 0x01,
+	LEDSIM_UPDATE_ROW = 0x02,
+	LEDSIM_UPDATE_COL = 0x03,
+	LEDSIM_SHIFT_DISPLAY = 0x04,
+	LEDSIM_CLEAR_SCREEN = 0x0F
+} LedSimCommand;
+
+typedef struct
+{
+	MatrixData image;
+
+	// Parser state: the command being received and its bytes so far.
+	int command;
+	uint8_t data[MATRIX_NUM_ROWS * MATRIX_NUM_COLUMNS + 1];
+	uint8_t used;
+
+	// Counts of what was received.
+	uint32_t bytes;
+	uint32_t commands;
+	uint32_t pixel_writes;
+	uint32_t redundant_writes;
+	uint32_t bad_commands;
+} LedSim;
+
+/// <summary>
+/// Resets a matrix to blank, waiting for a command.
+/// </summary>
+void ledsim_reset(LedSim *sim);
+
+/// <summary>
+/// Sends a byte to a matrix.
+/// </summary>
+void ledsim_feed(LedSim *sim, uint8_t byte);
+
+/// <summary>
+/// Gets whether a matrix is between commands.
+/// </summary>
+bool ledsim_idle(const LedSim *sim);
+
+/// <summary>
+/// Prints the image as text, top row first, with one character per LED:
+/// '.' for off, 'R' 'G' 'Y' 'O' for red, green, yellow and orange, and
+/// lower case for dim versions.
+/// </summary>
+void ledsim_print(const LedSim *sim, FILE *file);
+
+/// <summary>
+/// Writes the image as a PNG file, drawing each LED as a round dot.
+/// </summary>
+/// <returns>Whether the file was written.</returns>
+bool ledsim_write_png(const LedSim *sim, const char *name);
+
+#endif /* LEDSIM_H_ */
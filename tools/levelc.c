@@ -0,0 +1,298 @@
+/*
+ * levelc.c
+ *
+ * Author: Riley Stewart
+ *
+ * Level compiler. Reads the level pack (AVRAssignment/levels.txt), checks
+ * every level, solves it twice with the full solver (once for the fewest
+ * moves and once for the fewest pushes) and writes the level table with
+ * both pars as AVRAssignment/level_data.h, for levels.c to include.
+ *
+ * Usage: levelc [-c] levels.txt level_data.h
+ *            -c  check that level_data.h is up to date instead of
+ *                writing it
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include "game.h"
+#include "levels.h"
+#include "solver.h"
+
+#define MAX_PACK_LEVELS	(64)
+
+typedef struct
+{
+	char rows[MATRIX_NUM_ROWS][MATRIX_NUM_COLUMNS + 1];
+	int line;	// Line of the level's first row, for messages
+	uint16_t moves;
+	uint16_t pushes;
+} PackLevel;
+
+static PackLevel pack[MAX_PACK_LEVELS];
+static int num_levels;
+
+static bool fail(const char *name, int line, const char *message)
+{
+	fprintf(stderr, "%s:%d: %s\n", name, line, message);
+	return false;
+}
+
+// Reads the level pack, checking each row as it goes.
+static bool read_pack(const char *name)
+{
+	FILE *file = fopen(name, "r");
+	if (!file)
+	{
+		perror(name);
+		return false;
+	}
+	char text[256];
+	int line = 0;
+	int row = 0;
+	bool ok = true;
+	while (ok && fgets(text, sizeof(text), file))
+	{
+		line++;
+		text[strcspn(text, "\r\n")] = '\0';
+		if (text[0] == ';')
+		{
+			continue;
+		}
+		if (text[0] == '\0')
+		{
+			if (row != 0)
+			{
+				ok = fail(name, line, "level has too few rows");
+			}
+			continue;
+		}
+		if (row == 0)
+		{
+			if (num_levels == MAX_PACK_LEVELS)
+			{
+				ok = fail(name, line, "too many levels");
+				break;
+			}
+			pack[num_levels].line = line;
+		}
+		if (strlen(text) != MATRIX_NUM_COLUMNS)
+		{
+			ok = fail(name, line, "row is the wrong length");
+		}
+		else if (strspn(text, "-#$.*@+") != MATRIX_NUM_COLUMNS)
+		{
+			ok = fail(name, line, "row has a square that is not one of -#$.*@+");
+		}
+		else
+		{
+			strcpy(pack[num_levels].rows[row], text);
+			if (++row == MATRIX_NUM_ROWS)
+			{
+				row = 0;
+				num_levels++;
+			}
+		}
+	}
+	fclose(file);
+	if (ok && row != 0)
+	{
+		ok = fail(name, line, "level has too few rows");
+	}
+	if (ok && num_levels == 0)
+	{
+		ok = fail(name, line, "no levels");
+	}
+	return ok;
+}
+
+// Decodes a level as decode_level() does, and checks it has one player and
+// as many targets as boxes.
+static bool decode_pack_level(const PackLevel *level, LevelLayout *layout)
+{
+	int players = 0;
+	int boxes = 0;
+	int targets = 0;
+	for (uint8_t row = 0; row < MATRIX_NUM_ROWS; row++)
+	{
+		uint8_t board_row = MATRIX_NUM_ROWS - 1 - row;
+		for (uint8_t col = 0; col < MATRIX_NUM_COLUMNS; col++)
+		{
+			char square = level->rows[row][col];
+			uint8_t object = ROOM;
+			switch (square)
+			{
+				case '#':
+					object = WALL;
+					break;
+				case '$':
+					object = BOX;
+					break;
+				case '*':
+					object = BOX | TARGET;
+					break;
+				case '.':
+				case '+':
+					object = TARGET;
+					break;
+			}
+			if (square == '@' || square == '+')
+			{
+				layout->player_row = board_row;
+				layout->player_col = col;
+				players++;
+			}
+			boxes += (object & BOX) != 0;
+			targets += (object & TARGET) != 0;
+			layout->board[board_row][col] = object;
+		}
+	}
+	return players == 1 && boxes > 0 && boxes == targets;
+}
+
+static bool solve_pack(const char *name)
+{
+	printf("%-6s %6s %7s %10s %10s %8s\n", "level", "moves", "pushes",
+		"states", "states", "time");
+	printf("%-6s %6s %7s %10s %10s %8s\n", "", "par", "par", "(moves)",
+		"(pushes)", "(ms)");
+	clock_t pack_start = clock();
+	for (int i = 0; i < num_levels; i++)
+	{
+		PackLevel *level = &pack[i];
+		LevelLayout layout;
+		if (!decode_pack_level(level, &layout))
+		{
+			return fail(name, level->line, "level needs one player, and as "
+				"many targets as boxes");
+		}
+		clock_t start = clock();
+		Solution by_moves;
+		Solution by_pushes;
+		if (!solve(&layout, SOLVE_MOVES, &by_moves)
+			|| !solve(&layout, SOLVE_PUSHES, &by_pushes))
+		{
+			return fail(name, level->line, "level cannot be solved (or needs "
+				"too big a search)");
+		}
+		level->moves = by_moves.moves;
+		level->pushes = by_pushes.pushes;
+		printf("%-6d %6u %7u %10lu %10lu %8.0f\n", i + 1, level->moves,
+			level->pushes, (unsigned long)by_moves.states,
+			(unsigned long)by_pushes.states,
+			1000.0 * (clock() - start) / CLOCKS_PER_SEC);
+	}
+	printf("%d levels solved in %.2f s\n", num_levels,
+		(double)(clock() - pack_start) / CLOCKS_PER_SEC);
+	return true;
+}
+
+// Writes the level table as C, into a buffer.
+static size_t generate(char *out, size_t size)
+{
+	size_t used = 0;
+#define EMIT(...)	(used += snprintf(out + used, size - used, __VA_ARGS__))
+	EMIT("/*\n * level_data.h\n *\n"
+		" * Made by tools/levelc from levels.txt. Do not edit this file: change\n"
+		" * levels.txt and run 'make levels' in tools/.\n *\n"
+		" * The level layouts and the level table, included only by levels.c.\n"
+		" */\n\n");
+	EMIT("#ifndef LEVEL_DATA_H_\n#define LEVEL_DATA_H_\n");
+	for (int i = 0; i < num_levels; i++)
+	{
+		EMIT("\nstatic const char level_%d[] PROGMEM =", i + 1);
+		for (int row = 0; row < MATRIX_NUM_ROWS; row++)
+		{
+			EMIT("\n\t\"%s\"", pack[i].rows[row]);
+		}
+		EMIT(";\n");
+	}
+	EMIT("\n// The pars are the fewest moves and the fewest pushes the level can be\n"
+		"// solved in (each in its own solution).\n");
+	EMIT("static const LevelData level_table[%d] PROGMEM =\n{\n", num_levels);
+	for (int i = 0; i < num_levels; i++)
+	{
+		EMIT("\t{ level_%d, %u, %u }%s\n", i + 1, pack[i].moves, pack[i].pushes,
+			i + 1 < num_levels ? "," : "");
+	}
+	EMIT("};\n\n#endif /* LEVEL_DATA_H_ */\n");
+#undef EMIT
+	return used;
+}
+
+// Compares a file with the generated text, ignoring carriage returns (the
+// project's sources have CRLF line endings).
+static bool up_to_date(const char *name, const char *text)
+{
+	FILE *file = fopen(name, "rb");
+	if (!file)
+	{
+		return false;
+	}
+	int c;
+	bool same = true;
+	while (same && (c = fgetc(file)) != EOF)
+	{
+		if (c != '\r')
+		{
+			same = (*text++ == c);
+		}
+	}
+	fclose(file);
+	return same && *text == '\0';
+}
+
+int main(int argc, char *argv[])
+{
+	bool check = false;
+	int opt;
+	while ((opt = getopt(argc, argv, "c")) != -1)
+	{
+		if (opt == 'c')
+		{
+			check = true;
+		}
+		else
+		{
+			optind = argc;
+			break;
+		}
+	}
+	if (argc - optind != 2)
+	{
+		fprintf(stderr, "usage: %s [-c] levels.txt level_data.h\n", argv[0]);
+		return 2;
+	}
+	const char *input = argv[optind];
+	const char *output = argv[optind + 1];
+	if (!read_pack(input) || !solve_pack(input))
+	{
+		return 1;
+	}
+
+	static char text[64 * 1024];
+	size_t length = generate(text, sizeof(text));
+	if (check)
+	{
+		if (!up_to_date(output, text))
+		{
+			fprintf(stderr, "%s is out of date: run 'make levels'\n", output);
+			return 1;
+		}
+		printf("%s is up to date\n", output);
+		return 0;
+	}
+	FILE *file = fopen(output, "wb");
+	if (!file || fwrite(text, 1, length, file) != length || fclose(file) != 0)
+	{
+		perror(output);
+		return 1;
+	}
+	printf("wrote %s\n", output);
+	return 0;
+}
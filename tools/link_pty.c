@@ -0,0 +1,46 @@
+/*
+ * link_pty.c
+ *
+ * Author: Riley Stewart
+ *
+ * Host version of the board to board link (AVRAssignment/link.h), over a
+ * file descriptor such as a pseudo-terminal or a USB serial adapter. Bytes
+ * can be thrown away at random to test recovery from lost frames.
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include "link.h"
+#include "link_pty.h"
+
+int link_fd = -1;
+unsigned link_drop_percent;
+
+void init_link(long baudrate)
+{
+	(void)baudrate;
+}
+
+bool link_put_byte(uint8_t byte)
+{
+	if (link_drop_percent && (unsigned)(rand() % 100) < link_drop_percent)
+	{
+		// Lost on the wire, so as far as the sender knows it was sent.
+		return true;
+	}
+	return write(link_fd, &byte, 1) == 1;
+}
+
+uint8_t link_space(void)
+{
+	// The terminal's own buffer holds far more than a frame, and a write
+	// that fails anyway is reported by link_put_byte().
+	return LINK_BUFFER_SIZE - 1;
+}
+
+bool link_get_byte(uint8_t *byte)
+{
+	return read(link_fd, byte, 1) == 1;
+}
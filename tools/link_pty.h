@@ -0,0 +1,18 @@
+/*
+ * link_pty.h
+ *
+ * Author: Riley Stewart
+ *
+ * Settings for the host version of the link (see link_pty.c).
+ */
+
+#ifndef LINK_PTY_H_
+#define LINK_PTY_H_
+
+// The file descriptor the link reads and writes. It should be non-blocking.
+extern int link_fd;
+
+// Percentage of sent bytes to throw away.
+extern unsigned link_drop_percent;
+
+#endif /* LINK_PTY_H_ */
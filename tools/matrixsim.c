@@ -0,0 +1,346 @@
+/*
+ * matrixsim.c
+ *
+ * Author: Riley Stewart
+ *
+ * Plays the game's LED matrix drawing code (AVRAssignment/game.c, anim.c
+ * and ledmatrix.c) on the host, in the same timing as play_game() in
+ * project.c, with the SPI bytes sent to a model of the matrix (ledsim.h).
+ * A random move is made every 300ms (with an undo or a rewind to an
+ * earlier step now and then), with the player flashing every 200ms, the
+ * targets every 500ms and animations drawn every frame. At the end of each
+ * level the game is rewound to the level start.
+ *
+ * Before each move the matrix's image is checked against the board, and
+ * animations are checked never to draw over the player. At the end the
+ * bytes sent per animation frame and per operation are printed,
+ * with the number of pixels each operation wrote that already had the
+ * colour written (redundant writes).
+ *
+ * Usage: matrixsim [-a] [-p prefix] [-s seconds]
+ *            -a  print each level's final image
+ *            -p  write each level's final image to prefix<level>.png
+ *            -s  seconds played per level (default 120)
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <unistd.h>
+#include "game.h"
+#include "levels.h"
+#include "ledmatrix.h"
+#include "anim.h"
+#include "theme.h"
+#include "gamelog.h"
+#include "hal.h"
+#include "ledsim.h"
+
+// Time between passes of the simulated main loop, in milliseconds.
+#define TICK_TIME	(10)
+
+#define MOVE_TIME			(300)
+#define PLAYER_FLASH_TIME	(200)
+#define TARGET_FLASH_TIME	(500)
+
+static LedSim matrix;
+
+static void to_matrix(uint8_t byte)
+{
+	ledsim_feed(&matrix, byte);
+}
+
+// ---- Costs ----
+
+typedef enum
+{
+	COST_START,
+	COST_MOVE,
+	COST_UNDO,
+	COST_REWIND,
+	COST_RESTART,
+	COST_FLASH_PLAYER,
+	COST_FLASH_TARGETS,
+	COST_ANIMATION,
+	NUM_COSTS
+} CostType;
+
+static const char *const cost_names[NUM_COSTS] = {
+	"initialise_game",
+	"move or diagonal move",
+	"undo_move",
+	"rewind_game",
+	"rewind_game(0)",
+	"flash_player",
+	"flash_targets",
+	"anim_update"
+};
+
+typedef struct
+{
+	unsigned calls;
+	uint32_t bytes;
+	uint32_t pixel_writes;
+	uint32_t redundant_writes;
+} Cost;
+
+static Cost costs[NUM_COSTS];
+static LedSim start;
+
+static void start_cost(void)
+{
+	start = matrix;
+}
+
+static void end_cost(CostType type)
+{
+	costs[type].calls++;
+	costs[type].bytes += matrix.bytes - start.bytes;
+	costs[type].pixel_writes += matrix.pixel_writes - start.pixel_writes;
+	costs[type].redundant_writes += matrix.redundant_writes
+		- start.redundant_writes;
+}
+
+// ---- Checks ----
+
+static unsigned failures;
+
+// Checks the image against the board. A target can be shown flashed off,
+// and the player's square can show the player, what is under it or (as
+// flash_targets() paints over the player) a flashed target.
+static bool image_matches_board(uint8_t level, unsigned move)
+{
+	LevelLayout state;
+	get_game_state(&state);
+	for (uint8_t row = 0; row < MATRIX_NUM_ROWS; row++)
+	{
+		for (uint8_t col = 0; col < MATRIX_NUM_COLUMNS; col++)
+		{
+			PixelColour shown = matrix.image[row][col];
+			PixelColour square = square_colour(row, col);
+			bool target = (state.board[row][col] & OBJECT_MASK) == TARGET;
+			bool player = (row == state.player_row && col == state.player_col);
+			if (shown == square
+				|| (target && shown == theme_led(ITEM_ROOM))
+				|| (player && shown == theme_led(ITEM_PLAYER)))
+			{
+				continue;
+			}
+			printf("  level %u, before move %u: (%u,%u) shows %02X, "
+				"should be %02X\n", level, move, row, col, shown, square);
+			failures++;
+			return false;
+		}
+	}
+	return true;
+}
+
+// A random move or diagonal move, as the player could make.
+static void random_move(void)
+{
+	static const int8_t directions[4][2] = { { 1, 0 }, { -1, 0 }, { 0, 1 },
+		{ 0, -1 } };
+	int choice = rand() % 10;
+	if (choice < 7)
+	{
+		const int8_t *delta = directions[choice % 4];
+		move_player(delta[0], delta[1]);
+	}
+	else
+	{
+		int8_t delta_row = (rand() % 2) ? 1 : -1;
+		int8_t delta_col = (rand() % 2) ? 1 : -1;
+		move_diagonal(0, delta_col, delta_row, 0);
+	}
+}
+
+// Bytes sent per animation frame, over every level.
+static unsigned frames;
+static uint32_t frame_bytes_max;
+static uint32_t frame_bytes_total;
+
+static void play_level(uint8_t level, unsigned seconds)
+{
+	LevelLayout layout;
+	decode_level(level, &layout);
+	srand(level);
+	ledsim_reset(&matrix);
+	anim_cancel();
+	start_cost();
+	initialise_game(&layout);
+	end_cost(COST_START);
+
+	uint32_t last_move = hal_time;
+	uint32_t last_player_flash = hal_time;
+	uint32_t last_target_flash = hal_time;
+	uint32_t last_frame = hal_time;
+	uint32_t frame_start = matrix.bytes;
+	uint32_t end_time = hal_time + seconds * 1000;
+	unsigned moves = 0;
+	bool ok = true;
+
+	while (hal_time < end_time && !is_game_over())
+	{
+		if (hal_time >= last_move + MOVE_TIME)
+		{
+			// New input finishes any animation, so the image should now
+			// match the board.
+			anim_finish();
+			if (ok && !image_matches_board(level, moves + 1))
+			{
+				ok = false;
+			}
+			start_cost();
+			if (moves % 50 == 49)
+			{
+				uint16_t first = gamelog_first_step();
+				rewind_game(first + rand() % (gamelog_step() - first + 1));
+				end_cost(COST_REWIND);
+			}
+			else if (moves % 10 == 9)
+			{
+				undo_move();
+				end_cost(COST_UNDO);
+			}
+			else
+			{
+				random_move();
+				end_cost(COST_MOVE);
+			}
+			moves++;
+			last_move = hal_time;
+			last_player_flash = hal_time;
+		}
+		if (hal_time >= last_player_flash + PLAYER_FLASH_TIME)
+		{
+			start_cost();
+			flash_player();
+			end_cost(COST_FLASH_PLAYER);
+			last_player_flash = hal_time;
+		}
+		if (hal_time >= last_target_flash + TARGET_FLASH_TIME)
+		{
+			start_cost();
+			flash_targets();
+			end_cost(COST_FLASH_TARGETS);
+			last_target_flash = hal_time;
+		}
+		// Animations leave the player's square to flash_player().
+		const LevelLayout *state = get_game_layout();
+		PixelColour player = matrix.image[state->player_row][state->player_col];
+		start_cost();
+		anim_update();
+		if (matrix.bytes != start.bytes)
+		{
+			end_cost(COST_ANIMATION);
+		}
+		if (ok && matrix.image[state->player_row][state->player_col] != player)
+		{
+			printf("  level %u, after move %u: an animation drew over the "
+				"player\n", level, moves);
+			failures++;
+			ok = false;
+		}
+
+		hal_time += TICK_TIME;
+		if (hal_time >= last_frame + ANIM_FRAME_TIME)
+		{
+			uint32_t bytes = matrix.bytes - frame_start;
+			frames++;
+			frame_bytes_total += bytes;
+			if (bytes > frame_bytes_max)
+			{
+				frame_bytes_max = bytes;
+			}
+			frame_start = matrix.bytes;
+			last_frame = hal_time;
+		}
+	}
+	// Back to the start, without drawing the whole board again.
+	anim_finish();
+	start_cost();
+	rewind_game(0);
+	end_cost(COST_RESTART);
+	anim_finish();
+	if (ok && !image_matches_board(level, moves + 1))
+	{
+		ok = false;
+	}
+	if (matrix.bad_commands || !ledsim_idle(&matrix))
+	{
+		printf("  level %u: %u bad commands%s\n", level, matrix.bad_commands,
+			ledsim_idle(&matrix) ? "" : ", and a command left unfinished");
+		failures++;
+	}
+	printf("level %u: %u moves in %u s, %s\n", level, moves,
+		(unsigned)((hal_time - (end_time - seconds * 1000)) / 1000),
+		ok ? "image matches the board" : "IMAGE WRONG");
+}
+
+int main(int argc, char *argv[])
+{
+	bool print = false;
+	const char *prefix = NULL;
+	unsigned seconds = 120;
+	int opt;
+	while ((opt = getopt(argc, argv, "ap:s:")) != -1)
+	{
+		switch (opt)
+		{
+			case 'a':
+				print = true;
+				break;
+			case 'p':
+				prefix = optarg;
+				break;
+			case 's':
+				seconds = (unsigned)atoi(optarg);
+				break;
+			default:
+				fprintf(stderr, "usage: %s [-a] [-p prefix] [-s seconds]\n",
+					argv[0]);
+				return 2;
+		}
+	}
+	hal_spi_sink = to_matrix;
+
+	for (uint8_t level = 1; level <= NUM_LEVELS; level++)
+	{
+		play_level(level, seconds);
+		if (print)
+		{
+			ledsim_print(&matrix, stdout);
+		}
+		if (prefix)
+		{
+			char name[256];
+			snprintf(name, sizeof(name), "%s%u.png", prefix, level);
+			if (!ledsim_write_png(&matrix, name))
+			{
+				perror(name);
+				failures++;
+			}
+		}
+	}
+
+	printf("\n%u frames of %u ms: %.1f bytes per frame, at most %lu\n",
+		frames, ANIM_FRAME_TIME, frames ? (double)frame_bytes_total / frames : 0.0,
+		(unsigned long)frame_bytes_max);
+	printf("%-22s %7s %10s %12s %10s\n", "operation", "calls", "bytes/call",
+		"pixels/call", "redundant");
+	for (CostType type = 0; type < NUM_COSTS; type++)
+	{
+		const Cost *cost = &costs[type];
+		if (cost->calls)
+		{
+			printf("%-22s %7u %10.1f %12.1f %9.0f%%\n", cost_names[type],
+				cost->calls, (double)cost->bytes / cost->calls,
+				(double)cost->pixel_writes / cost->calls,
+				cost->pixel_writes
+				? 100.0 * cost->redundant_writes / cost->pixel_writes : 0.0);
+		}
+	}
+	return failures ? 1 : 0;
+}
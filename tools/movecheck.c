@@ -0,0 +1,466 @@
+/*
+ * movecheck.c
+ *
+ * Author: Riley Stewart
+ *
+ * Randomised property test of the game's moves, undo and rewind
+ * (move_player(), move_diagonal(), undo_move() and rewind_game() in
+ * AVRAssignment/game.c, with the game log in gamelog.c), run on the host.
+ * Random moves, diagonal moves, undos and rewinds are made on every level,
+ * and after each one:
+ *
+ *   - the walls, the targets and the number of boxes are unchanged, and the
+ *     player is not on a wall or a box
+ *   - a move's result (made or not, and the board and player after it) is
+ *     the same as an independent implementation of the rules gives
+ *   - an undo returns the game to the state before the move it undoes, for
+ *     as many moves as the game log keeps, and then does nothing, and gives
+ *     the steps the move counted for (two for a diagonal move)
+ *   - a rewind to any step the log keeps, back or forward, or to the level
+ *     start, gives the state the game was in at that step, and a rewind to
+ *     any other step does nothing
+ *   - the position hash the game keeps up to date (get_position_hash()) is
+ *     the hash of the whole position (zobrist_hash())
+ *   - the push count (get_push_count()) is the number of pushes made, less
+ *     those undone
+ *
+ * The game's output is drawn headless (to the terminal view's memory), so
+ * millions of moves can be checked a second.
+ *
+ * Usage: movecheck [-n moves] [-s seed]
+ *            prints the first move that breaks a property, with the seed
+ *            and move number to repeat it
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include "game.h"
+#include "levels.h"
+#include "ledmatrix.h"
+#include "zobrist.h"
+#include "gamelog.h"
+
+// Moves made before a level is started again.
+#define RUN_LENGTH	(2000)
+
+typedef enum
+{
+	OP_UP,
+	OP_DOWN,
+	OP_RIGHT,
+	OP_LEFT,
+	OP_UP_LEFT,
+	OP_DOWN_LEFT,
+	OP_DOWN_RIGHT,
+	OP_UP_RIGHT,
+	OP_UNDO,
+	OP_REWIND,
+	OP_RESTART,
+	NUM_OPS
+} Op;
+
+static const char *const op_names[NUM_OPS] = { "up", "down", "right", "left",
+	"up-left", "down-left", "down-right", "up-right", "undo", "rewind",
+	"restart" };
+
+static const int8_t op_deltas[OP_UNDO][2] = { { 1, 0 }, { -1, 0 }, { 0, 1 },
+	{ 0, -1 }, { 1, -1 }, { -1, -1 }, { -1, 1 }, { 1, 1 } };
+
+// A small fast generator, so the sequence does not depend on the game's own
+// use of rand().
+static uint64_t random_state;
+
+static uint32_t next_random(void)
+{
+	random_state ^= random_state << 13;
+	random_state ^= random_state >> 7;
+	random_state ^= random_state << 17;
+	return (uint32_t)(random_state >> 32);
+}
+
+// ---- The rules, written again from scratch ----
+
+static bool blocked(const LevelLayout *state, int row, int col)
+{
+	return state->board[WRAP_ROW(row)][WRAP_COL(col)] & (WALL | BOX);
+}
+
+// Makes a move. Boxes are pushed one square if the square beyond is free,
+// and never moved diagonally. A diagonal move goes round either corner
+// (the column first, then the row) if both squares on the way are free.
+static bool reference_move(LevelLayout *state, int8_t delta_row,
+	int8_t delta_col, unsigned *pushes)
+{
+	int row = state->player_row;
+	int col = state->player_col;
+	if (delta_row && delta_col)
+	{
+		bool by_column = !blocked(state, row, col + delta_col)
+			&& !blocked(state, row + delta_row, col + delta_col);
+		bool by_row = !blocked(state, row + delta_row, col)
+			&& !blocked(state, row + delta_row, col + delta_col);
+		if (!by_column && !by_row)
+		{
+			return false;
+		}
+	}
+	else
+	{
+		uint8_t next_row = WRAP_ROW(row + delta_row);
+		uint8_t next_col = WRAP_COL(col + delta_col);
+		uint8_t *next = &state->board[next_row][next_col];
+		if (*next & WALL)
+		{
+			return false;
+		}
+		if (*next & BOX)
+		{
+			if (blocked(state, next_row + delta_row, next_col + delta_col))
+			{
+				return false;
+			}
+			*next &= ~BOX;
+			(*pushes)++;
+			state->board[WRAP_ROW(next_row + delta_row)]
+				[WRAP_COL(next_col + delta_col)] |= BOX;
+		}
+	}
+	state->player_row = WRAP_ROW(row + delta_row);
+	state->player_col = WRAP_COL(col + delta_col);
+	return true;
+}
+
+static int count_boxes(const LevelLayout *state)
+{
+	int boxes = 0;
+	for (uint8_t row = 0; row < MATRIX_NUM_ROWS; row++)
+	{
+		for (uint8_t col = 0; col < MATRIX_NUM_COLUMNS; col++)
+		{
+			boxes += (state->board[row][col] & BOX) != 0;
+		}
+	}
+	return boxes;
+}
+
+static bool same_state(const LevelLayout *a, const LevelLayout *b)
+{
+	return a->player_row == b->player_row && a->player_col == b->player_col
+		&& memcmp(a->board, b->board, sizeof(a->board)) == 0;
+}
+
+// Describes what is wrong with a state, compared with the level's start, or
+// returns NULL.
+static const char *broken_invariant(const LevelLayout *state,
+	const LevelLayout *start)
+{
+	for (uint8_t row = 0; row < MATRIX_NUM_ROWS; row++)
+	{
+		for (uint8_t col = 0; col < MATRIX_NUM_COLUMNS; col++)
+		{
+			if ((state->board[row][col] & (WALL | TARGET))
+				!= (start->board[row][col] & (WALL | TARGET)))
+			{
+				return "a wall or target changed";
+			}
+			if ((state->board[row][col] & (WALL | BOX)) == (WALL | BOX))
+			{
+				return "a box is in a wall";
+			}
+		}
+	}
+	if (count_boxes(state) != count_boxes(start))
+	{
+		return "the number of boxes changed";
+	}
+	if (state->board[state->player_row][state->player_col] & (WALL | BOX))
+	{
+		return "the player is on a wall or box";
+	}
+	return NULL;
+}
+
+static void print_state(const LevelLayout *state)
+{
+	for (int row = MATRIX_NUM_ROWS - 1; row >= 0; row--)
+	{
+		printf("    ");
+		for (uint8_t col = 0; col < MATRIX_NUM_COLUMNS; col++)
+		{
+			static const char symbols[] = " #$?.!*?";
+			putchar((row == state->player_row && col == state->player_col)
+				? '@' : symbols[state->board[row][col] & OBJECT_MASK]);
+		}
+		putchar('\n');
+	}
+}
+
+// ---- The test ----
+
+typedef struct
+{
+	uint8_t level;
+	unsigned move;
+	Op op;
+	const char *problem;
+	LevelLayout expected;
+	LevelLayout actual;
+} Failure;
+
+// Makes an operation, and returns 0 if it was not made, the steps taken
+// back if it was an undo, and otherwise 1.
+static uint8_t make_op(Op op, uint16_t rewind_step)
+{
+	if (op == OP_UNDO)
+	{
+		return undo_move();
+	}
+	if (op == OP_REWIND)
+	{
+		return rewind_game(rewind_step);
+	}
+	if (op == OP_RESTART)
+	{
+		return rewind_game(0);
+	}
+	const int8_t *delta = op_deltas[op];
+	if (delta[0] && delta[1])
+	{
+		// As project.c calls it: the column first, then the row.
+		return move_diagonal(0, delta[1], delta[0], 0);
+	}
+	return move_player(delta[0], delta[1]);
+}
+
+// The steps the game log keeps, worked out from its rules: blocks of
+// GAMELOG_INTERVAL moves, started by their first move, of which the oldest
+// is dropped to make room for a new one.
+typedef struct
+{
+	unsigned step;
+	unsigned first;
+	unsigned last;
+} LogModel;
+
+static void log_move(LogModel *log)
+{
+	if (log->step < log->first)
+	{
+		log->first = 0;
+	}
+	if (log->step % GAMELOG_INTERVAL == 0
+		&& log->step - log->first == GAMELOG_BLOCKS * GAMELOG_INTERVAL)
+	{
+		log->first += GAMELOG_INTERVAL;
+	}
+	log->step++;
+	log->last = log->step;
+}
+
+static bool log_keeps(const LogModel *log, unsigned step)
+{
+	return step == 0 || (step >= log->first && step <= log->last);
+}
+
+// Plays a run of random operations on a level, and returns false (filling
+// in the failure) at the first property broken.
+static bool play_run(uint8_t level, unsigned *move, Failure *failure)
+{
+	// The state, pushes and steps counted at each step since the level
+	// start.
+	static LevelLayout history[RUN_LENGTH + 1];
+	static unsigned history_pushes[RUN_LENGTH + 1];
+	static unsigned history_steps[RUN_LENGTH + 1];
+	LogModel log = { 0, 0, 0 };
+	LevelLayout start;
+	decode_level(level, &start);
+	initialise_game(&start);
+	history[0] = start;
+	history_pushes[0] = 0;
+	history_steps[0] = 0;
+
+	LevelLayout state = start;
+	failure->level = level;
+	for (unsigned i = 0; i < RUN_LENGTH; i++, (*move)++)
+	{
+		// Undos come in bursts, so the whole log gets used up.
+		static unsigned undos_left;
+		if (undos_left == 0 && next_random() % 16 == 0)
+		{
+			undos_left = 1 + next_random() % (GAMELOG_BLOCKS * GAMELOG_INTERVAL + 8);
+		}
+		Op op;
+		unsigned rewind_step = 0;
+		if (undos_left)
+		{
+			undos_left--;
+			op = OP_UNDO;
+		}
+		else if (next_random() % 256 == 0)
+		{
+			op = OP_RESTART;
+		}
+		else if (next_random() % 32 == 0)
+		{
+			// Mostly steps the log keeps, and some either side of them.
+			op = OP_REWIND;
+			rewind_step = log.first + next_random() % (log.last - log.first + 3);
+			rewind_step = (rewind_step >= 2) ? rewind_step - 2 : 0;
+		}
+		else
+		{
+			op = (Op)(next_random() % OP_UNDO);
+		}
+		failure->move = *move;
+		failure->op = op;
+
+		LevelLayout expected = state;
+		unsigned expected_step = log.step;
+		unsigned expected_cost = 1;
+		bool expect_made;
+		if (op == OP_UNDO || op == OP_REWIND || op == OP_RESTART)
+		{
+			if (op == OP_UNDO)
+			{
+				rewind_step = log.step - 1;
+				expect_made = log.step > 0 && log_keeps(&log, rewind_step);
+				if (expect_made)
+				{
+					expected_cost = history_steps[log.step]
+						- history_steps[rewind_step];
+				}
+			}
+			else
+			{
+				expect_made = log_keeps(&log, rewind_step);
+			}
+			if (expect_made)
+			{
+				expected_step = rewind_step;
+				expected = history[expected_step];
+			}
+		}
+		else
+		{
+			unsigned pushes = history_pushes[log.step];
+			unsigned steps = history_steps[log.step]
+				+ ((op_deltas[op][0] && op_deltas[op][1]) ? 2 : 1);
+			expect_made = reference_move(&expected, op_deltas[op][0],
+				op_deltas[op][1], &pushes);
+			if (expect_made)
+			{
+				log_move(&log);
+				expected_step = log.step;
+				history[expected_step] = expected;
+				history_pushes[expected_step] = pushes;
+				history_steps[expected_step] = steps;
+			}
+		}
+		log.step = expected_step;
+
+		uint8_t cost = make_op(op, rewind_step);
+		bool made = cost != 0;
+		get_game_state(&state);
+		failure->expected = expected;
+		failure->actual = state;
+		if (made != expect_made)
+		{
+			failure->problem = made ? "made, but should not have been"
+				: "not made, but should have been";
+			return false;
+		}
+		if (made && cost != expected_cost)
+		{
+			failure->problem = "undo gave the wrong number of steps";
+			return false;
+		}
+		if (!same_state(&state, &expected))
+		{
+			failure->problem = (op == OP_UNDO)
+				? "undo did not restore the state before the move"
+				: (op >= OP_REWIND)
+				? "rewind did not restore the state at the step"
+				: "the board is not what the rules give";
+			return false;
+		}
+		const char *problem = broken_invariant(&state, &start);
+		if (problem)
+		{
+			failure->problem = problem;
+			return false;
+		}
+		if (get_position_hash() != zobrist_hash(&state))
+		{
+			failure->problem = "the position hash is not the position's";
+			return false;
+		}
+		if (get_push_count() != history_pushes[log.step])
+		{
+			failure->problem = "the push count is wrong";
+			return false;
+		}
+		if (gamelog_step() != log.step || gamelog_first_step() != log.first
+			|| gamelog_last_step() != log.last)
+		{
+			failure->problem = "the game log keeps the wrong steps";
+			return false;
+		}
+	}
+	return true;
+}
+
+int main(int argc, char *argv[])
+{
+	unsigned long moves = 20000000;
+	uint64_t seed = (uint64_t)time(NULL);
+	int opt;
+	while ((opt = getopt(argc, argv, "n:s:")) != -1)
+	{
+		switch (opt)
+		{
+			case 'n':
+				moves = strtoul(optarg, NULL, 10);
+				break;
+			case 's':
+				seed = strtoull(optarg, NULL, 10);
+				break;
+			default:
+				fprintf(stderr, "usage: %s [-n moves] [-s seed]\n", argv[0]);
+				return 2;
+		}
+	}
+	random_state = seed ? seed : 1;
+	ledmatrix_set_headless(true);
+
+	printf("%lu moves, seed %llu\n", moves, (unsigned long long)seed);
+	fflush(stdout);
+	clock_t started = clock();
+	unsigned long done = 0;
+	Failure failure;
+	while (done < moves)
+	{
+		uint8_t level = 1 + next_random() % NUM_LEVELS;
+		unsigned move = 0;
+		if (!play_run(level, &move, &failure))
+		{
+			printf("FAILED after %lu moves: level %u, move %u of its run (%s): "
+				"%s\n", done + move, failure.level, failure.move + 1,
+				op_names[failure.op], failure.problem);
+			printf("  expected:\n");
+			print_state(&failure.expected);
+			printf("  game:\n");
+			print_state(&failure.actual);
+			return 1;
+		}
+		done += move;
+	}
+	double seconds = (double)(clock() - started) / CLOCKS_PER_SEC;
+	printf("all properties held: %.1f million moves a second\n",
+		seconds > 0 ? done / seconds / 1e6 : 0.0);
+	return 0;
+}
@@ -0,0 +1,313 @@
+/*
+ * musiccheck.c
+ *
+ * Author: Riley Stewart
+ *
+ * Checks the music sequencer (AVRAssignment/music.c) on the host, by
+ * calling its timer 1 interrupt handler once per tick and recording the
+ * notes it plays on a stand-in for the buzzer:
+ *
+ *   - test scores play their notes, rests, tempo changes, arpeggios and
+ *     loops at the right ticks
+ *   - a run of more than MUSIC_MAX_EVENTS entries without a note is read
+ *     over more than one tick, and a score that loops without a note does
+ *     not hang the handler
+ *   - sound effects play over the music, which is still in time when they
+ *     end, and an effect only cuts off one of the same or lower priority
+ *   - with sound off nothing is played, and the music keeps time
+ *   - the buzzer is only written when the note changes
+ *
+ * It then prints the length of each sound effect and of the game music.
+ *
+ * Usage: musiccheck
+ */
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include "music.h"
+#include "buzzer.h"
+#include "timer1.h"
+
+// The timer 1 interrupt handler, a plain function on the host.
+void TIMER1_COMPA_vect(void);
+
+// The status register, whose interrupt flag music.c saves around the times
+// it turns interrupts off. There are no interrupts on the host.
+volatile uint8_t SREG;
+
+#define MAX_TICKS	(2000)
+
+static uint8_t sounding = MUSIC_REST;
+static uint32_t buzzer_writes;
+static uint32_t redundant_writes;
+static unsigned failures;
+
+void buzzer_play_note(uint8_t note)
+{
+	buzzer_writes++;
+	redundant_writes += (note == sounding);
+	sounding = note;
+}
+
+void buzzer_off(void)
+{
+	buzzer_writes++;
+	redundant_writes += (sounding == MUSIC_REST);
+	sounding = MUSIC_REST;
+}
+
+// Runs the sequencer for a number of ticks, recording the note sounding
+// after each.
+static void run(uint8_t *notes, int ticks)
+{
+	for (int i = 0; i < ticks; i++)
+	{
+		TIMER1_COMPA_vect();
+		notes[i] = sounding;
+	}
+}
+
+// Stops the music and lets any effect finish.
+static void settle(void)
+{
+	static uint8_t notes[MAX_TICKS];
+	music_stop();
+	music_set_enabled(true);
+	run(notes, MAX_TICKS);
+}
+
+static void report(const char *name, bool ok)
+{
+	printf("%-36s %s\n", name, ok ? "ok" : "FAILED");
+	failures += !ok;
+}
+
+// Prints the first tick at which the notes played differ from those
+// expected, and whether they matched.
+static bool compare(const uint8_t *notes, const uint8_t *expected, int ticks)
+{
+	for (int i = 0; i < ticks; i++)
+	{
+		if (notes[i] != expected[i])
+		{
+			printf("  tick %d: played %u, expected %u\n", i, notes[i],
+				expected[i]);
+			return false;
+		}
+	}
+	return true;
+}
+
+// Fills part of an expected sequence with one note.
+static int fill(uint8_t *expected, int at, uint8_t note, int ticks)
+{
+	memset(expected + at, note, ticks);
+	return at + ticks;
+}
+
+static void check_score(const char *name, const uint8_t *score,
+	const uint8_t *expected, int ticks)
+{
+	uint8_t notes[MAX_TICKS];
+	settle();
+	music_play(score);
+	run(notes, ticks);
+	report(name, compare(notes, expected, ticks));
+}
+
+static void check_scores(void)
+{
+	uint8_t expected[MAX_TICKS];
+	int at;
+
+	static const uint8_t notes_and_rests[] = { MUSIC_TEMPO, 3, NOTE_C5, 2,
+		MUSIC_REST, 1, MUSIC_TEMPO, 1, NOTE_E5, 4, MUSIC_END };
+	at = fill(expected, 0, NOTE_C5, 6);
+	at = fill(expected, at, MUSIC_REST, 3);
+	at = fill(expected, at, NOTE_E5, 4);
+	at = fill(expected, at, MUSIC_REST, 3);
+	check_score("notes, rests and tempo changes", notes_and_rests, expected, at);
+
+	static const uint8_t default_tempo[] = { NOTE_C5, 1, MUSIC_END };
+	at = fill(expected, 0, NOTE_C5, MUSIC_DEFAULT_TEMPO);
+	at = fill(expected, at, MUSIC_REST, 3);
+	check_score("default tempo", default_tempo, expected, at);
+
+	static const uint8_t arpeggio[] = { MUSIC_TEMPO, 12, MUSIC_ARPEGGIO, 0x47,
+		NOTE_C5, 1, MUSIC_ARPEGGIO, 0x00, NOTE_C5, 2, MUSIC_END };
+	at = 0;
+	for (int i = 0; i < 2; i++)
+	{
+		at = fill(expected, at, NOTE_C5, MUSIC_ARPEGGIO_TICKS);
+		at = fill(expected, at, NOTE_E5, MUSIC_ARPEGGIO_TICKS);
+		at = fill(expected, at, NOTE_G5, MUSIC_ARPEGGIO_TICKS);
+	}
+	at = fill(expected, at, NOTE_C5, 24);
+	at = fill(expected, at, MUSIC_REST, 3);
+	check_score("arpeggio", arpeggio, expected, at);
+
+	static const uint8_t clipped[] = { MUSIC_TEMPO, 3 * MUSIC_ARPEGGIO_TICKS,
+		MUSIC_ARPEGGIO, 0x0C, NOTE_AS8, 1, MUSIC_END };
+	at = fill(expected, 0, NOTE_AS8, 2 * MUSIC_ARPEGGIO_TICKS);
+	at = fill(expected, at, NOTE_B8, MUSIC_ARPEGGIO_TICKS);
+	at = fill(expected, at, MUSIC_REST, 3);
+	check_score("arpeggio above the top note", clipped, expected, at);
+
+	static const uint8_t loop[] = { MUSIC_TEMPO, 1, NOTE_C5, 1, NOTE_D5, 1,
+		MUSIC_LOOP };
+	for (at = 0; at < 20; at++)
+	{
+		expected[at] = (at % 2) ? NOTE_D5 : NOTE_C5;
+	}
+	check_score("loop", loop, expected, at);
+
+	static const uint8_t long_run[] = { MUSIC_TEMPO, 1, MUSIC_TEMPO, 1,
+		MUSIC_TEMPO, 1, MUSIC_TEMPO, 1, MUSIC_TEMPO, 1, NOTE_C5, 1, MUSIC_END };
+	at = fill(expected, 0, MUSIC_REST, 5 / MUSIC_MAX_EVENTS);
+	at = fill(expected, at, NOTE_C5, 1);
+	at = fill(expected, at, MUSIC_REST, 3);
+	check_score("long run of entries without a note", long_run, expected, at);
+
+	static const uint8_t empty_loop[] = { MUSIC_LOOP };
+	at = fill(expected, 0, MUSIC_REST, 100);
+	check_score("loop without a note", empty_loop, expected, at);
+}
+
+// Records a sound effect played on its own.
+static int record_effect(SoundEffect sound, uint8_t *notes)
+{
+	settle();
+	music_effect(sound);
+	run(notes, MAX_TICKS);
+	int length = MAX_TICKS;
+	while (length > 0 && notes[length - 1] == MUSIC_REST)
+	{
+		length--;
+	}
+	return length;
+}
+
+static void check_effects(void)
+{
+	static uint8_t music[MAX_TICKS];
+	static uint8_t effects[3][MAX_TICKS];
+	static uint8_t notes[MAX_TICKS];
+	static uint8_t expected[MAX_TICKS];
+	int length[3];
+	const int start = 50;
+
+	settle();
+	music_play(game_music);
+	run(music, MAX_TICKS);
+	for (int sound = SOUND_MOVE; sound <= SOUND_VICTORY; sound++)
+	{
+		length[sound] = record_effect(sound, effects[sound]);
+	}
+
+	// Over the music, which plays on in time after the effect.
+	bool ok = true;
+	for (int sound = SOUND_MOVE; sound <= SOUND_VICTORY; sound++)
+	{
+		settle();
+		music_play(game_music);
+		run(notes, start);
+		music_effect(sound);
+		run(notes + start, MAX_TICKS - start);
+		memcpy(expected, music, MAX_TICKS);
+		memcpy(expected + start, effects[sound], length[sound]);
+		ok = ok && compare(notes, expected, MAX_TICKS);
+	}
+	report("effects over the music", ok);
+
+	// A lower priority effect does not cut off a higher one, and a higher
+	// or equal one does.
+	ok = true;
+	for (int first = SOUND_MOVE; first <= SOUND_VICTORY; first++)
+	{
+		for (int second = SOUND_MOVE; second <= SOUND_VICTORY; second++)
+		{
+			settle();
+			music_effect(first);
+			run(notes, 10);
+			music_effect(second);
+			run(notes + 10, MAX_TICKS - 10);
+			memset(expected, MUSIC_REST, MAX_TICKS);
+			if (second >= first)
+			{
+				memcpy(expected, effects[first], 10);
+				memcpy(expected + 10, effects[second], length[second]);
+			}
+			else
+			{
+				memcpy(expected, effects[first], length[first]);
+			}
+			ok = ok && compare(notes, expected, MAX_TICKS);
+		}
+	}
+	report("effect priorities", ok);
+
+	// With sound off, nothing is played and effects are ignored, but the
+	// music keeps time.
+	settle();
+	music_play(game_music);
+	run(notes, start);
+	music_set_enabled(false);
+	uint32_t writes = buzzer_writes;
+	music_effect(SOUND_VICTORY);
+	run(notes + start, start);
+	ok = (sounding == MUSIC_REST) && buzzer_writes == writes + 1;
+	music_set_enabled(true);
+	run(notes + 2 * start, MAX_TICKS - 2 * start);
+	ok = ok && compare(notes + 2 * start, music + 2 * start,
+		MAX_TICKS - 2 * start);
+	report("sound off", ok);
+
+	// Stopping the music leaves an effect playing.
+	settle();
+	music_play(game_music);
+	music_effect(SOUND_VICTORY);
+	run(notes, start);
+	music_stop();
+	run(notes + start, MAX_TICKS - start);
+	report("music stopped under an effect",
+		compare(notes, effects[SOUND_VICTORY], MAX_TICKS));
+
+	report("buzzer only written on a change", redundant_writes == 0);
+
+	// Every note of the game music must be in the table.
+	ok = true;
+	for (int i = 0; i < MAX_TICKS; i++)
+	{
+		ok = ok && (music[i] < NUM_NOTES || music[i] == MUSIC_REST);
+	}
+	report("game music notes", ok);
+
+	static const char *const names[] = { "move", "start", "victory" };
+	for (int sound = SOUND_MOVE; sound <= SOUND_VICTORY; sound++)
+	{
+		printf("%s sound: %d ms\n", names[sound], length[sound] * TIMER1_TICK_MS);
+	}
+	int period = 1;
+	while (period < MAX_TICKS / 2
+		&& memcmp(music, music + period, MAX_TICKS - period) != 0)
+	{
+		period++;
+	}
+	uint32_t changes = 0;
+	for (int i = 1; i < MAX_TICKS; i++)
+	{
+		changes += (music[i] != music[i - 1]);
+	}
+	printf("game music: loops every %d ms, %.1f note changes a second\n",
+		period * TIMER1_TICK_MS, changes * 1000.0 / (MAX_TICKS * TIMER1_TICK_MS));
+}
+
+int main(void)
+{
+	check_scores();
+	check_effects();
+	printf("%u failures\n", failures);
+	return failures ? 1 : 0;
+}
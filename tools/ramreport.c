@@ -0,0 +1,467 @@
+/*
+ * ramreport.c
+ *
+ * Author: Riley Stewart
+ *
+ * Reports the RAM each module of the game takes, from its object file:
+ *
+ *   - data:  initialised variables (.data), which the AVR copies to RAM
+ *   - bss:   variables that start at zero (.bss)
+ *   - const: constants not in program memory (.rodata), including string
+ *            literals not wrapped in PSTR(), which the AVR also copies to
+ *            RAM. Tables in program memory and the EEPROM are not counted.
+ *
+ * The rest of the 2 KB is the stack. If the modules were built with
+ * -fcallgraph-info=su (gcc 10 or later), their call graphs are joined up to
+ * find the deepest stack from main(), and the deepest interrupt handler is
+ * added on top, as an interrupt can come at the deepest point. Calls through
+ * function pointers and into the C library are not in the call graphs, so
+ * they are not counted.
+ *
+ * The report fails if the variables are over a budget, or if the variables
+ * and the deepest stack do not fit in RAM, so a change that adds either
+ * shows up before it reaches the board.
+ *
+ * The objects are normally built for the host (see the ram-report target
+ * in the Makefile), where pointers are 8 bytes and ints 4, rather than 2 and
+ * 2 on the AVR, so the sizes are a little over what the board uses. Objects
+ * built with avr-gcc are read the same way and give the board's own sizes.
+ *
+ * Usage: ramreport [-b budget] [-r ram] [-s frames] object...
+ *   -b  the most bytes of variables (default 1536)
+ *   -r  the size of RAM (default 2048)
+ *   -s  the number of largest stack frames to print (default 8)
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <unistd.h>
+#include <elf.h>
+
+// The default budget for variables, and the ATmega324A's RAM, in bytes.
+#define DEFAULT_BUDGET	(1536)
+#define DEFAULT_RAM		(2048)
+
+#define MAX_FUNCTIONS	(1024)
+#define MAX_CALLS		(4096)
+#define MAX_NAME		(96)
+
+typedef struct
+{
+	unsigned long data;
+	unsigned long bss;
+	unsigned long constant;
+} ModuleRam;
+
+// A function from the call graphs. Functions with no body (declared but not
+// defined in any module read) have no frame.
+typedef struct
+{
+	char name[MAX_NAME];
+	unsigned long frame;
+	bool defined;
+	// For finding the deepest stack: 0 = not visited, 1 = being visited
+	// (a call back to it is recursion), 2 = done.
+	uint8_t state;
+	unsigned long depth;
+	int deepest_call;	// The callee on the deepest path, or -1
+} Function;
+
+typedef struct
+{
+	int caller;
+	int callee;
+} Call;
+
+static Function functions[MAX_FUNCTIONS];
+static int num_functions;
+static Call calls[MAX_CALLS];
+static int num_calls;
+
+// Adds the size of one variable to the module's total, by the name of the
+// section it is in.
+static void count_variable(ModuleRam *ram, const char *name, unsigned long size)
+{
+	if (strncmp(name, ".data", 5) == 0)
+	{
+		ram->data += size;
+	}
+	else if (strncmp(name, ".bss", 4) == 0)
+	{
+		ram->bss += size;
+	}
+	else if (strncmp(name, ".rodata", 7) == 0
+		&& strncmp(name, ".rodata.cst", 11) != 0)
+	{
+		// .rodata.cst* holds the host compiler's own constants (such as
+		// floating point numbers), which the AVR keeps in its instructions.
+		ram->constant += size;
+	}
+}
+
+// Adds up the sizes of the variables in an ELF object's symbol table, by
+// the section each is in. Symbols are used rather than sections, as the
+// host pads sections to align its arrays, which the AVR does not. This is
+// a macro so the same code reads 32 and 64-bit objects; both the host and
+// the AVR are little-endian, as is assumed here.
+#define COUNT_SYMBOLS(Ehdr, Shdr, Sym, image, ram)								\
+	do																			\
+	{																			\
+		const Ehdr *header = (const Ehdr *)(image);								\
+		const Shdr *sections = (const Shdr *)((image) + header->e_shoff);		\
+		const char *names = (const char *)(image)								\
+			+ sections[header->e_shstrndx].sh_offset;							\
+		for (unsigned i = 0; i < header->e_shnum; i++)							\
+		{																		\
+			if (sections[i].sh_type != SHT_SYMTAB)								\
+			{																	\
+				continue;														\
+			}																	\
+			const Sym *symbols = (const Sym *)((image) + sections[i].sh_offset);	\
+			unsigned count = sections[i].sh_size / sizeof(Sym);					\
+			for (unsigned j = 0; j < count; j++)								\
+			{																	\
+				unsigned index = symbols[j].st_shndx;							\
+				if (index == SHN_UNDEF || index >= header->e_shnum)				\
+				{																\
+					continue;													\
+				}																\
+				if (sections[index].sh_flags & SHF_ALLOC)						\
+				{																\
+					count_variable((ram), names + sections[index].sh_name,		\
+						symbols[j].st_size);									\
+				}																\
+			}																	\
+		}																		\
+	} while (0)
+
+static bool read_object(const char *path, ModuleRam *ram)
+{
+	FILE *file = fopen(path, "rb");
+	if (!file)
+	{
+		perror(path);
+		return false;
+	}
+	fseek(file, 0, SEEK_END);
+	long length = ftell(file);
+	fseek(file, 0, SEEK_SET);
+	unsigned char *image = malloc(length);
+	bool ok = image && fread(image, 1, length, file) == (size_t)length;
+	fclose(file);
+	if (!ok || length < EI_NIDENT || memcmp(image, ELFMAG, SELFMAG) != 0)
+	{
+		fprintf(stderr, "%s: not an ELF object\n", path);
+		free(image);
+		return false;
+	}
+
+	memset(ram, 0, sizeof(*ram));
+	if (image[EI_CLASS] == ELFCLASS64)
+	{
+		COUNT_SYMBOLS(Elf64_Ehdr, Elf64_Shdr, Elf64_Sym, image, ram);
+	}
+	else
+	{
+		COUNT_SYMBOLS(Elf32_Ehdr, Elf32_Shdr, Elf32_Sym, image, ram);
+	}
+	free(image);
+	return true;
+}
+
+// Finds a function by its name in the call graph, adding it if it is new.
+static int find_function(const char *name)
+{
+	for (int i = 0; i < num_functions; i++)
+	{
+		if (strcmp(functions[i].name, name) == 0)
+		{
+			return i;
+		}
+	}
+	if (num_functions == MAX_FUNCTIONS)
+	{
+		fprintf(stderr, "too many functions\n");
+		exit(2);
+	}
+	Function *function = &functions[num_functions];
+	snprintf(function->name, sizeof(function->name), "%s", name);
+	function->deepest_call = -1;
+	return num_functions++;
+}
+
+// Copies the quoted string after key in a line into value. Returns a
+// pointer past the closing quote, or NULL if the key is not there.
+static const char *get_quoted(const char *line, const char *key, char *value,
+	size_t size)
+{
+	const char *start = strstr(line, key);
+	if (!start)
+	{
+		return NULL;
+	}
+	start += strlen(key);
+	const char *end = strchr(start, '"');
+	if (!end)
+	{
+		return NULL;
+	}
+	snprintf(value, size, "%.*s", (int)(end - start), start);
+	return end + 1;
+}
+
+// Reads a module's call graph (its .ci file, next to the object), if it has
+// one. The lines used are
+//   node: { title: "name" label: "name\nfile:line:column\nN bytes (static)" }
+//   edge: { sourcename: "caller" targetname: "callee" ... }
+// where the title of a static function is prefixed with its file name.
+static void read_call_graph(const char *object)
+{
+	char path[256];
+	snprintf(path, sizeof(path), "%.*s.ci", (int)(strlen(object) - 2), object);
+	FILE *file = fopen(path, "r");
+	if (!file)
+	{
+		return;
+	}
+	char line[512];
+	char name[MAX_NAME];
+	char label[256];
+	while (fgets(line, sizeof(line), file))
+	{
+		if (strncmp(line, "node:", 5) == 0
+			&& get_quoted(line, "title: \"", name, sizeof(name))
+			&& get_quoted(line, "label: \"", label, sizeof(label)))
+		{
+			const char *bytes = strstr(label, " bytes");
+			if (bytes)
+			{
+				while (bytes > label && bytes[-1] >= '0' && bytes[-1] <= '9')
+				{
+					bytes--;
+				}
+				Function *function = &functions[find_function(name)];
+				function->frame = strtoul(bytes, NULL, 10);
+				function->defined = true;
+			}
+		}
+		else if (strncmp(line, "edge:", 5) == 0)
+		{
+			char callee[MAX_NAME];
+			if (get_quoted(line, "sourcename: \"", name, sizeof(name))
+				&& get_quoted(line, "targetname: \"", callee, sizeof(callee)))
+			{
+				if (num_calls == MAX_CALLS)
+				{
+					fprintf(stderr, "too many calls\n");
+					exit(2);
+				}
+				calls[num_calls].caller = find_function(name);
+				calls[num_calls].callee = find_function(callee);
+				num_calls++;
+			}
+		}
+	}
+	fclose(file);
+}
+
+// The name of a function, without the file name a static function's is
+// prefixed with.
+static const char *short_name(const char *name)
+{
+	const char *colon = strrchr(name, ':');
+	return colon ? colon + 1 : name;
+}
+
+// Works out the deepest stack used by a function and the functions it
+// calls, remembering the path. A call back into a function already on the
+// path is recursion, which is counted as going one level deeper (as in
+// serialio.c, which sends a '\r' before each '\n' by calling itself) and
+// printed so it can be checked that it goes no deeper.
+static unsigned long stack_depth(int index)
+{
+	Function *function = &functions[index];
+	if (function->state == 2)
+	{
+		return function->depth;
+	}
+	function->state = 1;
+	unsigned long deepest = 0;
+	for (int i = 0; i < num_calls; i++)
+	{
+		if (calls[i].caller != index)
+		{
+			continue;
+		}
+		Function *callee = &functions[calls[i].callee];
+		unsigned long depth;
+		if (callee->state == 1)
+		{
+			printf("recursion: %s calls %s\n", short_name(function->name),
+				short_name(callee->name));
+			depth = callee->frame;
+		}
+		else
+		{
+			depth = stack_depth(calls[i].callee);
+			if (depth > deepest || function->deepest_call < 0)
+			{
+				function->deepest_call = calls[i].callee;
+			}
+		}
+		if (depth > deepest)
+		{
+			deepest = depth;
+		}
+	}
+	function->depth = function->frame + deepest;
+	function->state = 2;
+	return function->depth;
+}
+
+// Prints the deepest path from a function, with the frame of each function
+// on it.
+static void print_path(int index)
+{
+	for (; index >= 0; index = functions[index].deepest_call)
+	{
+		if (functions[index].defined)
+		{
+			printf("  %-32s %6lu\n", short_name(functions[index].name),
+				functions[index].frame);
+		}
+	}
+}
+
+// The module's name, from the object's path.
+static void module_name(const char *path, char *name, size_t size)
+{
+	const char *base = strrchr(path, '/');
+	base = base ? base + 1 : path;
+	const char *dot = strrchr(base, '.');
+	int length = dot ? (int)(dot - base) : (int)strlen(base);
+	snprintf(name, size, "%.*s", length, base);
+}
+
+int main(int argc, char **argv)
+{
+	unsigned long budget = DEFAULT_BUDGET;
+	unsigned long ram_size = DEFAULT_RAM;
+	int show_frames = 8;
+	int option;
+	while ((option = getopt(argc, argv, "b:r:s:")) != -1)
+	{
+		switch (option)
+		{
+			case 'b':
+				budget = strtoul(optarg, NULL, 0);
+				break;
+			case 'r':
+				ram_size = strtoul(optarg, NULL, 0);
+				break;
+			case 's':
+				show_frames = atoi(optarg);
+				break;
+			default:
+				optind = argc;
+				break;
+		}
+	}
+	if (optind >= argc)
+	{
+		fprintf(stderr, "usage: %s [-b budget] [-r ram] [-s frames] object...\n",
+			argv[0]);
+		return 2;
+	}
+
+	ModuleRam total = { 0 };
+	printf("%-14s %6s %6s %6s %6s\n", "module", "data", "bss", "const", "total");
+	for (int i = optind; i < argc; i++)
+	{
+		ModuleRam ram;
+		if (!read_object(argv[i], &ram))
+		{
+			return 2;
+		}
+		read_call_graph(argv[i]);
+		unsigned long sum = ram.data + ram.bss + ram.constant;
+		if (sum)
+		{
+			char name[64];
+			module_name(argv[i], name, sizeof(name));
+			printf("%-14s %6lu %6lu %6lu %6lu\n", name, ram.data, ram.bss,
+				ram.constant, sum);
+		}
+		total.data += ram.data;
+		total.bss += ram.bss;
+		total.constant += ram.constant;
+	}
+	unsigned long variables = total.data + total.bss + total.constant;
+	printf("%-14s %6lu %6lu %6lu %6lu\n", "total", total.data, total.bss,
+		total.constant, variables);
+	bool ok = variables <= budget;
+
+	int main_index = -1;
+	for (int i = 0; i < num_functions; i++)
+	{
+		if (strcmp(functions[i].name, "main") == 0 && functions[i].defined)
+		{
+			main_index = i;
+		}
+	}
+	if (main_index >= 0)
+	{
+		// The largest frames, by picking the largest left each time.
+		static bool printed[MAX_FUNCTIONS];
+		printf("\nlargest stack frames:\n");
+		for (int n = 0; n < show_frames && n < num_functions; n++)
+		{
+			int largest = -1;
+			for (int i = 0; i < num_functions; i++)
+			{
+				if (!printed[i] && (largest < 0
+					|| functions[i].frame > functions[largest].frame))
+				{
+					largest = i;
+				}
+			}
+			printf("  %-32s %6lu\n", short_name(functions[largest].name),
+				functions[largest].frame);
+			printed[largest] = true;
+		}
+
+		// Interrupt handlers are named after their vectors.
+		unsigned long main_depth = stack_depth(main_index);
+		int deepest_interrupt = -1;
+		for (int i = 0; i < num_functions; i++)
+		{
+			const char *suffix = strstr(functions[i].name, "_vect");
+			if (suffix && suffix[5] == '\0' && functions[i].defined
+				&& (deepest_interrupt < 0
+					|| stack_depth(i) > functions[deepest_interrupt].depth))
+			{
+				deepest_interrupt = i;
+			}
+		}
+		printf("\ndeepest stack from main: %lu\n", main_depth);
+		print_path(main_index);
+		unsigned long stack = main_depth;
+		if (deepest_interrupt >= 0)
+		{
+			printf("deepest interrupt: %lu\n", functions[deepest_interrupt].depth);
+			print_path(deepest_interrupt);
+			stack += functions[deepest_interrupt].depth;
+		}
+		printf("\n%lu bytes of variables and %lu of stack, of %lu: %s\n",
+			variables, stack, ram_size,
+			variables + stack <= ram_size ? "ok" : "STACK OVERFLOW");
+		ok = ok && variables + stack <= ram_size;
+	}
+
+	printf("%lu of %lu bytes budgeted for variables: %s\n", variables, budget,
+		variables <= budget ? "ok" : "OVER BUDGET");
+	return ok ? 0 : 1;
+}
@@ -0,0 +1,110 @@
+/*
+ * renderbench.c
+ *
+ * Author: Riley Stewart
+ *
+ * Measures how many bytes the terminal display costs per move, running the
+ * game's own code (AVRAssignment/game.c and friends) on the host. The same
+ * random walk through a level is played three ways:
+ *
+ *   full redraw  draw_terminal_board() after every move
+ *   rows         what the game sends today: each row that changed is
+ *                redrawn by update_terminal_display()
+ *   headless     the LED matrix image drawn by termview_render(), one
+ *                diff per move (the status line included)
+ *
+ * Usage: renderbench [moves [level]]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include "game.h"
+#include "levels.h"
+#include "ledmatrix.h"
+#include "anim.h"
+#include "termview.h"
+#include "hal.h"
+
+typedef enum
+{
+	FULL_REDRAW,
+	ROWS,
+	HEADLESS
+} Renderer;
+
+static const char *const renderer_names[] = { "full redraw", "rows",
+	"headless" };
+
+static const int8_t directions[4][2] = { { 1, 0 }, { -1, 0 }, { 0, 1 },
+	{ 0, -1 } };
+
+// Plays the walk, and returns the bytes sent for the moves (not counting
+// the first drawing of the level).
+static uint32_t play(Renderer renderer, uint8_t level, unsigned moves,
+	unsigned *moves_made, uint32_t *start_bytes)
+{
+	LevelLayout layout;
+	decode_level(level, &layout);
+	srand(1);
+	ledmatrix_set_headless(renderer == HEADLESS);
+	hal_serial_bytes = 0;
+	initialise_game(&layout);
+	if (renderer == HEADLESS)
+	{
+		termview_set_status(0, 0);
+		termview_render();
+	}
+	*start_bytes = hal_serial_bytes;
+
+	hal_serial_bytes = 0;
+	*moves_made = 0;
+	for (unsigned i = 0; i < moves; i++)
+	{
+		const int8_t *delta = directions[rand() % 4];
+		if (move_player(delta[0], delta[1]))
+		{
+			(*moves_made)++;
+		}
+		// Show where the move ends, without the in-between frames.
+		anim_finish();
+		hal_time += 1000;
+		if (renderer == FULL_REDRAW)
+		{
+			draw_terminal_board();
+		}
+		else if (renderer == HEADLESS)
+		{
+			termview_set_status(*moves_made, (uint16_t)(hal_time / 1000));
+			termview_render();
+		}
+	}
+	return hal_serial_bytes;
+}
+
+int main(int argc, char *argv[])
+{
+	unsigned moves = argc > 1 ? (unsigned)atoi(argv[1]) : 2000;
+	uint8_t level = argc > 2 ? (uint8_t)atoi(argv[2]) : 1;
+	if (level < 1 || level > NUM_LEVELS)
+	{
+		fprintf(stderr, "level must be 1 to %u\n", NUM_LEVELS);
+		return 2;
+	}
+
+	printf("level %u, %u move attempts\n", level, moves);
+	printf("%-12s %12s %12s %14s\n", "renderer", "level start", "total",
+		"bytes per move");
+	for (Renderer renderer = FULL_REDRAW; renderer <= HEADLESS; renderer++)
+	{
+		unsigned made;
+		uint32_t start;
+		uint32_t total = play(renderer, level, moves, &made, &start);
+		printf("%-12s %12lu %12lu %14.1f\n", renderer_names[renderer],
+			(unsigned long)start, (unsigned long)total,
+			made ? (double)total / made : 0.0);
+	}
+	printf("(%s)\n", "bytes include the messages shown for blocked moves");
+	return 0;
+}
@@ -0,0 +1,598 @@
+/*
+ * solver.c
+ *
+ * Author: Riley Stewart
+ */
+
+#include "solver.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include "game.h"
+#include "zobrist.h"
+
+#define NUM_CELLS	(MATRIX_NUM_ROWS * MATRIX_NUM_COLUMNS)
+#define NUM_DIRS	(4)
+#define NONE		(0xFFFFFFFFU)
+
+// Most targets (and so boxes) a level can have.
+#define MAX_TARGETS	(32)
+
+// Distance of a square no box can be pushed to a target from.
+#define UNREACHABLE	(-1)
+#define NO_MATCH	(0x3FFFFFFF)
+
+// The distance of a stored position that can never be solved.
+#define DEAD		(0xFFFF)
+
+// A set of squares, one bit per square.
+typedef struct
+{
+	uint64_t bits[NUM_CELLS / 64];
+} SquareSet;
+
+// A stored position. Positions are only stored after a push, so the player
+// is always on the square the pushed box just left. The key is the
+// position's Zobrist hash, as the game keeps it (see zobrist.h), which is
+// updated from the position before rather than worked out again.
+typedef struct
+{
+	SquareSet boxes;
+	uint32_t key;
+	uint8_t player;
+	uint16_t moves;
+	uint16_t pushes;
+	uint16_t distance;	// Lower bound on the pushes still needed, or DEAD
+	uint32_t cost;
+} Position;
+
+// Queue entries are ordered by estimated total cost, then by cost so far,
+// largest first, so of the equally promising positions the one closest to
+// a solution is tried first.
+typedef struct
+{
+	uint64_t priority;
+	uint32_t position;
+} QueueEntry;
+
+static SquareSet walls;
+static SquareSet targets;
+static int push_distance[NUM_CELLS];
+static SolveGoal goal;
+
+// Pushes needed to get a box from each square to each target, ignoring the
+// other boxes.
+static int target_cells[MAX_TARGETS];
+static int num_targets;
+static int target_distance[MAX_TARGETS][NUM_CELLS];
+
+static Position *positions;
+static size_t num_positions;
+static size_t positions_size;
+static uint32_t *table;
+static size_t table_size;
+static QueueEntry *queue;
+static size_t queue_length;
+static size_t queue_size;
+
+static bool has(const SquareSet *set, int cell)
+{
+	return (set->bits[cell >> 6] >> (cell & 63)) & 1;
+}
+
+static void add(SquareSet *set, int cell)
+{
+	set->bits[cell >> 6] |= 1ULL << (cell & 63);
+}
+
+static void remove_cell(SquareSet *set, int cell)
+{
+	set->bits[cell >> 6] &= ~(1ULL << (cell & 63));
+}
+
+static bool same(const SquareSet *a, const SquareSet *b)
+{
+	return memcmp(a, b, sizeof(*a)) == 0;
+}
+
+// Directions are up, down, right, left as in hint.c; the opposite of a
+// direction is (direction ^ 1). Movement wraps around the board edges.
+static int neighbour(int cell, int dir)
+{
+	static const int delta_row[NUM_DIRS] = { 1, -1, 0, 0 };
+	static const int delta_col[NUM_DIRS] = { 0, 0, 1, -1 };
+	int row = (cell / MATRIX_NUM_COLUMNS + delta_row[dir]) & (MATRIX_NUM_ROWS - 1);
+	int col = (cell % MATRIX_NUM_COLUMNS + delta_col[dir]) & (MATRIX_NUM_COLUMNS - 1);
+	return row * MATRIX_NUM_COLUMNS + col;
+}
+
+// Works out the push distances to one target by pulling a box backwards
+// from it. A box can be pushed from square A to its neighbour B if neither A
+// nor the square behind A (where the player stands) is a wall.
+static void pull_from_target(int target, int *distance)
+{
+	int queue_cells[NUM_CELLS];
+	int head = 0;
+	int tail = 0;
+	for (int cell = 0; cell < NUM_CELLS; cell++)
+	{
+		distance[cell] = UNREACHABLE;
+	}
+	distance[target] = 0;
+	queue_cells[tail++] = target;
+	while (head < tail)
+	{
+		int cell = queue_cells[head++];
+		for (int dir = 0; dir < NUM_DIRS; dir++)
+		{
+			int box_from = neighbour(cell, dir ^ 1);
+			int player_from = neighbour(box_from, dir ^ 1);
+			if (distance[box_from] == UNREACHABLE && !has(&walls, box_from)
+				&& !has(&walls, player_from))
+			{
+				distance[box_from] = distance[cell] + 1;
+				queue_cells[tail++] = box_from;
+			}
+		}
+	}
+}
+
+static void compute_push_distances(void)
+{
+	num_targets = 0;
+	for (int cell = 0; cell < NUM_CELLS; cell++)
+	{
+		push_distance[cell] = UNREACHABLE;
+		if (has(&targets, cell) && num_targets < MAX_TARGETS)
+		{
+			target_cells[num_targets++] = cell;
+		}
+	}
+	for (int t = 0; t < num_targets; t++)
+	{
+		pull_from_target(target_cells[t], target_distance[t]);
+		for (int cell = 0; cell < NUM_CELLS; cell++)
+		{
+			int distance = target_distance[t][cell];
+			if (distance != UNREACHABLE && (push_distance[cell] == UNREACHABLE
+				|| distance < push_distance[cell]))
+			{
+				push_distance[cell] = distance;
+			}
+		}
+	}
+}
+
+// Finds the smallest total push distance over every way of giving each box
+// its own target (the Hungarian method, O(n^3)). This never over-estimates,
+// since every box needs a different target in the end, and is much closer
+// than sending each box to its nearest target when boxes share one.
+// Returns -1 if there is no way to give every box a target it can reach.
+static int heuristic(const SquareSet *boxes)
+{
+	int box_cells[MAX_TARGETS];
+	int num_boxes = 0;
+	for (int cell = 0; cell < NUM_CELLS; cell++)
+	{
+		if (has(boxes, cell))
+		{
+			if (push_distance[cell] == UNREACHABLE || num_boxes == num_targets)
+			{
+				return -1;
+			}
+			box_cells[num_boxes++] = cell;
+		}
+	}
+
+	// Rows are boxes and columns are targets, numbered from 1; column 0 is
+	// the box being added. u and v are the potentials of rows and columns.
+	int u[MAX_TARGETS + 1] = { 0 };
+	int v[MAX_TARGETS + 1] = { 0 };
+	int match[MAX_TARGETS + 1] = { 0 };
+	int way[MAX_TARGETS + 1];
+	for (int box = 1; box <= num_boxes; box++)
+	{
+		int min_slack[MAX_TARGETS + 1];
+		bool used[MAX_TARGETS + 1] = { false };
+		int column = 0;
+		match[0] = box;
+		for (int t = 0; t <= num_targets; t++)
+		{
+			min_slack[t] = NO_MATCH;
+		}
+		do
+		{
+			used[column] = true;
+			int row = match[column];
+			int delta = NO_MATCH;
+			int next = 0;
+			for (int t = 1; t <= num_targets; t++)
+			{
+				if (used[t])
+				{
+					continue;
+				}
+				int distance = target_distance[t - 1][box_cells[row - 1]];
+				int cost = (distance == UNREACHABLE ? NO_MATCH : distance)
+					- u[row] - v[t];
+				if (cost < min_slack[t])
+				{
+					min_slack[t] = cost;
+					way[t] = column;
+				}
+				if (min_slack[t] < delta)
+				{
+					delta = min_slack[t];
+					next = t;
+				}
+			}
+			for (int t = 0; t <= num_targets; t++)
+			{
+				if (used[t])
+				{
+					u[match[t]] += delta;
+					v[t] -= delta;
+				}
+				else
+				{
+					min_slack[t] -= delta;
+				}
+			}
+			column = next;
+		} while (match[column] != 0);
+		do
+		{
+			int previous = way[column];
+			match[column] = match[previous];
+			column = previous;
+		} while (column != 0);
+	}
+	int total = 0;
+	for (int t = 1; t <= num_targets; t++)
+	{
+		if (match[t] != 0)
+		{
+			int distance = target_distance[t - 1][box_cells[match[t] - 1]];
+			if (distance == UNREACHABLE)
+			{
+				return -1;
+			}
+			total += distance;
+		}
+	}
+	return total;
+}
+
+// Checks whether the box just pushed to a square is now part of a 2x2 block
+// of walls and boxes with a box off its target. No box in such a block can
+// ever move again, so the position can never be solved.
+static bool is_frozen(const SquareSet *boxes, int cell)
+{
+	for (int corner = 0; corner < 4; corner++)
+	{
+		int square = cell;
+		if (corner & 1)
+		{
+			square = neighbour(square, 1);
+		}
+		if (corner & 2)
+		{
+			square = neighbour(square, 3);
+		}
+		int block[4] = { square, neighbour(square, 0), neighbour(square, 2),
+			neighbour(neighbour(square, 0), 2) };
+		bool blocked = true;
+		bool off_target = false;
+		for (int i = 0; i < 4 && blocked; i++)
+		{
+			blocked = has(&walls, block[i]) || has(boxes, block[i]);
+			off_target |= has(boxes, block[i]) && !has(&targets, block[i]);
+		}
+		if (blocked && off_target)
+		{
+			return true;
+		}
+	}
+	return false;
+}
+
+// Walking distance from the player to every square (-1 if unreachable).
+static void walk_distances(const SquareSet *boxes, int player, int *distance)
+{
+	int queue_cells[NUM_CELLS];
+	int head = 0;
+	int tail = 0;
+	for (int cell = 0; cell < NUM_CELLS; cell++)
+	{
+		distance[cell] = -1;
+	}
+	distance[player] = 0;
+	queue_cells[tail++] = player;
+	while (head < tail)
+	{
+		int cell = queue_cells[head++];
+		for (int dir = 0; dir < NUM_DIRS; dir++)
+		{
+			int next = neighbour(cell, dir);
+			if (distance[next] < 0 && !has(&walls, next) && !has(boxes, next))
+			{
+				distance[next] = distance[cell] + 1;
+				queue_cells[tail++] = next;
+			}
+		}
+	}
+}
+
+static uint32_t make_cost(uint16_t moves, uint16_t pushes)
+{
+	if (goal == SOLVE_PUSHES)
+	{
+		return ((uint32_t)pushes << 16) | moves;
+	}
+	return ((uint32_t)moves << 16) | pushes;
+}
+
+// Lower bound on the remaining cost: each push is also a move.
+static uint32_t remaining_cost(int distance)
+{
+	return ((uint32_t)distance << 16) | (uint32_t)distance;
+}
+
+static uint32_t box_key(int cell)
+{
+	return zobrist_box(cell / MATRIX_NUM_COLUMNS, cell % MATRIX_NUM_COLUMNS);
+}
+
+static uint32_t player_key(int cell)
+{
+	return zobrist_player(cell / MATRIX_NUM_COLUMNS, cell % MATRIX_NUM_COLUMNS);
+}
+
+static void grow_table(void)
+{
+	size_t new_size = table_size ? table_size * 2 : (1U << 16);
+	uint32_t *new_table = malloc(new_size * sizeof(*new_table));
+	if (!new_table)
+	{
+		fprintf(stderr, "solver: out of memory\n");
+		exit(1);
+	}
+	memset(new_table, 0xFF, new_size * sizeof(*new_table));
+	for (size_t i = 0; i < num_positions; i++)
+	{
+		size_t slot = positions[i].key & (new_size - 1);
+		while (new_table[slot] != NONE)
+		{
+			slot = (slot + 1) & (new_size - 1);
+		}
+		new_table[slot] = (uint32_t)i;
+	}
+	free(table);
+	table = new_table;
+	table_size = new_size;
+}
+
+// Finds a stored position, adding it if it is new.
+static uint32_t find_position(const SquareSet *boxes, int player, uint32_t key)
+{
+	if (num_positions * 2 >= table_size)
+	{
+		grow_table();
+	}
+	size_t slot = key & (table_size - 1);
+	while (table[slot] != NONE)
+	{
+		Position *position = &positions[table[slot]];
+		if (position->key == key && position->player == player
+			&& same(&position->boxes, boxes))
+		{
+			return table[slot];
+		}
+		slot = (slot + 1) & (table_size - 1);
+	}
+	if (num_positions == positions_size)
+	{
+		positions_size = positions_size ? positions_size * 2 : (1U << 16);
+		positions = realloc(positions, positions_size * sizeof(*positions));
+		if (!positions)
+		{
+			fprintf(stderr, "solver: out of memory\n");
+			exit(1);
+		}
+	}
+	Position *position = &positions[num_positions];
+	position->boxes = *boxes;
+	position->key = key;
+	position->player = (uint8_t)player;
+	position->cost = NONE;
+	table[slot] = (uint32_t)num_positions;
+	return (uint32_t)num_positions++;
+}
+
+static uint64_t make_priority(uint32_t cost, int distance)
+{
+	uint32_t estimate = cost + remaining_cost(distance);
+	return ((uint64_t)estimate << 16) | (uint16_t)~(cost >> 16);
+}
+
+static void queue_push(uint64_t priority, uint32_t position)
+{
+	if (queue_length == queue_size)
+	{
+		queue_size = queue_size ? queue_size * 2 : (1U << 16);
+		queue = realloc(queue, queue_size * sizeof(*queue));
+		if (!queue)
+		{
+			fprintf(stderr, "solver: out of memory\n");
+			exit(1);
+		}
+	}
+	size_t i = queue_length++;
+	while (i > 0)
+	{
+		size_t parent = (i - 1) / 2;
+		if (queue[parent].priority <= priority)
+		{
+			break;
+		}
+		queue[i] = queue[parent];
+		i = parent;
+	}
+	queue[i].priority = priority;
+	queue[i].position = position;
+}
+
+static QueueEntry queue_pop(void)
+{
+	QueueEntry top = queue[0];
+	QueueEntry last = queue[--queue_length];
+	size_t i = 0;
+	for (;;)
+	{
+		size_t child = 2 * i + 1;
+		if (child >= queue_length)
+		{
+			break;
+		}
+		if (child + 1 < queue_length
+			&& queue[child + 1].priority < queue[child].priority)
+		{
+			child++;
+		}
+		if (queue[child].priority >= last.priority)
+		{
+			break;
+		}
+		queue[i] = queue[child];
+		i = child;
+	}
+	queue[i] = last;
+	return top;
+}
+
+static void reset(void)
+{
+	free(positions);
+	free(table);
+	free(queue);
+	positions = NULL;
+	table = NULL;
+	queue = NULL;
+	num_positions = positions_size = table_size = 0;
+	queue_length = queue_size = 0;
+}
+
+bool solve(const LevelLayout *layout, SolveGoal solve_goal, Solution *solution)
+{
+	SquareSet boxes;
+	memset(&walls, 0, sizeof(walls));
+	memset(&targets, 0, sizeof(targets));
+	memset(&boxes, 0, sizeof(boxes));
+	for (int row = 0; row < MATRIX_NUM_ROWS; row++)
+	{
+		for (int col = 0; col < MATRIX_NUM_COLUMNS; col++)
+		{
+			int cell = row * MATRIX_NUM_COLUMNS + col;
+			uint8_t object = layout->board[row][col];
+			if (object & WALL)
+			{
+				add(&walls, cell);
+			}
+			if (object & BOX)
+			{
+				add(&boxes, cell);
+			}
+			if (object & TARGET)
+			{
+				add(&targets, cell);
+			}
+		}
+	}
+	goal = solve_goal;
+	compute_push_distances();
+	reset();
+
+	int start_distance = heuristic(&boxes);
+	if (start_distance < 0)
+	{
+		return false;
+	}
+	int player = layout->player_row * MATRIX_NUM_COLUMNS + layout->player_col;
+	uint32_t start = find_position(&boxes, player, zobrist_hash(layout));
+	positions[start].cost = 0;
+	positions[start].moves = 0;
+	positions[start].pushes = 0;
+	positions[start].distance = (uint16_t)start_distance;
+	queue_push(make_priority(0, start_distance), start);
+
+	int distance[NUM_CELLS];
+	while (queue_length > 0 && num_positions < SOLVER_STATE_LIMIT)
+	{
+		QueueEntry entry = queue_pop();
+		Position current = positions[entry.position];
+		if (make_priority(current.cost, current.distance) < entry.priority)
+		{
+			// Already reached more cheaply since this entry was queued.
+			continue;
+		}
+		if (same(&current.boxes, &targets))
+		{
+			solution->moves = current.moves;
+			solution->pushes = current.pushes;
+			solution->states = (uint32_t)num_positions;
+			reset();
+			return true;
+		}
+		walk_distances(&current.boxes, current.player, distance);
+		for (int box = 0; box < NUM_CELLS; box++)
+		{
+			if (!has(&current.boxes, box))
+			{
+				continue;
+			}
+			for (int dir = 0; dir < NUM_DIRS; dir++)
+			{
+				int from = neighbour(box, dir ^ 1);
+				int to = neighbour(box, dir);
+				if (distance[from] < 0 || has(&walls, to)
+					|| has(&current.boxes, to) || push_distance[to] < 0)
+				{
+					continue;
+				}
+				SquareSet next = current.boxes;
+				remove_cell(&next, box);
+				add(&next, to);
+				if (is_frozen(&next, to))
+				{
+					continue;
+				}
+				uint16_t moves = current.moves + distance[from] + 1;
+				uint16_t pushes = current.pushes + 1;
+				uint32_t cost = make_cost(moves, pushes);
+				// The box moves on, and the player takes its place.
+				uint32_t key = current.key ^ box_key(box) ^ box_key(to)
+					^ player_key(current.player) ^ player_key(box);
+				uint32_t index = find_position(&next, box, key);
+				Position *position = &positions[index];
+				if (position->cost == NONE)
+				{
+					// A new position. Its distance is worked out once, here.
+					int next_distance = heuristic(&next);
+					position->distance = (next_distance < 0) ? DEAD
+						: (uint16_t)next_distance;
+				}
+				if (position->distance != DEAD && cost < position->cost)
+				{
+					position->cost = cost;
+					position->moves = moves;
+					position->pushes = pushes;
+					queue_push(make_priority(cost, position->distance), index);
+				}
+			}
+		}
+	}
+	reset();
+	return false;
+}
@@ -0,0 +1,46 @@
+/*
+ * solver.h
+ *
+ * Author: Riley Stewart
+ *
+ * Full Sokoban solver for the host tools. This is an A* search over box
+ * pushes with a hash table of visited positions, so unlike the on-device
+ * hint search it always finds an optimal solution, at the cost of using
+ * megabytes of memory.
+ */
+
+#ifndef SOLVER_H_
+#define SOLVER_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "levels.h"
+
+// The search gives up (and reports no solution) after storing this many
+// positions, about 100MB.
+#define SOLVER_STATE_LIMIT	(2000000U)
+
+typedef enum
+{
+	SOLVE_MOVES,	// Fewest moves, then fewest pushes
+	SOLVE_PUSHES	// Fewest pushes, then fewest moves
+} SolveGoal;
+
+typedef struct
+{
+	uint16_t moves;
+	uint16_t pushes;
+	uint32_t states;	// Number of positions the search stored
+} Solution;
+
+/// <summary>
+/// Solves a level from the given position.
+/// </summary>
+/// <param name="layout">The board and player position to solve from.</param>
+/// <param name="goal">What the solution should have the fewest of.</param>
+/// <param name="solution">Filled in with the solution length.</param>
+/// <returns>Whether a solution was found. This is false if the position
+/// cannot be solved, or needs more than SOLVER_STATE_LIMIT positions.</returns>
+bool solve(const LevelLayout *layout, SolveGoal goal, Solution *solution);
+
+#endif /* SOLVER_H_ */
@@ -0,0 +1,343 @@
+/*
+ * teldecode.c
+ *
+ * Author: Riley Stewart
+ *
+ * Decoder for the game's binary telemetry (AVRAssignment/telemetry.h). It
+ * reads the serial stream from the board, picks out the telemetry packets
+ * and prints one line per packet. Press 'x' in the game to turn telemetry
+ * on.
+ *
+ * Usage: teldecode [-t] [file|device]   decode a capture or serial port
+ *                                       (standard input if none is given);
+ *                                       -t also passes the terminal text
+ *                                       through to standard output
+ *        teldecode -s                   self test: encode packets with the
+ *                                       game's telemetry code through a
+ *                                       slow output buffer mixed with text,
+ *                                       and check the decoder gets them all
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <fcntl.h>
+#include <termios.h>
+#include <unistd.h>
+#include <util/crc16.h>
+#include "telemetry.h"
+#include "serialio.h"
+
+#define MAX_PACKET	(TELEMETRY_MAX_PAYLOAD + 5)
+
+typedef struct
+{
+	uint8_t packet[MAX_PACKET];
+	uint8_t used;
+	void (*text)(uint8_t byte);
+	void (*packet_done)(TelemetryType type, const uint8_t *payload,
+		uint8_t length);
+	unsigned packets;
+	unsigned errors;
+} Decoder;
+
+static void decode_byte(Decoder *decoder, uint8_t byte);
+
+// Throws away a bad packet. Only the start byte is certainly not text, so
+// everything after it is looked at again.
+static void reject_packet(Decoder *decoder)
+{
+	uint8_t rest[MAX_PACKET];
+	uint8_t count = decoder->used - 1;
+	memcpy(rest, decoder->packet + 1, count);
+	decoder->used = 0;
+	decoder->errors++;
+	for (uint8_t i = 0; i < count; i++)
+	{
+		decode_byte(decoder, rest[i]);
+	}
+}
+
+static void decode_byte(Decoder *decoder, uint8_t byte)
+{
+	if (decoder->used == 0)
+	{
+		if (byte == TELEMETRY_START)
+		{
+			decoder->packet[decoder->used++] = byte;
+		}
+		else if (decoder->text)
+		{
+			decoder->text(byte);
+		}
+		return;
+	}
+
+	decoder->packet[decoder->used++] = byte;
+	uint8_t length = decoder->packet[1];
+	if (length > TELEMETRY_MAX_PAYLOAD)
+	{
+		reject_packet(decoder);
+		return;
+	}
+	if (decoder->used < length + 5)
+	{
+		return;
+	}
+
+	uint16_t crc = 0;
+	for (uint8_t i = 1; i < length + 3; i++)
+	{
+		crc = _crc_xmodem_update(crc, decoder->packet[i]);
+	}
+	if ((crc & 0xFF) != decoder->packet[length + 3]
+		|| (crc >> 8) != decoder->packet[length + 4])
+	{
+		reject_packet(decoder);
+		return;
+	}
+	decoder->packets++;
+	decoder->packet_done(decoder->packet[2], decoder->packet + 3, length);
+	decoder->used = 0;
+}
+
+static uint16_t get_u16(const uint8_t *bytes)
+{
+	return (uint16_t)(bytes[0] | bytes[1] << 8);
+}
+
+static void print_packet(TelemetryType type, const uint8_t *payload,
+	uint8_t length)
+{
+	// Short packets are printed raw rather than read past their end.
+	static const uint8_t lengths[] = { 0, 3, 3, 5, 1, 6, 8 };
+	if (type < 1 || type > TELEMETRY_TICK || length < lengths[type])
+	{
+		printf("unknown type %u, %u bytes\n", type, length);
+		fflush(stdout);
+		return;
+	}
+	switch (type)
+	{
+		case TELEMETRY_LEVEL_START:
+			printf("level %u start, par %u\n", payload[0], get_u16(payload + 1));
+			break;
+		case TELEMETRY_MOVE:
+			printf("move %+d,%+d  steps %u\n", (int8_t)payload[0],
+				(int8_t)payload[1], payload[2]);
+			break;
+		case TELEMETRY_PUSH:
+			printf("push (%u,%u) -> (%u,%u)%s\n", payload[0], payload[1],
+				payload[2], payload[3], payload[4] ? " on target" : "");
+			break;
+		case TELEMETRY_UNDO:
+			printf("undo  steps %u\n", payload[0]);
+			break;
+		case TELEMETRY_LEVEL_CLEAR:
+			printf("level %u clear, %u steps, %u s, score %u\n", payload[0],
+				payload[1], get_u16(payload + 2), get_u16(payload + 4));
+			break;
+		case TELEMETRY_TICK:
+			printf("tick %lu ms, game clock %u s, %u packets dropped\n",
+				(unsigned long)(get_u16(payload) | (uint32_t)get_u16(payload + 2) << 16),
+				get_u16(payload + 4), get_u16(payload + 6));
+			break;
+	}
+	fflush(stdout);
+}
+
+static void print_text(uint8_t byte)
+{
+	putchar(byte);
+}
+
+static int decode_file(const char *name, bool pass_text)
+{
+	int fd = 0;
+	if (name)
+	{
+		fd = open(name, O_RDONLY | O_NOCTTY);
+		if (fd < 0)
+		{
+			perror(name);
+			return 2;
+		}
+		struct termios tio;
+		if (tcgetattr(fd, &tio) == 0)
+		{
+			// The game's serial port runs at 19200 baud.
+			cfmakeraw(&tio);
+			cfsetispeed(&tio, B19200);
+			cfsetospeed(&tio, B19200);
+			tcsetattr(fd, TCSANOW, &tio);
+		}
+	}
+	Decoder decoder = { .text = pass_text ? print_text : NULL,
+		.packet_done = print_packet };
+	uint8_t buffer[256];
+	ssize_t count;
+	while ((count = read(fd, buffer, sizeof(buffer))) > 0)
+	{
+		for (ssize_t i = 0; i < count; i++)
+		{
+			decode_byte(&decoder, buffer[i]);
+		}
+	}
+	fprintf(stderr, "%u packets, %u bad\n", decoder.packets, decoder.errors);
+	return 0;
+}
+
+// ---- Self test ----
+
+// A stand-in for the serial output buffer, emptied a few bytes at a time.
+#define TEST_BUFFER_SIZE	SERIAL_OUTPUT_BUFFER_SIZE
+static uint8_t test_buffer[TEST_BUFFER_SIZE];
+static unsigned test_used;
+static uint8_t stream[1 << 20];
+static unsigned stream_length;
+
+bool serial_try_put(const uint8_t *data, uint8_t length)
+{
+	if (TEST_BUFFER_SIZE - test_used < length)
+	{
+		return false;
+	}
+	memcpy(test_buffer + test_used, data, length);
+	test_used += length;
+	return true;
+}
+
+static void drain(unsigned count)
+{
+	if (count > test_used)
+	{
+		count = test_used;
+	}
+	memcpy(stream + stream_length, test_buffer, count);
+	stream_length += count;
+	memmove(test_buffer, test_buffer + count, test_used - count);
+	test_used -= count;
+}
+
+// What the self test sent, to compare with what was decoded.
+static uint8_t sent_text[1 << 20];
+static unsigned sent_text_length;
+static unsigned text_checked;
+static uint8_t sent_steps[1 << 16];
+static unsigned moves_sent;
+static unsigned moves_checked;
+static bool test_ok = true;
+
+static void check_text(uint8_t byte)
+{
+	if (text_checked >= sent_text_length || sent_text[text_checked++] != byte)
+	{
+		test_ok = false;
+	}
+}
+
+static void check_packet(TelemetryType type, const uint8_t *payload,
+	uint8_t length)
+{
+	(void)length;
+	if (type != TELEMETRY_MOVE)
+	{
+		return;
+	}
+	// Packets can be dropped, but the rest must arrive in order.
+	while (moves_checked < moves_sent && sent_steps[moves_checked] != payload[2])
+	{
+		moves_checked++;
+	}
+	if (moves_checked == moves_sent)
+	{
+		test_ok = false;
+	}
+	moves_checked++;
+}
+
+static int self_test(void)
+{
+	static const char text[] = "\x1b[2;1H\x1b[103m   \x1b[0m Moves: 12";
+	telemetry_enable(true);
+	srand(1);
+	for (unsigned i = 0; i < 60000; i++)
+	{
+		// Terminal text, which (like uart_put_char) waits for room.
+		if (rand() % 3 == 0)
+		{
+			for (const char *c = text; *c; c++)
+			{
+				if (test_used == TEST_BUFFER_SIZE)
+				{
+					drain(1);
+				}
+				test_buffer[test_used++] = (uint8_t)*c;
+				sent_text[sent_text_length++] = (uint8_t)*c;
+			}
+		}
+		telemetry_move(1, -1, (uint8_t)moves_sent);
+		sent_steps[moves_sent & 0xFFFF] = (uint8_t)moves_sent;
+		moves_sent++;
+		if (rand() % 4 == 0)
+		{
+			telemetry_push(1, 2, 3, 4, true);
+		}
+		if (rand() % 50 == 0)
+		{
+			telemetry_tick(i, (uint16_t)(i / 1000));
+		}
+		// The UART empties the buffer more slowly than it is filled.
+		drain((unsigned)(rand() % 12));
+	}
+	drain(TEST_BUFFER_SIZE);
+	moves_sent &= 0xFFFF;
+
+	// Corrupt one byte of a packet, which should be rejected without losing
+	// the text that follows it.
+	static const uint8_t bad[] = { TELEMETRY_START, 1, TELEMETRY_UNDO, 5, 0x00,
+		0x00 };
+	memcpy(stream + stream_length, bad, sizeof(bad));
+	stream_length += sizeof(bad);
+	memcpy(stream + stream_length, text, sizeof(text) - 1);
+	stream_length += sizeof(text) - 1;
+	memcpy(sent_text + sent_text_length, bad + 1, sizeof(bad) - 1);
+	sent_text_length += sizeof(bad) - 1;
+	memcpy(sent_text + sent_text_length, text, sizeof(text) - 1);
+	sent_text_length += sizeof(text) - 1;
+
+	Decoder decoder = { .text = check_text, .packet_done = check_packet };
+	for (unsigned i = 0; i < stream_length; i++)
+	{
+		decode_byte(&decoder, stream[i]);
+	}
+	test_ok &= (text_checked == sent_text_length) && decoder.errors == 1;
+	printf("%u bytes, %u packets decoded, %u dropped by the sender, "
+		"%u rejected: %s\n", stream_length, decoder.packets,
+		telemetry_dropped(), decoder.errors, test_ok ? "ok" : "FAILED");
+	return test_ok ? 0 : 1;
+}
+
+int main(int argc, char *argv[])
+{
+	bool pass_text = false;
+	int opt;
+	while ((opt = getopt(argc, argv, "ts")) != -1)
+	{
+		switch (opt)
+		{
+			case 't':
+				pass_text = true;
+				break;
+			case 's':
+				return self_test();
+			default:
+				fprintf(stderr, "usage: %s [-t] [file|device]\n"
+					"       %s -s\n", argv[0], argv[0]);
+				return 2;
+		}
+	}
+	return decode_file(optind < argc ? argv[optind] : NULL, pass_text);
+}
@@ -0,0 +1,556 @@
+/*
+ * termcheck.c
+ *
+ * Author: Riley Stewart
+ *
+ * Checks what the game draws on the terminal, by running the game's own
+ * drawing code (AVRAssignment/game.c, startscrn.c, terminalio.c and friends)
+ * on the host and sending the serial output into a model of the terminal
+ * (vt100.h). Each check looks at the screen the model ends up with:
+ *
+ *   title        display_terminal_title() matches golden/title.txt
+ *   lines        draw_horizontal_line() and draw_vertical_line() reverse
+ *                exactly the cells asked for, and leave the normal mode on
+ *   board        every square of draw_terminal_board() has its theme colour,
+ *                in every level, theme and palette
+ *   moves        after every move and undo of a random walk, the rows the
+ *                game redraws (update_terminal_display()) leave the same
+ *                screen as a full redraw
+ *   headless     termview_render()'s diffs leave the same screen as a full
+ *                render
+ *   themes       change_theme() leaves the same screen as a full redraw in
+ *                the new theme, for every pair of themes and palettes
+ *
+ * Then the bytes and escape sequences each drawing operation sends are
+ * printed.
+ *
+ * Usage: termcheck [-u]   (-u rewrites golden/title.txt from the current
+ *                          title, after a deliberate change to it)
+ */
+
+#define _GNU_SOURCE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <unistd.h>
+#include "game.h"
+#include "levels.h"
+#include "ledmatrix.h"
+#include "anim.h"
+#include "theme.h"
+#include "termview.h"
+#include "terminalio.h"
+#include "startscrn.h"
+#include "serialio.h"
+#include "hal.h"
+#include "vt100.h"
+
+#define GOLDEN_TITLE	"golden/title.txt"
+
+// The part of the screen the title is compared over.
+#define TITLE_ROWS	(16)
+#define TITLE_COLS	(80)
+
+// The terminal rows the game board is drawn on (see draw_terminal_board()).
+#define BOARD_FIRST_ROW	(1)
+#define BOARD_LAST_ROW	(MATRIX_NUM_ROWS)
+
+#define WALK_MOVES	(3000)
+
+// The screen the serial output currently goes to.
+static Vt100 *screen;
+
+static void to_screen(uint8_t byte)
+{
+	vt_feed(screen, byte);
+}
+
+// ---- Costs ----
+
+typedef enum
+{
+	COST_TITLE,
+	COST_HORIZONTAL_LINE,
+	COST_VERTICAL_LINE,
+	COST_BOARD,
+	COST_ROW,
+	COST_MOVE,
+	COST_HEADLESS_FULL,
+	COST_HEADLESS_MOVE,
+	COST_THEME,
+	NUM_COSTS
+} CostType;
+
+static const char *const cost_names[NUM_COSTS] = {
+	"display_terminal_title",
+	"draw_horizontal_line (40 cols)",
+	"draw_vertical_line (16 rows)",
+	"draw_terminal_board",
+	"update_terminal_display",
+	"move, diagonal move or undo",
+	"termview_render, full",
+	"termview_render, per move",
+	"change_theme"
+};
+
+typedef struct
+{
+	unsigned calls;
+	uint32_t bytes;
+	uint32_t sequences;
+} Cost;
+
+static Cost costs[NUM_COSTS];
+
+// What the screen had been sent when an operation started.
+static uint32_t start_bytes;
+static uint32_t start_sequences;
+
+static void start_cost(void)
+{
+	start_bytes = screen->bytes;
+	start_sequences = screen->sequences;
+}
+
+static void end_cost(CostType type)
+{
+	costs[type].calls++;
+	costs[type].bytes += screen->bytes - start_bytes;
+	costs[type].sequences += screen->sequences - start_sequences;
+}
+
+// ---- Helpers ----
+
+static unsigned failures;
+
+static void fail(const char *check, const char *what)
+{
+	printf("  %s: %s\n", check, what);
+	failures++;
+}
+
+// Compares a block of two screens, and describes the first difference.
+static bool same_screen(const Vt100 *a, const Vt100 *b, int first_row,
+	int last_row, int first_col, int last_col, char *difference, int size)
+{
+	for (int row = first_row; row <= last_row; row++)
+	{
+		for (int col = first_col; col <= last_col; col++)
+		{
+			const VtCell *x = &a->cells[row][col];
+			const VtCell *y = &b->cells[row][col];
+			if (!vt_same_cell(x, y))
+			{
+				snprintf(difference, size, "row %d col %d is '%c' on %c, "
+					"should be '%c' on %c", row + 1, col + 1, x->ch,
+					vt_colour_key(vt_shown_background(x)), y->ch,
+					vt_colour_key(vt_shown_background(y)));
+				return false;
+			}
+		}
+	}
+	return true;
+}
+
+// Draws the whole board from scratch on a blank screen.
+static void draw_fresh_board(Vt100 *vt)
+{
+	Vt100 *previous = screen;
+	screen = vt;
+	vt_reset(vt);
+	draw_terminal_board();
+	screen = previous;
+}
+
+static void start_level(uint8_t level)
+{
+	LevelLayout layout;
+	decode_level(level, &layout);
+	initialise_game(&layout);
+	anim_cancel();
+}
+
+// Gets the background a theme item is drawn in, by drawing it.
+static VtAttributes item_attributes(ThemeItem item)
+{
+	static Vt100 scratch;
+	Vt100 *previous = screen;
+	screen = &scratch;
+	vt_reset(&scratch);
+	theme_set_background(item);
+	screen = previous;
+	return scratch.attributes;
+}
+
+// The theme item the terminal should show for a square, worked out from the
+// game state rather than by the game's own code.
+static ThemeItem expected_item(uint8_t object)
+{
+	if ((object & (BOX | TARGET)) == (BOX | TARGET))
+	{
+		return ITEM_DONE;
+	}
+	if (object & WALL)
+	{
+		return ITEM_WALL;
+	}
+	if (object & BOX)
+	{
+		return ITEM_BOX;
+	}
+	return (object & TARGET) ? ITEM_TARGET : ITEM_ROOM;
+}
+
+// ---- Checks ----
+
+// Points standard output (which startscrn.c writes to with putchar(), as
+// the board's stdout is the serial port) at the serial port stand-in.
+static ssize_t write_serial(void *cookie, const char *data, size_t size)
+{
+	(void)cookie;
+	for (size_t i = 0; i < size; i++)
+	{
+		serial_put_char(data[i]);
+	}
+	return (ssize_t)size;
+}
+
+static void check_title(bool update)
+{
+	static Vt100 vt;
+	static char dump[TITLE_ROWS * (TITLE_COLS + 1) + 1];
+	static char golden[sizeof(dump) + 1];
+
+	screen = &vt;
+	vt_reset(&vt);
+	fflush(stdout);
+	FILE *console = stdout;
+	stdout = fopencookie(NULL, "w",
+		(cookie_io_functions_t) { .write = write_serial });
+	setvbuf(stdout, NULL, _IONBF, 0);
+	start_cost();
+	display_terminal_title(3, 5);
+	end_cost(COST_TITLE);
+	fclose(stdout);
+	stdout = console;
+
+	vt_dump(&vt, 0, TITLE_ROWS - 1, 0, TITLE_COLS - 1, dump, sizeof(dump));
+	if (update)
+	{
+		FILE *file = fopen(GOLDEN_TITLE, "w");
+		if (!file || fputs(dump, file) < 0 || fclose(file) != 0)
+		{
+			fail("title", "could not write " GOLDEN_TITLE);
+		}
+		return;
+	}
+	FILE *file = fopen(GOLDEN_TITLE, "r");
+	size_t length = file ? fread(golden, 1, sizeof(golden) - 1, file) : 0;
+	if (file)
+	{
+		fclose(file);
+	}
+	golden[length] = '\0';
+	if (strcmp(dump, golden) != 0)
+	{
+		fail("title", "different from " GOLDEN_TITLE ", the screen is:");
+		fputs(dump, stdout);
+	}
+	if (vt.unknown_sequences)
+	{
+		fail("title", "sent escape sequences the terminal model does not know");
+	}
+}
+
+static void check_lines(void)
+{
+	static Vt100 vt;
+	screen = &vt;
+	vt_reset(&vt);
+	start_cost();
+	draw_horizontal_line(5, 10, 49);
+	end_cost(COST_HORIZONTAL_LINE);
+	start_cost();
+	draw_vertical_line(60, 3, 18);
+	end_cost(COST_VERTICAL_LINE);
+
+	for (int row = 0; row < VT_ROWS; row++)
+	{
+		for (int col = 0; col < VT_COLS; col++)
+		{
+			bool on_line = (row == 5 && col >= 10 && col <= 49)
+				|| (col == 60 && row >= 3 && row <= 18);
+			const VtCell *cell = &vt.cells[row][col];
+			bool reversed = (cell->attributes.flags & VT_REVERSE);
+			if (on_line != reversed || (on_line && cell->ch != ' '))
+			{
+				char what[64];
+				snprintf(what, sizeof(what), "row %d col %d is %s", row + 1,
+					col + 1, on_line ? "not on the line" : "drawn on");
+				fail("lines", what);
+				return;
+			}
+		}
+	}
+	if (vt.attributes.flags != 0)
+	{
+		fail("lines", "left the terminal in reverse video");
+	}
+}
+
+static void check_board(void)
+{
+	static Vt100 vt;
+	for (Theme theme = 0; theme < NUM_THEMES; theme++)
+	{
+		for (TerminalPalette palette = 0; palette < NUM_PALETTES; palette++)
+		{
+			theme_select(theme, palette);
+			for (uint8_t level = 1; level <= NUM_LEVELS; level++)
+			{
+				start_level(level);
+				LevelLayout state;
+				get_game_state(&state);
+				screen = &vt;
+				vt_reset(&vt);
+				start_cost();
+				draw_terminal_board();
+				end_cost(COST_BOARD);
+
+				// Column 0 of the board is not drawn; the rest are three
+				// characters wide, starting at terminal column 1.
+				for (uint8_t row = 0; row < MATRIX_NUM_ROWS; row++)
+				{
+					for (uint8_t col = 1; col < MATRIX_NUM_COLUMNS; col++)
+					{
+						VtAttributes expected = item_attributes(
+							expected_item(state.board[row][col]));
+						for (int i = 0; i < 3; i++)
+						{
+							const VtCell *cell = &vt.cells[MATRIX_NUM_ROWS - row]
+								[1 + 3 * (col - 1) + i];
+							if (cell->ch != ' '
+								|| cell->attributes.background != expected.background)
+							{
+								char what[80];
+								snprintf(what, sizeof(what), "theme %d palette %d "
+									"level %u: square (%u,%u) has the wrong colour",
+									theme, palette, level, row, col);
+								fail("board", what);
+								return;
+							}
+						}
+					}
+				}
+				if (vt.attributes.background != VT_DEFAULT)
+				{
+					fail("board", "left a background colour on");
+					return;
+				}
+				for (uint8_t row = 0; row < MATRIX_NUM_ROWS; row++)
+				{
+					start_cost();
+					update_terminal_display(row, MATRIX_NUM_ROWS - row, 1);
+					end_cost(COST_ROW);
+				}
+			}
+		}
+	}
+	theme_select(THEME_CLASSIC, PALETTE_16);
+}
+
+// A random move, diagonal move or undo, as the player could make.
+static void random_move(void)
+{
+	static const int8_t directions[4][2] = { { 1, 0 }, { -1, 0 }, { 0, 1 },
+		{ 0, -1 } };
+	int choice = rand() % 10;
+	if (choice < 6)
+	{
+		const int8_t *delta = directions[choice % 4];
+		move_player(delta[0], delta[1]);
+	}
+	else if (choice < 9)
+	{
+		// The diagonal moves, as project.c makes them.
+		int8_t delta_row = (rand() % 2) ? 1 : -1;
+		int8_t delta_col = (rand() % 2) ? 1 : -1;
+		move_diagonal(0, delta_col, delta_row, 0);
+	}
+	else
+	{
+		undo_move();
+	}
+	anim_finish();
+}
+
+static void check_moves(void)
+{
+	static Vt100 live;
+	static Vt100 fresh;
+	for (uint8_t level = 1; level <= NUM_LEVELS; level++)
+	{
+		screen = &live;
+		vt_reset(&live);
+		srand(level);
+		start_level(level);
+		for (unsigned i = 0; i < WALK_MOVES; i++)
+		{
+			// Blocked moves count too, with the message they show.
+			start_cost();
+			random_move();
+			end_cost(COST_MOVE);
+
+			draw_fresh_board(&fresh);
+			char difference[96];
+			if (!same_screen(&live, &fresh, BOARD_FIRST_ROW, BOARD_LAST_ROW, 0,
+				VT_COLS - 1, difference, sizeof(difference)))
+			{
+				char what[160];
+				snprintf(what, sizeof(what), "level %u, move %u: %s", level,
+					i + 1, difference);
+				fail("moves", what);
+				break;
+			}
+		}
+	}
+}
+
+static void check_headless(void)
+{
+	static Vt100 live;
+	static Vt100 fresh;
+	ledmatrix_set_headless(true);
+	for (uint8_t level = 1; level <= NUM_LEVELS; level++)
+	{
+		screen = &live;
+		vt_reset(&live);
+		srand(level);
+		start_level(level);
+		termview_invalidate();
+		termview_set_status(0, 0);
+		start_cost();
+		termview_render();
+		end_cost(COST_HEADLESS_FULL);
+		for (unsigned i = 0; i < WALK_MOVES; i++)
+		{
+			random_move();
+			hal_time += 1000;
+			screen = &live;
+			termview_set_status((uint16_t)i, (uint16_t)(hal_time / 1000));
+			start_cost();
+			termview_render();
+			end_cost(COST_HEADLESS_MOVE);
+
+			screen = &fresh;
+			vt_reset(&fresh);
+			termview_invalidate();
+			termview_render();
+			char difference[96];
+			if (!same_screen(&live, &fresh, TERMVIEW_ROW,
+				TERMVIEW_STATUS_ROW, 0, VT_COLS - 1, difference,
+				sizeof(difference)))
+			{
+				char what[160];
+				snprintf(what, sizeof(what), "level %u, move %u: %s", level,
+					i + 1, difference);
+				fail("headless", what);
+				break;
+			}
+		}
+	}
+	ledmatrix_set_headless(false);
+}
+
+static void check_themes(void)
+{
+	static Vt100 live;
+	static Vt100 fresh;
+	for (int from = 0; from < NUM_THEMES * NUM_PALETTES; from++)
+	{
+		for (int to = 0; to < NUM_THEMES * NUM_PALETTES; to++)
+		{
+			for (uint8_t level = 1; level <= NUM_LEVELS; level++)
+			{
+				theme_select(from / NUM_PALETTES, from % NUM_PALETTES);
+				start_level(level);
+				// Some moves first, so there are boxes on targets.
+				srand(level);
+				screen = &live;
+				vt_reset(&live);
+				draw_terminal_board();
+				for (int i = 0; i < 200; i++)
+				{
+					random_move();
+				}
+				start_cost();
+				change_theme(to / NUM_PALETTES, to % NUM_PALETTES);
+				end_cost(COST_THEME);
+
+				draw_fresh_board(&fresh);
+				char difference[96];
+				if (!same_screen(&live, &fresh, BOARD_FIRST_ROW, BOARD_LAST_ROW,
+					0, VT_COLS - 1, difference, sizeof(difference)))
+				{
+					char what[160];
+					snprintf(what, sizeof(what), "theme/palette %d to %d, "
+						"level %u: %s", from, to, level, difference);
+					fail("themes", what);
+					theme_select(THEME_CLASSIC, PALETTE_16);
+					return;
+				}
+			}
+		}
+	}
+	theme_select(THEME_CLASSIC, PALETTE_16);
+}
+
+static void run(const char *name, void (*check)(void))
+{
+	unsigned before = failures;
+	check();
+	printf("%-9s %s\n", name, failures == before ? "ok" : "FAILED");
+}
+
+int main(int argc, char *argv[])
+{
+	bool update = false;
+	int opt;
+	while ((opt = getopt(argc, argv, "u")) != -1)
+	{
+		if (opt != 'u')
+		{
+			fprintf(stderr, "usage: %s [-u]\n", argv[0]);
+			return 2;
+		}
+		update = true;
+	}
+	hal_serial_sink = to_screen;
+
+	unsigned before = failures;
+	check_title(update);
+	printf("%-9s %s\n", "title", update ? "written to " GOLDEN_TITLE
+		: (failures == before ? "ok" : "FAILED"));
+	run("lines", check_lines);
+	run("board", check_board);
+	run("moves", check_moves);
+	run("headless", check_headless);
+	run("themes", check_themes);
+
+	printf("\n%-32s %7s %10s %10s\n", "operation", "calls", "bytes/call",
+		"escapes/call");
+	for (CostType type = 0; type < NUM_COSTS; type++)
+	{
+		const Cost *cost = &costs[type];
+		if (cost->calls)
+		{
+			printf("%-32s %7u %10.1f %10.1f\n", cost_names[type], cost->calls,
+				(double)cost->bytes / cost->calls,
+				(double)cost->sequences / cost->calls);
+		}
+	}
+	return failures ? 1 : 0;
+}
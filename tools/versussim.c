@@ -0,0 +1,365 @@
+/*
+ * versussim.c
+ *
+ * Author: Riley Stewart
+ *
+ * Host stand-in for a board in versus mode, using the same protocol code
+ * as the boards (AVRAssignment/versus.c).
+ *
+ * Usage: versussim -t [-n moves] [-l percent]
+ *            Self test. Two simulated players race over a pseudo-terminal
+ *            pair, making random moves and undos, with the given percentage
+ *            of bytes lost. Afterwards each side's copy of its opponent is
+ *            checked against the opponent's real position, and the worst
+ *            latency is checked against one frame (ANIM_FRAME_TIME).
+ *        versussim device
+ *            Race a real board over a serial port (e.g. a USB serial adapter
+ *            on the board's PD2/PD3 pins), making a random move every 300ms
+ *            and printing the board's progress.
+ */
+
+#define _XOPEN_SOURCE 600
+#define _DEFAULT_SOURCE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <termios.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/wait.h>
+#include "game.h"
+#include "levels.h"
+#include "anim.h"
+#include "link.h"
+#include "link_pty.h"
+#include "versus.h"
+
+// Time a simulated player keeps answering after its last move, so lost
+// frames at the end can be found and resent (a ping every second reveals
+// them, and a snapshot request is resent every second).
+#define SETTLE_TIME	(3500)
+
+// What one simulated player reports back to the self test.
+typedef struct
+{
+	VersusOpponent own;
+	VersusOpponent opponent;
+	VersusStats stats;
+	unsigned moves;
+	unsigned undos;
+} Report;
+
+static uint32_t now_ms(void)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint32_t)(ts.tv_sec * 1000 + ts.tv_nsec / 1000000);
+}
+
+static bool blocked(const LevelLayout *state, int row, int col)
+{
+	return state->board[WRAP_ROW(row)][WRAP_COL(col)] & (WALL | BOX);
+}
+
+// Makes a move with the same rules as the game: boxes can be pushed but not
+// moved diagonally, and a diagonal move needs one of the two ways round to
+// be clear. Returns whether the move was made.
+static bool make_move(LevelLayout *state, int8_t delta_row, int8_t delta_col)
+{
+	uint8_t row = WRAP_ROW(state->player_row + delta_row);
+	uint8_t col = WRAP_COL(state->player_col + delta_col);
+	uint8_t object = state->board[row][col];
+	if (object & WALL)
+	{
+		return false;
+	}
+	if (delta_row && delta_col)
+	{
+		if ((object & BOX)
+			|| (blocked(state, state->player_row + delta_row, state->player_col)
+			&& blocked(state, state->player_row, state->player_col + delta_col)))
+		{
+			return false;
+		}
+	}
+	else if (object & BOX)
+	{
+		if (blocked(state, row + delta_row, col + delta_col))
+		{
+			return false;
+		}
+		state->board[row][col] &= ~BOX;
+		state->board[WRAP_ROW(row + delta_row)][WRAP_COL(col + delta_col)] |= BOX;
+	}
+	state->player_row = row;
+	state->player_col = col;
+	return true;
+}
+
+// Describes a position the same way a VersusOpponent does.
+static void describe(const LevelLayout *state, uint8_t level, uint8_t steps,
+	VersusOpponent *out)
+{
+	memset(out, 0, sizeof(*out));
+	out->level = level;
+	out->steps = steps > 127 ? 127 : steps;
+	out->player_row = state->player_row;
+	out->player_col = state->player_col;
+	out->in_sync = true;
+	for (uint8_t row = 0; row < MATRIX_NUM_ROWS; row++)
+	{
+		for (uint8_t col = 0; col < MATRIX_NUM_COLUMNS; col++)
+		{
+			if (state->board[row][col] & BOX)
+			{
+				out->boxes[row] |= (1U << col);
+			}
+			if (state->board[row][col] & TARGET)
+			{
+				out->targets[row] |= (1U << col);
+			}
+		}
+	}
+}
+
+// Plays random moves (and some undos) on level 1 over the link, one every
+// move_time ms, and fills in a report when done.
+static void play(unsigned moves, unsigned move_time, bool print, Report *report)
+{
+	static const int8_t directions[8][2] = { { 1, 0 }, { -1, 0 }, { 0, 1 },
+		{ 0, -1 }, { 1, 1 }, { 1, -1 }, { -1, 1 }, { -1, -1 } };
+	LevelLayout history[64];
+	unsigned history_size = 0;
+	LevelLayout state;
+	uint8_t steps = 0;
+	uint32_t last_move = now_ms();
+	uint32_t finish_time = 0;
+
+	memset(report, 0, sizeof(*report));
+	decode_level(1, &state);
+	versus_start(1);
+	while (finish_time == 0 || now_ms() - finish_time < SETTLE_TIME)
+	{
+		uint32_t now = now_ms();
+		uint8_t events = versus_update(now);
+		if (events & VERSUS_EVENT_SNAPSHOT)
+		{
+			versus_send_snapshot(&state, steps);
+		}
+		if (print && events)
+		{
+			const VersusOpponent *opponent = versus_opponent();
+			printf("opponent: level %u, %3u steps, %u boxes left%s, "
+				"latency %u ms\n", opponent->level, opponent->steps,
+				versus_boxes_left(), opponent->in_sync ? "" : " (catching up)",
+				versus_stats()->latency);
+			fflush(stdout);
+		}
+
+		if (report->moves < moves && now - last_move >= move_time)
+		{
+			last_move = now;
+			if (history_size > 0 && rand() % 10 == 0)
+			{
+				state = history[--history_size];
+				steps--;
+				report->undos++;
+				versus_send_snapshot(&state, steps);
+			}
+			else
+			{
+				const int8_t *delta = directions[rand() % 8];
+				LevelLayout before = state;
+				if (make_move(&state, delta[0], delta[1]))
+				{
+					if (history_size == 64)
+					{
+						memmove(history, history + 1, sizeof(history[0]) * 63);
+						history_size--;
+					}
+					history[history_size++] = before;
+					steps += (delta[0] && delta[1]) ? 2 : 1;
+					versus_send_move(delta[0], delta[1]);
+				}
+			}
+			report->moves++;
+			if (report->moves == moves)
+			{
+				// Stop losing bytes, so the position can be recovered.
+				link_drop_percent = 0;
+				finish_time = now;
+			}
+		}
+		usleep(200);
+	}
+	describe(&state, 1, steps, &report->own);
+	report->opponent = *versus_opponent();
+	report->stats = *versus_stats();
+}
+
+static bool same_position(const VersusOpponent *a, const VersusOpponent *b)
+{
+	return a->in_sync == b->in_sync && a->level == b->level
+		&& a->steps == b->steps && a->player_row == b->player_row
+		&& a->player_col == b->player_col
+		&& memcmp(a->boxes, b->boxes, sizeof(a->boxes)) == 0;
+}
+
+// Runs one simulated player on a file descriptor in a child process, and
+// returns a pipe its report can be read from.
+static int start_player(int fd, unsigned seed, unsigned moves, unsigned drop)
+{
+	int report_pipe[2];
+	if (pipe(report_pipe) != 0)
+	{
+		perror("pipe");
+		exit(2);
+	}
+	if (fork() == 0)
+	{
+		Report report;
+		close(report_pipe[0]);
+		srand(seed);
+		link_fd = fd;
+		link_drop_percent = drop;
+		fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+		play(moves, 2, false, &report);
+		if (write(report_pipe[1], &report, sizeof(report)) != sizeof(report))
+		{
+			_exit(2);
+		}
+		_exit(0);
+	}
+	close(report_pipe[1]);
+	return report_pipe[0];
+}
+
+static bool read_report(int fd, Report *report)
+{
+	return read(fd, report, sizeof(*report)) == sizeof(*report);
+}
+
+static void print_report(const char *name, const Report *report)
+{
+	printf("%s: %u moves (%u undos), %u frames received, %u lost, "
+		"%u not sent, latency %u ms (worst %u ms)\n", name, report->moves,
+		report->undos, report->stats.frames_received, report->stats.frames_lost,
+		report->stats.frames_dropped, report->stats.latency,
+		report->stats.max_latency);
+}
+
+static int self_test(unsigned moves, unsigned drop)
+{
+	int master = posix_openpt(O_RDWR | O_NOCTTY);
+	if (master < 0 || grantpt(master) != 0 || unlockpt(master) != 0)
+	{
+		perror("posix_openpt");
+		return 2;
+	}
+	int slave = open(ptsname(master), O_RDWR | O_NOCTTY);
+	if (slave < 0)
+	{
+		perror(ptsname(master));
+		return 2;
+	}
+	// Raw mode, so the bytes go through unchanged (no echo, no CR/LF).
+	struct termios tio;
+	tcgetattr(slave, &tio);
+	cfmakeraw(&tio);
+	tcsetattr(slave, TCSANOW, &tio);
+
+	printf("racing %u moves each over %s, losing %u%% of bytes\n", moves,
+		ptsname(master), drop);
+	fflush(stdout);
+	int report_a = start_player(master, 1, moves, drop);
+	int report_b = start_player(slave, 2, moves, drop);
+	Report a;
+	Report b;
+	bool ok = read_report(report_a, &a) && read_report(report_b, &b);
+	while (wait(NULL) > 0)
+	{
+	}
+	if (!ok)
+	{
+		printf("a player did not report\n");
+		return 1;
+	}
+	print_report("A", &a);
+	print_report("B", &b);
+
+	bool a_knows_b = same_position(&a.opponent, &b.own);
+	bool b_knows_a = same_position(&b.opponent, &a.own);
+	printf("A's copy of B: %s\n", a_knows_b ? "matches" : "WRONG");
+	printf("B's copy of A: %s\n", b_knows_a ? "matches" : "WRONG");
+	uint16_t worst = a.stats.max_latency > b.stats.max_latency
+		? a.stats.max_latency : b.stats.max_latency;
+	bool fast = worst < ANIM_FRAME_TIME;
+	printf("worst latency %u ms: %s one frame (%u ms)\n", worst,
+		fast ? "under" : "NOT under", ANIM_FRAME_TIME);
+	return (a_knows_b && b_knows_a && fast) ? 0 : 1;
+}
+
+static int race_device(const char *device)
+{
+	int fd = open(device, O_RDWR | O_NOCTTY | O_NONBLOCK);
+	if (fd < 0)
+	{
+		perror(device);
+		return 2;
+	}
+	struct termios tio;
+	tcgetattr(fd, &tio);
+	cfmakeraw(&tio);
+	cfsetispeed(&tio, B38400);
+	cfsetospeed(&tio, B38400);
+	tcsetattr(fd, TCSANOW, &tio);
+	link_fd = fd;
+	srand((unsigned)time(NULL));
+
+	Report report;
+	play(~0U, 300, true, &report);
+	return 0;
+}
+
+int main(int argc, char *argv[])
+{
+	unsigned moves = 2000;
+	unsigned drop = 0;
+	bool test = false;
+	int opt;
+	while ((opt = getopt(argc, argv, "tn:l:")) != -1)
+	{
+		switch (opt)
+		{
+			case 't':
+				test = true;
+				break;
+			case 'n':
+				moves = (unsigned)atoi(optarg);
+				break;
+			case 'l':
+				drop = (unsigned)atoi(optarg);
+				break;
+			default:
+				fprintf(stderr, "usage: %s -t [-n moves] [-l percent]\n"
+					"       %s device\n", argv[0], argv[0]);
+				return 2;
+		}
+	}
+	if (test)
+	{
+		return self_test(moves, drop);
+	}
+	if (optind < argc)
+	{
+		return race_device(argv[optind]);
+	}
+	fprintf(stderr, "usage: %s -t [-n moves] [-l percent]\n"
+		"       %s device\n", argv[0], argv[0]);
+	return 2;
+}
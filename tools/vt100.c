@@ -0,0 +1,399 @@
+/*
+ * vt100.c
+ *
+ * Author: Riley Stewart
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include "vt100.h"
+
+enum
+{
+	STATE_TEXT,
+	STATE_ESCAPE,	// After ESC
+	STATE_CSI		// After ESC [
+};
+
+static const VtAttributes default_attributes = { VT_DEFAULT, VT_DEFAULT, 0 };
+
+static void clear_cells(Vt100 *vt, int row, int first_col, int last_col)
+{
+	for (int col = first_col; col <= last_col; col++)
+	{
+		vt->cells[row][col].ch = ' ';
+		// Erased cells take the current background, as on xterm.
+		vt->cells[row][col].attributes = default_attributes;
+		vt->cells[row][col].attributes.background = vt->attributes.background;
+	}
+}
+
+void vt_reset(Vt100 *vt)
+{
+	memset(vt, 0, sizeof(*vt));
+	vt->attributes = default_attributes;
+	for (int row = 0; row < VT_ROWS; row++)
+	{
+		clear_cells(vt, row, 0, VT_COLS - 1);
+	}
+	vt->scroll_bottom = VT_ROWS - 1;
+	vt->cursor_visible = true;
+}
+
+// Scrolls the scroll region up (lines move up, a blank line at the bottom)
+// or down.
+static void scroll(Vt100 *vt, bool up)
+{
+	if (up)
+	{
+		memmove(vt->cells[vt->scroll_top], vt->cells[vt->scroll_top + 1],
+			sizeof(vt->cells[0]) * (vt->scroll_bottom - vt->scroll_top));
+		clear_cells(vt, vt->scroll_bottom, 0, VT_COLS - 1);
+	}
+	else
+	{
+		memmove(vt->cells[vt->scroll_top + 1], vt->cells[vt->scroll_top],
+			sizeof(vt->cells[0]) * (vt->scroll_bottom - vt->scroll_top));
+		clear_cells(vt, vt->scroll_top, 0, VT_COLS - 1);
+	}
+}
+
+static void line_feed(Vt100 *vt)
+{
+	if (vt->row == vt->scroll_bottom)
+	{
+		scroll(vt, true);
+	}
+	else if (vt->row < VT_ROWS - 1)
+	{
+		vt->row++;
+	}
+}
+
+static void reverse_line_feed(Vt100 *vt)
+{
+	if (vt->row == vt->scroll_top)
+	{
+		scroll(vt, false);
+	}
+	else if (vt->row > 0)
+	{
+		vt->row--;
+	}
+}
+
+static int clamp(int value, int low, int high)
+{
+	return value < low ? low : (value > high ? high : value);
+}
+
+static int param(const Vt100 *vt, int index, int fallback)
+{
+	return (index < vt->num_params && vt->params[index] > 0)
+		? vt->params[index] : fallback;
+}
+
+// Reads an extended colour (5;n or 2;r;g;b) starting at params[*index].
+static int32_t extended_colour(const Vt100 *vt, int *index)
+{
+	if (*index + 1 < vt->num_params && vt->params[*index] == 5)
+	{
+		*index += 1;
+		return vt->params[*index] & 0xFF;
+	}
+	if (*index + 3 < vt->num_params && vt->params[*index] == 2)
+	{
+		int32_t colour = VT_RGB(vt->params[*index + 1] & 0xFF,
+			vt->params[*index + 2] & 0xFF, vt->params[*index + 3] & 0xFF);
+		*index += 3;
+		return colour;
+	}
+	return VT_DEFAULT;
+}
+
+static void select_graphic_rendition(Vt100 *vt)
+{
+	if (vt->num_params == 0)
+	{
+		vt->attributes = default_attributes;
+		return;
+	}
+	for (int i = 0; i < vt->num_params; i++)
+	{
+		int p = vt->params[i];
+		VtAttributes *a = &vt->attributes;
+		switch (p)
+		{
+			case 0: *a = default_attributes; break;
+			case 1: a->flags |= VT_BRIGHT; break;
+			case 2: a->flags |= VT_DIM; break;
+			case 4: a->flags |= VT_UNDERSCORE; break;
+			case 5: a->flags |= VT_BLINK; break;
+			case 7: a->flags |= VT_REVERSE; break;
+			case 8: a->flags |= VT_HIDDEN; break;
+			case 38: i++; a->foreground = extended_colour(vt, &i); break;
+			case 39: a->foreground = VT_DEFAULT; break;
+			case 48: i++; a->background = extended_colour(vt, &i); break;
+			case 49: a->background = VT_DEFAULT; break;
+			default:
+				if (p >= 30 && p <= 37)
+				{
+					a->foreground = p - 30;
+				}
+				else if (p >= 40 && p <= 47)
+				{
+					a->background = p - 40;
+				}
+				else if (p >= 90 && p <= 97)
+				{
+					a->foreground = p - 90 + 8;
+				}
+				else if (p >= 100 && p <= 107)
+				{
+					a->background = p - 100 + 8;
+				}
+				else
+				{
+					vt->unknown_sequences++;
+				}
+				break;
+		}
+	}
+}
+
+static void control_sequence(Vt100 *vt, uint8_t final)
+{
+	vt->sequences++;
+	if (vt->private_mode)
+	{
+		if (final == 'l' || final == 'h')
+		{
+			if (param(vt, 0, 0) == 25)
+			{
+				vt->cursor_visible = (final == 'h');
+				return;
+			}
+		}
+		vt->unknown_sequences++;
+		return;
+	}
+	switch (final)
+	{
+		case 'A':
+			vt->row = clamp(vt->row - param(vt, 0, 1), 0, VT_ROWS - 1);
+			break;
+		case 'B':
+			vt->row = clamp(vt->row + param(vt, 0, 1), 0, VT_ROWS - 1);
+			break;
+		case 'C':
+			vt->col = clamp(vt->col + param(vt, 0, 1), 0, VT_COLS - 1);
+			break;
+		case 'D':
+			vt->col = clamp(vt->col - param(vt, 0, 1), 0, VT_COLS - 1);
+			break;
+		case 'H':
+		case 'f':
+			vt->row = clamp(param(vt, 0, 1) - 1, 0, VT_ROWS - 1);
+			vt->col = clamp(param(vt, 1, 1) - 1, 0, VT_COLS - 1);
+			break;
+		case 'J':
+			if (param(vt, 0, 0) == 2)
+			{
+				for (int row = 0; row < VT_ROWS; row++)
+				{
+					clear_cells(vt, row, 0, VT_COLS - 1);
+				}
+			}
+			else
+			{
+				vt->unknown_sequences++;
+			}
+			break;
+		case 'K':
+			if (param(vt, 0, 0) == 0)
+			{
+				clear_cells(vt, vt->row, vt->col, VT_COLS - 1);
+			}
+			else
+			{
+				vt->unknown_sequences++;
+			}
+			break;
+		case 'm':
+			select_graphic_rendition(vt);
+			break;
+		case 'r':
+			if (vt->num_params == 0)
+			{
+				vt->scroll_top = 0;
+				vt->scroll_bottom = VT_ROWS - 1;
+			}
+			else
+			{
+				vt->scroll_top = clamp(param(vt, 0, 1) - 1, 0, VT_ROWS - 1);
+				vt->scroll_bottom = clamp(param(vt, 1, VT_ROWS) - 1,
+					vt->scroll_top, VT_ROWS - 1);
+			}
+			vt->row = 0;
+			vt->col = 0;
+			break;
+		default:
+			vt->unknown_sequences++;
+			break;
+	}
+}
+
+void vt_feed(Vt100 *vt, uint8_t byte)
+{
+	vt->bytes++;
+	switch (vt->state)
+	{
+		case STATE_ESCAPE:
+			vt->state = STATE_TEXT;
+			if (byte == '[')
+			{
+				vt->state = STATE_CSI;
+				vt->num_params = 0;
+				vt->private_mode = false;
+				memset(vt->params, 0, sizeof(vt->params));
+				return;
+			}
+			vt->sequences++;
+			if (byte == 'M')
+			{
+				reverse_line_feed(vt);
+			}
+			else if (byte == 'D')
+			{
+				line_feed(vt);
+			}
+			else
+			{
+				vt->unknown_sequences++;
+			}
+			return;
+		case STATE_CSI:
+			if (byte == '?' && vt->num_params == 0)
+			{
+				vt->private_mode = true;
+			}
+			else if (byte >= '0' && byte <= '9')
+			{
+				if (vt->num_params == 0)
+				{
+					vt->num_params = 1;
+				}
+				int *p = &vt->params[vt->num_params - 1];
+				*p = *p * 10 + (byte - '0');
+			}
+			else if (byte == ';')
+			{
+				if (vt->num_params == 0)
+				{
+					vt->num_params = 1;
+				}
+				if (vt->num_params < 16)
+				{
+					vt->num_params++;
+				}
+			}
+			else
+			{
+				vt->state = STATE_TEXT;
+				control_sequence(vt, byte);
+			}
+			return;
+		default:
+			break;
+	}
+
+	switch (byte)
+	{
+		case 0x1B:
+			vt->state = STATE_ESCAPE;
+			break;
+		case '\r':
+			vt->col = 0;
+			break;
+		case '\n':
+			line_feed(vt);
+			break;
+		case '\b':
+			if (vt->col > 0)
+			{
+				vt->col--;
+			}
+			break;
+		default:
+			if (byte < ' ')
+			{
+				break;
+			}
+			if (vt->col >= VT_COLS)
+			{
+				// Wrap onto the next line.
+				vt->col = 0;
+				line_feed(vt);
+			}
+			vt->cells[vt->row][vt->col].ch = (char)byte;
+			vt->cells[vt->row][vt->col].attributes = vt->attributes;
+			vt->col++;
+			break;
+	}
+}
+
+int32_t vt_shown_background(const VtCell *cell)
+{
+	if (cell->attributes.flags & VT_REVERSE)
+	{
+		// Reverse video shows the foreground colour (white by default)
+		// behind the text.
+		return cell->attributes.foreground == VT_DEFAULT
+			? 7 : cell->attributes.foreground;
+	}
+	return cell->attributes.background;
+}
+
+bool vt_same_cell(const VtCell *a, const VtCell *b)
+{
+	return a->ch == b->ch
+		&& a->attributes.foreground == b->attributes.foreground
+		&& a->attributes.background == b->attributes.background
+		&& a->attributes.flags == b->attributes.flags;
+}
+
+char vt_colour_key(int32_t colour)
+{
+	static const char keys[] = "krgybmcwKRGYBMCW";
+	if (colour == VT_DEFAULT)
+	{
+		return '.';
+	}
+	if (colour >= 0 && colour < 16)
+	{
+		return keys[colour];
+	}
+	return '#';
+}
+
+void vt_dump(const Vt100 *vt, int first_row, int last_row, int first_col,
+	int last_col, char *out, int size)
+{
+	int used = 0;
+	for (int row = first_row; row <= last_row; row++)
+	{
+		for (int col = first_col; col <= last_col && used < size - 2; col++)
+		{
+			const VtCell *cell = &vt->cells[row][col];
+			int32_t background = vt_shown_background(cell);
+			out[used++] = (background != VT_DEFAULT && cell->ch == ' ')
+				? vt_colour_key(background) : cell->ch;
+		}
+		if (used < size - 1)
+		{
+			out[used++] = '\n';
+		}
+	}
+	out[used] = '\0';
+}
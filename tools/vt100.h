@@ -0,0 +1,105 @@
+/*
+ * vt100.h
+ *
+ * Author: Riley Stewart
+ *
+ * A small model of a VT100/xterm screen, for checking what the game draws
+ * on the terminal without a real terminal. It understands the escape
+ * sequences the game sends (cursor movement, erasing, scroll regions and
+ * colours, including 256 colour and 24-bit colour) and counts everything
+ * it is sent.
+ */
+
+#ifndef VT100_H_
+#define VT100_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#define VT_ROWS	(40)
+#define VT_COLS	(100)
+
+// Colours are stored as: VT_DEFAULT, 0-255 (the xterm palette, where 0-7
+// are the basic colours and 8-15 their bright versions), or VT_RGB(r, g, b).
+#define VT_DEFAULT		(-1)
+#define VT_RGB(r, g, b)	(0x1000000 | (r) << 16 | (g) << 8 | (b))
+
+#define VT_BRIGHT		(1 << 0)
+#define VT_DIM			(1 << 1)
+#define VT_UNDERSCORE	(1 << 2)
+#define VT_BLINK		(1 << 3)
+#define VT_REVERSE		(1 << 4)
+#define VT_HIDDEN		(1 << 5)
+
+typedef struct
+{
+	int32_t foreground;
+	int32_t background;
+	uint8_t flags;
+} VtAttributes;
+
+typedef struct
+{
+	char ch;
+	VtAttributes attributes;
+} VtCell;
+
+typedef struct
+{
+	VtCell cells[VT_ROWS][VT_COLS];
+	int row;
+	int col;
+	VtAttributes attributes;
+	int scroll_top;
+	int scroll_bottom;
+	bool cursor_visible;
+
+	// Parser state.
+	int state;
+	int params[16];
+	int num_params;
+	bool private_mode;
+
+	// Counts of what was received.
+	uint32_t bytes;
+	uint32_t sequences;
+	uint32_t unknown_sequences;
+} Vt100;
+
+/// <summary>
+/// Resets a screen to blank, with the cursor at the top left.
+/// </summary>
+void vt_reset(Vt100 *vt);
+
+/// <summary>
+/// Sends a byte to a screen.
+/// </summary>
+void vt_feed(Vt100 *vt, uint8_t byte);
+
+/// <summary>
+/// Gets the background colour a cell is shown in, taking reverse video
+/// into account.
+/// </summary>
+int32_t vt_shown_background(const VtCell *cell);
+
+/// <summary>
+/// Compares two cells, including their attributes.
+/// </summary>
+bool vt_same_cell(const VtCell *a, const VtCell *b);
+
+/// <summary>
+/// Writes part of a screen as text, one character per cell. Cells with a
+/// background colour are shown by the key character for their colour (see
+/// vt_colour_key()), other cells by their character.
+/// </summary>
+void vt_dump(const Vt100 *vt, int first_row, int last_row, int first_col,
+	int last_col, char *out, int size);
+
+/// <summary>
+/// Gets a single character standing for a background colour: '.' for the
+/// default, 'k' 'r' 'g' 'y' 'b' 'm' 'c' 'w' for the basic colours, capitals
+/// for bright ones and '#' for any other colour.
+/// </summary>
+char vt_colour_key(int32_t colour);
+
+#endif /* VT100_H_ */